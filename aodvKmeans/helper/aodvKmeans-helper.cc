@@ -19,10 +19,15 @@
  */
 #include "aodvKmeans-helper.h"
 #include "ns3/aodvKmeans-routing-protocol.h"
+#include "ns3/aodvKmeans-stats.h"
+#include "ns3/aodvKmeans-event-log.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/simulator.h"
 #include "ns3/node-list.h"
 #include "ns3/names.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-list-routing.h"
+#include <sstream>
 
 namespace ns3
 {
@@ -93,4 +98,223 @@ aodvKmeansHelper::AssignStreams (NodeContainer c, int64_t stream)
   return (currentStream - stream);
 }
 
+void
+aodvKmeansHelper::PrintStatsAllEvery (Time printInterval, Ptr<OutputStreamWrapper> stream, StatsFormat format)
+{
+  PrintStatsEvery (printInterval, NodeContainer::GetGlobal (), stream, format);
+}
+
+void
+aodvKmeansHelper::PrintStatsEvery (Time printInterval, NodeContainer nodes, Ptr<OutputStreamWrapper> stream,
+                                   StatsFormat format)
+{
+  if (format == STATS_CSV)
+    {
+      aodvKmeans::Stats::PrintCsvHeader (*stream->GetStream ());
+    }
+  Simulator::Schedule (printInterval, &aodvKmeansHelper::PrintStatsEveryImpl, printInterval, nodes, stream, format);
+}
+
+void
+aodvKmeansHelper::PrintStatsAllAt (Time printTime, Ptr<OutputStreamWrapper> stream, StatsFormat format)
+{
+  if (format == STATS_CSV)
+    {
+      aodvKmeans::Stats::PrintCsvHeader (*stream->GetStream ());
+    }
+  Simulator::Schedule (printTime, &aodvKmeansHelper::PrintStats, NodeContainer::GetGlobal (), stream, format);
+}
+
+void
+aodvKmeansHelper::PrintStats (NodeContainer nodes, Ptr<OutputStreamWrapper> stream, StatsFormat format)
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<aodvKmeans::Stats> stats = (*i)->GetObject<aodvKmeans::Stats> ();
+      if (stats == 0)
+        {
+          continue;
+        }
+      if (format == STATS_CSV)
+        {
+          stats->PrintCsv (*stream->GetStream (), (*i)->GetId ());
+        }
+      else
+        {
+          stats->PrintJson (*stream->GetStream (), (*i)->GetId ());
+        }
+    }
+}
+
+void
+aodvKmeansHelper::PrintStatsEveryImpl (Time printInterval, NodeContainer nodes, Ptr<OutputStreamWrapper> stream,
+                                       StatsFormat format)
+{
+  PrintStats (nodes, stream, format);
+  Simulator::Schedule (printInterval, &aodvKmeansHelper::PrintStatsEveryImpl, printInterval, nodes, stream, format);
+}
+
+void
+aodvKmeansHelper::PrintLatencyAllAt (Time printTime, Ptr<OutputStreamWrapper> stream)
+{
+  aodvKmeans::Stats::PrintLatencyHeader (*stream->GetStream ());
+  Simulator::Schedule (printTime, &aodvKmeansHelper::PrintLatency, NodeContainer::GetGlobal (), stream);
+}
+
+void
+aodvKmeansHelper::PrintLatency (NodeContainer nodes, Ptr<OutputStreamWrapper> stream)
+{
+  using aodvKmeans::Stats;
+  using aodvKmeans::LatencyHistogram;
+  LatencyHistogram all[Stats::LATENCY_KIND_COUNT][2][Stats::LATENCY_MAX_RETRIES + 1];
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<Stats> stats = (*i)->GetObject<Stats> ();
+      if (stats == 0)
+        {
+          continue;
+        }
+      std::ostringstream node;
+      node << (*i)->GetId ();
+      for (uint32_t k = 0; k < Stats::LATENCY_KIND_COUNT; k++)
+        {
+          for (uint32_t c = 0; c < 2; c++)
+            {
+              for (uint32_t r = 0; r <= Stats::LATENCY_MAX_RETRIES; r++)
+                {
+                  LatencyHistogram const & histogram = stats->GetLatency (Stats::LatencyKind (k), c, r);
+                  if (histogram.GetCount () > 0)
+                    {
+                      Stats::PrintLatencyRow (*stream->GetStream (), node.str (), Stats::LatencyKind (k), c, r, histogram);
+                      all[k][c][r].Merge (histogram);
+                    }
+                }
+            }
+        }
+    }
+  for (uint32_t k = 0; k < Stats::LATENCY_KIND_COUNT; k++)
+    {
+      for (uint32_t c = 0; c < 2; c++)
+        {
+          for (uint32_t r = 0; r <= Stats::LATENCY_MAX_RETRIES; r++)
+            {
+              if (all[k][c][r].GetCount () > 0)
+                {
+                  Stats::PrintLatencyRow (*stream->GetStream (), "all", Stats::LatencyKind (k), c, r, all[k][c][r]);
+                }
+            }
+        }
+    }
+}
+
+void
+aodvKmeansHelper::PrintEventsAllAt (Time printTime, Ptr<OutputStreamWrapper> stream)
+{
+  aodvKmeans::EventAccounting::PrintHeader (*stream->GetStream ());
+  Simulator::Schedule (printTime, &aodvKmeansHelper::PrintEvents, NodeContainer::GetGlobal (), stream);
+}
+
+void
+aodvKmeansHelper::PrintEvents (NodeContainer nodes, Ptr<OutputStreamWrapper> stream)
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<aodvKmeans::RoutingProtocol> routing = (*i)->GetObject<aodvKmeans::RoutingProtocol> ();
+      if (routing != 0)
+        {
+          routing->GetEventAccounting ().Print (*stream->GetStream (), (*i)->GetId ());
+        }
+    }
+}
+
+void
+aodvKmeansHelper::PrintQueueSamplesAllAt (Time printTime, Ptr<OutputStreamWrapper> stream)
+{
+  aodvKmeans::RequestQueue::PrintSamplesHeader (*stream->GetStream ());
+  Simulator::Schedule (printTime, &aodvKmeansHelper::PrintQueueSamples, NodeContainer::GetGlobal (), stream);
+}
+
+void
+aodvKmeansHelper::PrintQueueSamples (NodeContainer nodes, Ptr<OutputStreamWrapper> stream)
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<aodvKmeans::RoutingProtocol> routing = (*i)->GetObject<aodvKmeans::RoutingProtocol> ();
+      if (routing != 0)
+        {
+          routing->GetRequestQueue ().PrintSamples (*stream->GetStream (), (*i)->GetId ());
+        }
+    }
+}
+
+void
+aodvKmeansHelper::PrintMemoryUsageAllEvery (Time printInterval, Ptr<OutputStreamWrapper> stream)
+{
+  aodvKmeans::MemoryUsage::PrintHeader (*stream->GetStream ());
+  Simulator::Schedule (printInterval, &aodvKmeansHelper::PrintMemoryUsageEveryImpl, printInterval,
+                       NodeContainer::GetGlobal (), stream);
+}
+
+void
+aodvKmeansHelper::PrintMemoryUsageEveryImpl (Time printInterval, NodeContainer nodes, Ptr<OutputStreamWrapper> stream)
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<aodvKmeans::RoutingProtocol> routing = (*i)->GetObject<aodvKmeans::RoutingProtocol> ();
+      if (routing != 0)
+        {
+          routing->GetMemoryUsage ().Print (*stream->GetStream (), (*i)->GetId ());
+        }
+    }
+  Simulator::Schedule (printInterval, &aodvKmeansHelper::PrintMemoryUsageEveryImpl, printInterval, nodes, stream);
+}
+
+void
+aodvKmeansHelper::EnableStatsAll ()
+{
+  EnableStats (NodeContainer::GetGlobal ());
+}
+
+void
+aodvKmeansHelper::EnableStats (NodeContainer nodes)
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<aodvKmeans::RoutingProtocol> routing = (*i)->GetObject<aodvKmeans::RoutingProtocol> ();
+      if (routing == 0 || (*i)->GetObject<aodvKmeans::Stats> () != 0)
+        {
+          continue;
+        }
+      Ptr<aodvKmeans::Stats> stats = CreateObject<aodvKmeans::Stats> ();
+      stats->Attach (routing, (*i)->GetObject<Ipv4L3Protocol> ());
+      (*i)->AggregateObject (stats);
+    }
+}
+
+Ptr<aodvKmeans::EventLog>
+aodvKmeansHelper::EnableEventLogAll (std::string filename)
+{
+  return EnableEventLog (filename, NodeContainer::GetGlobal ());
+}
+
+Ptr<aodvKmeans::EventLog>
+aodvKmeansHelper::EnableEventLog (std::string filename, NodeContainer nodes)
+{
+  Ptr<aodvKmeans::EventLog> log = CreateObject<aodvKmeans::EventLog> ();
+  if (!log->Open (filename))
+    {
+      return 0;
+    }
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<aodvKmeans::RoutingProtocol> routing = (*i)->GetObject<aodvKmeans::RoutingProtocol> ();
+      Ptr<Ipv4L3Protocol> ipv4 = (*i)->GetObject<Ipv4L3Protocol> ();
+      if (routing != 0 && ipv4 != 0)
+        {
+          log->Attach (routing, ipv4, (*i)->GetId ());
+        }
+    }
+  return log;
+}
+
 }
@@ -25,6 +25,9 @@
 #include "ns3/node.h"
 #include "ns3/node-container.h"
 #include "ns3/ipv4-routing-helper.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/nstime.h"
+#include "ns3/aodvKmeans-event-log.h"
 
 namespace ns3 {
 /**
@@ -34,6 +37,13 @@ namespace ns3 {
 class aodvKmeansHelper : public Ipv4RoutingHelper
 {
 public:
+  /// Formats of protocol statistics snapshots
+  enum StatsFormat
+  {
+    STATS_CSV,  //!< a header line, then one line per node and snapshot
+    STATS_JSON, //!< one JSON object per node and snapshot, one per line
+  };
+
   aodvKmeansHelper ();
 
   /**
@@ -74,7 +84,144 @@ public:
    */
   int64_t AssignStreams (NodeContainer c, int64_t stream);
 
+  /**
+   * \brief prints the protocol statistics of all nodes at regular intervals
+   * \param printInterval the time interval between snapshots
+   * \param stream the output stream
+   * \param format the format of the snapshots
+   *
+   * The statistics are those of the ns3::aodvKmeans::Stats object aggregated to
+   * each node by EnableStats; the counters are cumulative since it was called.
+   */
+  static void PrintStatsAllEvery (Time printInterval, Ptr<OutputStreamWrapper> stream,
+                                  StatsFormat format = STATS_CSV);
+  /**
+   * \brief prints the protocol statistics of some nodes at regular intervals
+   * \param printInterval the time interval between snapshots
+   * \param nodes the nodes
+   * \param stream the output stream
+   * \param format the format of the snapshots
+   */
+  static void PrintStatsEvery (Time printInterval, NodeContainer nodes, Ptr<OutputStreamWrapper> stream,
+                               StatsFormat format = STATS_CSV);
+  /**
+   * \brief prints the protocol statistics of all nodes at a particular time
+   * \param printTime the time at which the statistics are printed
+   * \param stream the output stream
+   * \param format the format of the snapshot
+   */
+  static void PrintStatsAllAt (Time printTime, Ptr<OutputStreamWrapper> stream,
+                               StatsFormat format = STATS_CSV);
+  /**
+   * \brief prints the percentiles of the route discovery latencies at a particular time
+   * \param printTime the time at which the percentiles are printed
+   * \param stream the output stream
+   *
+   * Prints a CSV line per node with statistics enabled, kind of latency, kind
+   * of RREQ and number of retries with samples, then the same lines for all
+   * nodes together.
+   */
+  static void PrintLatencyAllAt (Time printTime, Ptr<OutputStreamWrapper> stream);
+  /**
+   * \brief prints the simulator events of the routing protocol of all nodes at a particular time
+   * \param printTime the time at which the events are printed
+   * \param stream the output stream
+   *
+   * Prints a CSV line per node and kind of event with the events scheduled,
+   * cancelled and executed, and the largest number pending at the same time.
+   */
+  static void PrintEventsAllAt (Time printTime, Ptr<OutputStreamWrapper> stream);
+  /**
+   * \brief prints the route discovery buffer occupancy samples of all nodes at a particular time
+   * \param printTime the time at which the samples are printed
+   * \param stream the output stream
+   *
+   * Prints a CSV line per node and sample kept; the occupancy is only sampled
+   * when the QueueSampleInterval attribute is set.
+   */
+  static void PrintQueueSamplesAllAt (Time printTime, Ptr<OutputStreamWrapper> stream);
+  /**
+   * \brief prints the estimated memory held by the routing protocol of all nodes periodically
+   * \param printInterval the time interval between samples
+   * \param stream the output stream
+   *
+   * Prints a CSV line per node and data structure, and one for their total.
+   */
+  static void PrintMemoryUsageAllEvery (Time printInterval, Ptr<OutputStreamWrapper> stream);
+  /**
+   * \brief counts the control packets and the route discoveries of all nodes
+   *
+   * Must be called after aodvKmeans is installed.  Aggregates an
+   * ns3::aodvKmeans::Stats object to every node running aodvKmeans that has
+   * none yet; statistics are not collected otherwise, as they cost a parse of
+   * every packet sent or received by the IP layer.
+   */
+  static void EnableStatsAll ();
+  /**
+   * \brief counts the control packets and the route discoveries of some nodes
+   * \param nodes the nodes
+   */
+  static void EnableStats (NodeContainer nodes);
+  /**
+   * \brief logs the control plane events of all nodes to a binary file
+   * \param filename the file name
+   * \returns the log, or 0 if the file cannot be created
+   *
+   * Must be called after aodvKmeans is installed.  The log is flushed and closed
+   * when the simulator is destroyed; aodvKmeans::EventLogReader reads it back.
+   */
+  static Ptr<aodvKmeans::EventLog> EnableEventLogAll (std::string filename);
+  /**
+   * \brief logs the control plane events of some nodes to a binary file
+   * \param filename the file name
+   * \param nodes the nodes
+   * \returns the log, or 0 if the file cannot be created
+   */
+  static Ptr<aodvKmeans::EventLog> EnableEventLog (std::string filename, NodeContainer nodes);
+
 private:
+  /**
+   * \brief prints the protocol statistics of some nodes
+   * \param nodes the nodes
+   * \param stream the output stream
+   * \param format the format of the snapshot
+   */
+  static void PrintStats (NodeContainer nodes, Ptr<OutputStreamWrapper> stream, StatsFormat format);
+  /**
+   * \brief prints the protocol statistics of some nodes and schedules the next snapshot
+   * \param printInterval the time interval between snapshots
+   * \param nodes the nodes
+   * \param stream the output stream
+   * \param format the format of the snapshots
+   */
+  static void PrintStatsEveryImpl (Time printInterval, NodeContainer nodes, Ptr<OutputStreamWrapper> stream,
+                                   StatsFormat format);
+  /**
+   * \brief prints the percentiles of the route discovery latencies of some nodes
+   * \param nodes the nodes
+   * \param stream the output stream
+   */
+  static void PrintLatency (NodeContainer nodes, Ptr<OutputStreamWrapper> stream);
+  /**
+   * \brief prints the simulator events of the routing protocol of some nodes
+   * \param nodes the nodes
+   * \param stream the output stream
+   */
+  static void PrintEvents (NodeContainer nodes, Ptr<OutputStreamWrapper> stream);
+  /**
+   * \brief prints the request queue occupancy samples of some nodes
+   * \param nodes the nodes
+   * \param stream the output stream
+   */
+  static void PrintQueueSamples (NodeContainer nodes, Ptr<OutputStreamWrapper> stream);
+  /**
+   * \brief prints the memory held by the routing protocol of some nodes and schedules the next sample
+   * \param printInterval the time interval between samples
+   * \param nodes the nodes
+   * \param stream the output stream
+   */
+  static void PrintMemoryUsageEveryImpl (Time printInterval, NodeContainer nodes, Ptr<OutputStreamWrapper> stream);
+
   /** the factory to create aodvKmeans routing object */
   ObjectFactory m_agentFactory;
 };
@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-bloom-filter.h"
+#include "ns3/simulator.h"
+#include "ns3/assert.h"
+#include "ns3/hash.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+RotatingBloomFilter::RotatingBloomFilter ()
+  : m_bits (0),
+    m_hashes (0),
+    m_capacity (0),
+    m_count (0)
+{
+}
+
+void
+RotatingBloomFilter::Configure (uint32_t capacity, double fpRate, Time period)
+{
+  NS_ASSERT (capacity > 0 && fpRate > 0 && fpRate < 1);
+  double ln2 = std::log (2.0);
+  double bits = -(capacity * std::log (fpRate / 2)) / (ln2 * ln2);
+  uint32_t words = std::max<uint32_t> (static_cast<uint32_t> (std::ceil (bits / 64)), 1);
+  m_bits = words * 64;
+  m_hashes = std::max<uint32_t> (static_cast<uint32_t> (std::floor (ln2 * m_bits / capacity + 0.5)), 1);
+  m_capacity = capacity;
+  m_count = 0;
+  m_current.assign (words, 0);
+  m_previous.assign (words, 0);
+  m_period = period;
+  m_rotateAt = Simulator::Now () + period;
+}
+
+void
+RotatingBloomFilter::SetPeriod (Time period)
+{
+  m_period = period;
+  m_rotateAt = std::min (m_rotateAt, Simulator::Now () + period);
+}
+
+double
+RotatingBloomFilter::GetExpectedFalsePositiveRate () const
+{
+  if (m_bits == 0)
+    {
+      return 0;
+    }
+  double single = std::pow (1 - std::exp (-1.0 * m_hashes * m_capacity / m_bits), m_hashes);
+  return 1 - (1 - single) * (1 - single);
+}
+
+void
+RotatingBloomFilter::Rotate ()
+{
+  Time now = Simulator::Now ();
+  if (now < m_rotateAt && m_count < m_capacity)
+    {
+      return;
+    }
+  if (now >= m_rotateAt + m_period)
+    {
+      // Nothing was inserted during the last whole period
+      std::fill (m_previous.begin (), m_previous.end (), 0);
+    }
+  else
+    {
+      m_previous.swap (m_current);
+    }
+  std::fill (m_current.begin (), m_current.end (), 0);
+  m_count = 0;
+  m_rotateAt = now + m_period;
+}
+
+bool
+RotatingBloomFilter::Test (std::vector<uint64_t> const & bits, uint32_t h1, uint32_t h2) const
+{
+  for (uint32_t i = 0; i < m_hashes; ++i)
+    {
+      uint32_t bit = (h1 + i * h2) % m_bits;
+      if (!(bits[bit / 64] & (uint64_t (1) << (bit % 64))))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+bool
+RotatingBloomFilter::TestAndSet (const char * key, std::size_t size)
+{
+  NS_ASSERT_MSG (m_bits > 0, "Bloom filter is not configured");
+  Rotate ();
+  // Double hashing: the i-th index is h1 + i * h2
+  uint64_t h = Hash64 (key, size);
+  uint32_t h1 = static_cast<uint32_t> (h);
+  uint32_t h2 = static_cast<uint32_t> (h >> 32) | 1;
+  // Like the exact cache, duplicates do not extend the lifetime of a key
+  if (Test (m_current, h1, h2) || Test (m_previous, h1, h2))
+    {
+      return true;
+    }
+  for (uint32_t i = 0; i < m_hashes; ++i)
+    {
+      uint32_t bit = (h1 + i * h2) % m_bits;
+      m_current[bit / 64] |= uint64_t (1) << (bit % 64);
+    }
+  m_count++;
+  return false;
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_BLOOM_FILTER_H
+#define aodvKmeans_BLOOM_FILTER_H
+
+#include "ns3/nstime.h"
+#include <vector>
+
+namespace ns3 {
+namespace aodvKmeans {
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Time-rotating Bloom filter used for memory bounded duplicate detection.
+ *
+ * Two generations of bits are kept.  Keys are inserted in the current generation and
+ * looked up in both; every period, or as soon as the current generation holds its
+ * capacity, the current generation becomes the previous one and a cleared generation
+ * takes its place.  A key is therefore remembered for at least one period (as long as
+ * fewer than capacity keys arrive per period) and at most two, and the memory used is
+ * fixed by the capacity and the false positive rate whatever the insertion rate.
+ *
+ * Each generation is sized for half of the requested false positive rate, so that the
+ * rate observed when looking up both generations stays below the requested one.
+ */
+class RotatingBloomFilter
+{
+public:
+  /// Default constructor, the filter holds no bits until configured
+  RotatingBloomFilter ();
+  /**
+   * Size the filter, any remembered key is forgotten.
+   * \param capacity the number of keys a generation holds
+   * \param fpRate the target false positive rate
+   * \param period the rotation period
+   */
+  void Configure (uint32_t capacity, double fpRate, Time period);
+  /**
+   * Check whether the key was seen, and remember it if it was not.
+   * \param key the key bytes
+   * \param size the key length
+   * \returns true if the key was (probably) seen before
+   */
+  bool TestAndSet (const char * key, std::size_t size);
+  /**
+   * Set the rotation period
+   * \param period the rotation period
+   */
+  void SetPeriod (Time period);
+  /**
+   * \returns the rotation period
+   */
+  Time GetPeriod () const
+  {
+    return m_period;
+  }
+  /**
+   * \returns the number of bits of a generation
+   */
+  uint32_t GetBitCount () const
+  {
+    return m_bits;
+  }
+  /**
+   * \returns the number of hash functions
+   */
+  uint32_t GetHashCount () const
+  {
+    return m_hashes;
+  }
+  /**
+   * \returns the memory held by the bit arrays, bytes
+   */
+  uint32_t GetMemoryBytes () const
+  {
+    return (m_current.size () + m_previous.size ()) * sizeof (uint64_t);
+  }
+  /**
+   * \returns the expected false positive rate when both generations are full
+   */
+  double GetExpectedFalsePositiveRate () const;
+
+private:
+  /// Make the current generation the previous one if needed
+  void Rotate ();
+  /**
+   * Check that all bits of a key are set in a generation
+   * \param bits the generation
+   * \param h1 first hash
+   * \param h2 second hash
+   * \returns true if all bits are set
+   */
+  bool Test (std::vector<uint64_t> const & bits, uint32_t h1, uint32_t h2) const;
+
+  /// Bits of the current generation
+  std::vector<uint64_t> m_current;
+  /// Bits of the previous generation
+  std::vector<uint64_t> m_previous;
+  /// Number of bits per generation
+  uint32_t m_bits;
+  /// Number of hash functions
+  uint32_t m_hashes;
+  /// Number of keys a generation holds
+  uint32_t m_capacity;
+  /// Number of keys inserted in the current generation
+  uint32_t m_count;
+  /// Rotation period
+  Time m_period;
+  /// Time of the next rotation
+  Time m_rotateAt;
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_BLOOM_FILTER_H */
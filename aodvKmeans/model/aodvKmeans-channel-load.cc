@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-channel-load.h"
+#include "ns3/simulator.h"
+#include "ns3/pointer.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/wifi-phy-state-helper.h"
+#include "ns3/wifi-mac-queue.h"
+#include "ns3/txop.h"
+#include <algorithm>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+/// Attributes of the MAC holding its channel access functions, non-QoS then QoS
+static const char * const TXOP_ATTRIBUTES[] = { "Txop", "VO_Txop", "VI_Txop", "BE_Txop", "BK_Txop" };
+
+ChannelLoadMonitor::ChannelLoadMonitor (Time window)
+  : m_window (window),
+    m_windowStart (Seconds (0)),
+    m_busy (Seconds (0)),
+    m_lastBusy (0)
+{
+}
+
+void
+ChannelLoadMonitor::AddDevice (Ptr<WifiNetDevice> device)
+{
+  if (std::find (m_devices.begin (), m_devices.end (), device) != m_devices.end ())
+    {
+      return;
+    }
+  m_devices.push_back (device);
+  device->GetPhy ()->GetState ()->TraceConnectWithoutContext ("State",
+                                                              MakeCallback (&ChannelLoadMonitor::NotifyPhyState, this));
+  for (uint32_t i = 0; i < sizeof (TXOP_ATTRIBUTES) / sizeof (TXOP_ATTRIBUTES[0]); ++i)
+    {
+      PointerValue txop;
+      if (device->GetMac ()->GetAttributeFailSafe (TXOP_ATTRIBUTES[i], txop) && txop.Get<Txop> () != 0)
+        {
+          m_queues.push_back (txop.Get<Txop> ()->GetWifiMacQueue ());
+        }
+    }
+}
+
+void
+ChannelLoadMonitor::DelDevice (Ptr<WifiNetDevice> device)
+{
+  std::vector<Ptr<WifiNetDevice> >::iterator i = std::find (m_devices.begin (), m_devices.end (), device);
+  if (i == m_devices.end ())
+    {
+      return;
+    }
+  m_devices.erase (i);
+  device->GetPhy ()->GetState ()->TraceDisconnectWithoutContext ("State",
+                                                                 MakeCallback (&ChannelLoadMonitor::NotifyPhyState, this));
+  for (uint32_t j = 0; j < sizeof (TXOP_ATTRIBUTES) / sizeof (TXOP_ATTRIBUTES[0]); ++j)
+    {
+      PointerValue txop;
+      if (device->GetMac ()->GetAttributeFailSafe (TXOP_ATTRIBUTES[j], txop) && txop.Get<Txop> () != 0)
+        {
+          Ptr<WifiMacQueue> queue = txop.Get<Txop> ()->GetWifiMacQueue ();
+          m_queues.erase (std::remove (m_queues.begin (), m_queues.end (), queue), m_queues.end ());
+        }
+    }
+}
+
+double
+ChannelLoadMonitor::GetMacQueueOccupancy () const
+{
+  uint32_t packets = 0;
+  uint32_t capacity = 0;
+  for (std::vector<Ptr<WifiMacQueue> >::const_iterator i = m_queues.begin (); i != m_queues.end (); ++i)
+    {
+      packets += (*i)->GetNPackets ();
+      capacity += (*i)->GetMaxSize ().GetValue ();
+    }
+  return capacity == 0 ? 0 : std::min (1.0, double (packets) / capacity);
+}
+
+double
+ChannelLoadMonitor::GetChannelBusy ()
+{
+  Roll ();
+  return m_lastBusy;
+}
+
+void
+ChannelLoadMonitor::Roll ()
+{
+  if (Simulator::Now () < m_windowStart + m_window || m_devices.empty () || !m_window.IsStrictlyPositive ())
+    {
+      return;
+    }
+  Close ();
+  // An idle gap of more than a window leaves nothing to account for
+  if (Simulator::Now () >= m_windowStart + m_window)
+    {
+      m_windowStart = Simulator::Now ();
+      m_lastBusy = 0;
+    }
+}
+
+void
+ChannelLoadMonitor::Close ()
+{
+  m_lastBusy = std::min (1.0, m_busy.GetSeconds () / (m_window.GetSeconds () * m_devices.size ()));
+  m_busy = Seconds (0);
+  m_windowStart += m_window;
+}
+
+void
+ChannelLoadMonitor::AddBusy (Time start, Time end)
+{
+  Time from = std::max (start, m_windowStart);
+  Time to = std::min (end, m_windowStart + m_window);
+  if (to > from)
+    {
+      m_busy += to - from;
+    }
+}
+
+void
+ChannelLoadMonitor::NotifyPhyState (Time start, Time duration, WifiPhyState state)
+{
+  if (state != WifiPhyState::CCA_BUSY && state != WifiPhyState::RX && state != WifiPhyState::TX)
+    {
+      return;
+    }
+  // Periods are reported when they end, split them over the windows they cover
+  Time end = start + duration;
+  AddBusy (start, end);
+  while (m_window.IsStrictlyPositive () && !m_devices.empty () && end > m_windowStart + m_window)
+    {
+      Close ();
+      AddBusy (start, end);
+    }
+  Roll ();
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
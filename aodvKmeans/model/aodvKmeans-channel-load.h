@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_CHANNEL_LOAD_H
+#define aodvKmeans_CHANNEL_LOAD_H
+
+#include <vector>
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/wifi-phy-state.h"
+
+namespace ns3 {
+
+class WifiNetDevice;
+class WifiMacQueue;
+
+namespace aodvKmeans {
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Load of the 802.11 interfaces of a node.
+ *
+ * Reports the occupancy of the MAC queues of the interfaces and the fraction
+ * of time their PHY found the channel busy (CCA busy, receiving or
+ * transmitting), measured over consecutive windows from the PHY state trace.
+ */
+class ChannelLoadMonitor
+{
+public:
+  /**
+   * constructor
+   * \param window the length of the busy fraction measurement windows
+   */
+  ChannelLoadMonitor (Time window);
+  /**
+   * Start monitoring an interface
+   * \param device the interface
+   */
+  void AddDevice (Ptr<WifiNetDevice> device);
+  /**
+   * Stop monitoring an interface
+   * \param device the interface
+   */
+  void DelDevice (Ptr<WifiNetDevice> device);
+  /**
+   * \returns the number of packets in the MAC queues over their capacity, in [0, 1]
+   */
+  double GetMacQueueOccupancy () const;
+  /**
+   * Get the busy fraction of the last complete window
+   * \returns the fraction of time the channel was busy, in [0, 1]
+   */
+  double GetChannelBusy ();
+  /**
+   * Set the length of the measurement windows
+   * \param window the length
+   */
+  void SetWindow (Time window)
+  {
+    m_window = window;
+  }
+  /**
+   * \returns the length of the measurement windows
+   */
+  Time GetWindow () const
+  {
+    return m_window;
+  }
+  /**
+   * Account a PHY state period
+   * \param start the start of the period
+   * \param duration the duration of the period
+   * \param state the PHY state during the period
+   */
+  void NotifyPhyState (Time start, Time duration, WifiPhyState state);
+
+private:
+  /// Close the current window if it is over
+  void Roll ();
+  /// Record the busy fraction of the current window and start the next one
+  void Close ();
+  /**
+   * Account the part of a busy period within the current window
+   * \param start the start of the period
+   * \param end the end of the period
+   */
+  void AddBusy (Time start, Time end);
+
+  /// Monitored interfaces
+  std::vector<Ptr<WifiNetDevice> > m_devices;
+  /// MAC queues of the monitored interfaces
+  std::vector<Ptr<WifiMacQueue> > m_queues;
+  /// Length of the measurement windows
+  Time m_window;
+  /// Start of the current window
+  Time m_windowStart;
+  /// Busy time in the current window, summed over interfaces
+  Time m_busy;
+  /// Busy fraction of the last complete window
+  double m_lastBusy;
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_CHANNEL_LOAD_H */
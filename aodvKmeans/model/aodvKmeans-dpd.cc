@@ -28,12 +28,53 @@ namespace aodvKmeans {
 bool
 DuplicatePacketDetection::IsDuplicate  (Ptr<const Packet> p, const Ipv4Header & header)
 {
+  if (m_mode == DPD_BLOOM)
+    {
+      uint8_t key[12];
+      header.GetSource ().Serialize (key);
+      uint64_t uid = p->GetUid ();
+      for (uint32_t i = 0; i < 8; ++i)
+        {
+          key[4 + i] = static_cast<uint8_t> (uid >> (8 * i));
+        }
+      return m_bloom.TestAndSet (reinterpret_cast<const char *> (key), sizeof (key));
+    }
   return m_idCache.IsDuplicate (header.GetSource (), p->GetUid () );
 }
 void
 DuplicatePacketDetection::SetLifetime (Time lifetime)
 {
   m_idCache.SetLifetime (lifetime);
+  if (m_mode == DPD_BLOOM)
+    {
+      m_bloom.SetPeriod (lifetime);
+    }
+}
+
+void
+DuplicatePacketDetection::SetMode (DpdMode mode)
+{
+  m_mode = mode;
+  if (m_mode == DPD_BLOOM)
+    {
+      m_bloom.Configure (m_bloomCapacity, m_bloomFpRate, m_idCache.GetLifeTime ());
+    }
+  else
+    {
+      // Release the bit arrays
+      m_bloom = RotatingBloomFilter ();
+    }
+}
+
+void
+DuplicatePacketDetection::SetBloomParameters (uint32_t capacity, double fpRate)
+{
+  m_bloomCapacity = capacity;
+  m_bloomFpRate = fpRate;
+  if (m_mode == DPD_BLOOM)
+    {
+      m_bloom.Configure (m_bloomCapacity, m_bloomFpRate, m_idCache.GetLifeTime ());
+    }
 }
 
 Time
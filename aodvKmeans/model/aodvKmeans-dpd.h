@@ -24,12 +24,23 @@
 #define aodvKmeans_DPD_H
 
 #include "aodvKmeans-id-cache.h"
+#include "aodvKmeans-bloom-filter.h"
 #include "ns3/nstime.h"
 #include "ns3/packet.h"
 #include "ns3/ipv4-header.h"
 
 namespace ns3 {
 namespace aodvKmeans {
+/**
+ * \ingroup aodvKmeans
+ * \brief Duplicate packet detection mode
+ */
+enum DpdMode
+{
+  DPD_EXACT = 0,   //!< remember every packet in an IdCache
+  DPD_BLOOM = 1,   //!< remember packets in a fixed size rotating Bloom filter
+};
+
 /**
  * \ingroup aodvKmeans
  *
@@ -37,6 +48,9 @@ namespace aodvKmeans {
  *
  * Currently duplicate detection is based on unique packet ID given by Packet::GetUid ()
  * This approach is known to be weak (ns3::Packet UID is an internal identifier and not intended for logical uniqueness in models) and should be changed.
+ *
+ * In DPD_BLOOM mode the memory used does not depend on the broadcast rate, at the
+ * price of a configurable rate of packets wrongly taken for duplicates.
  */
 class DuplicatePacketDetection
 {
@@ -45,7 +59,10 @@ public:
    * Constructor
    * \param lifetime the lifetime for added entries
    */
-  DuplicatePacketDetection (Time lifetime) : m_idCache (lifetime)
+  DuplicatePacketDetection (Time lifetime) : m_idCache (lifetime),
+                                             m_mode (DPD_EXACT),
+                                             m_bloomCapacity (4096),
+                                             m_bloomFpRate (0.001)
   {
   }
   /**
@@ -65,9 +82,63 @@ public:
    * \returns the duplicate record lifetime
    */
   Time GetLifetime () const;
+  /**
+   * Set the detection mode, records of the previous mode are forgotten
+   * \param mode the detection mode
+   */
+  void SetMode (DpdMode mode);
+  /**
+   * \returns the detection mode
+   */
+  DpdMode GetMode () const
+  {
+    return m_mode;
+  }
+  /**
+   * Size the Bloom filter used in DPD_BLOOM mode
+   * \param capacity the number of packets remembered per lifetime
+   * \param fpRate the target false positive rate
+   */
+  void SetBloomParameters (uint32_t capacity, double fpRate);
+  /**
+   * \returns the number of packets remembered per lifetime in DPD_BLOOM mode
+   */
+  uint32_t GetBloomCapacity () const
+  {
+    return m_bloomCapacity;
+  }
+  /**
+   * \returns the target false positive rate in DPD_BLOOM mode
+   */
+  double GetBloomFpRate () const
+  {
+    return m_bloomFpRate;
+  }
+  /**
+   * \returns the memory held by the Bloom filter, bytes
+   */
+  uint32_t GetBloomMemoryBytes () const
+  {
+    return m_bloom.GetMemoryBytes ();
+  }
+  /**
+   * \returns the estimated memory held by the ID cache and the Bloom filter, bytes
+   */
+  uint64_t GetMemoryBytes () const
+  {
+    return m_idCache.GetMemoryBytes () + m_bloom.GetMemoryBytes ();
+  }
 private:
   /// Impl
   IdCache m_idCache;
+  /// Impl in DPD_BLOOM mode
+  RotatingBloomFilter m_bloom;
+  /// Detection mode
+  DpdMode m_mode;
+  /// Bloom filter capacity
+  uint32_t m_bloomCapacity;
+  /// Bloom filter false positive rate
+  double m_bloomFpRate;
 };
 
 }
@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-event-accounting.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+EventAccounting::EventAccounting ()
+  : m_totalPending (0)
+{
+  for (uint32_t t = 0; t < EVENT_TYPE_COUNT; t++)
+    {
+      m_pending[t] = 0;
+    }
+  Reset ();
+}
+
+void
+EventAccounting::Scheduled (EventType type)
+{
+  m_scheduled[type]++;
+  m_pending[type]++;
+  m_totalPending++;
+  m_peakPending[type] = std::max (m_peakPending[type], m_pending[type]);
+  m_peakTotalPending = std::max (m_peakTotalPending, m_totalPending);
+}
+
+void
+EventAccounting::Cancelled (EventType type)
+{
+  m_cancelled[type]++;
+  Retire (type);
+}
+
+void
+EventAccounting::Executed (EventType type)
+{
+  m_executed[type]++;
+  Retire (type);
+}
+
+void
+EventAccounting::Retire (EventType type)
+{
+  // events scheduled before the protocol reported them are not pending
+  if (m_pending[type] > 0)
+    {
+      m_pending[type]--;
+      m_totalPending--;
+    }
+}
+
+std::string
+EventAccounting::GetEventTypeName (EventType type)
+{
+  switch (type)
+    {
+    case EVENT_SEND_MEMBER:
+      return "sendMember";
+    case EVENT_SEND_BROADCAST:
+      return "sendBroadcast";
+    case EVENT_SEND_UNICAST:
+      return "sendUnicast";
+    case EVENT_CLUSTER_TIMER:
+      return "clusterTimer";
+    case EVENT_DEFERRED_RREQ:
+      return "deferredRreq";
+    case EVENT_ROUTE_REQUEST_TIMER:
+      return "routeRequestTimer";
+    case EVENT_HELLO_TIMER:
+      return "helloTimer";
+    case EVENT_NEIGHBOR_TIMER:
+      return "neighborTimer";
+    case EVENT_ACK_TIMER:
+      return "ackTimer";
+    case EVENT_RATE_LIMIT_TIMER:
+      return "rateLimitTimer";
+    case EVENT_QUEUE_SAMPLE_TIMER:
+      return "queueSampleTimer";
+    default:
+      return "unknown";
+    }
+}
+
+void
+EventAccounting::Reset ()
+{
+  for (uint32_t t = 0; t < EVENT_TYPE_COUNT; t++)
+    {
+      m_scheduled[t] = 0;
+      m_cancelled[t] = 0;
+      m_executed[t] = 0;
+      m_peakPending[t] = m_pending[t];
+    }
+  m_peakTotalPending = m_totalPending;
+}
+
+void
+EventAccounting::PrintHeader (std::ostream & os)
+{
+  os << "time,node,event,scheduled,cancelled,executed,pending,peakPending" << std::endl;
+}
+
+void
+EventAccounting::Print (std::ostream & os, uint32_t node) const
+{
+  uint64_t scheduled = 0;
+  uint64_t cancelled = 0;
+  uint64_t executed = 0;
+  for (uint32_t t = 0; t < EVENT_TYPE_COUNT; t++)
+    {
+      os << Simulator::Now ().GetSeconds () << "," << node << "," << GetEventTypeName (EventType (t))
+         << "," << m_scheduled[t] << "," << m_cancelled[t] << "," << m_executed[t]
+         << "," << m_pending[t] << "," << m_peakPending[t] << std::endl;
+      scheduled += m_scheduled[t];
+      cancelled += m_cancelled[t];
+      executed += m_executed[t];
+    }
+  os << Simulator::Now ().GetSeconds () << "," << node << ",all," << scheduled << "," << cancelled
+     << "," << executed << "," << m_totalPending << "," << m_peakTotalPending << std::endl;
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_EVENT_ACCOUNTING_H
+#define aodvKmeans_EVENT_ACCOUNTING_H
+
+#include <ostream>
+#include <string>
+#include <stdint.h>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Simulator events of the routing protocol of a node, by callback.
+ *
+ * Counts the events scheduled, cancelled before they expired and executed,
+ * for each kind of callback, and the largest number of events pending at the
+ * same time, for each kind and overall.  The protocol reports each event it
+ * schedules, cancels or handles.
+ */
+class EventAccounting
+{
+public:
+  /// Kinds of events
+  enum EventType
+  {
+    EVENT_SEND_MEMBER = 0,          //!< SendTo of a RREQ to a member of a cluster of forwarders
+    EVENT_SEND_BROADCAST = 1,       //!< jittered SendTo of a broadcast RREQ, hello or RERR
+    EVENT_SEND_UNICAST = 2,         //!< jittered SendTo of a RERR to its only precursor
+    EVENT_CLUSTER_TIMER = 3,        //!< ClusterTimerExpire
+    EVENT_DEFERRED_RREQ = 4,        //!< SendRequest delayed by the RREQ rate limit
+    EVENT_ROUTE_REQUEST_TIMER = 5,  //!< m_addressReqTimer
+    EVENT_HELLO_TIMER = 6,          //!< m_htimer
+    EVENT_NEIGHBOR_TIMER = 7,       //!< Neighbors::m_ntimer
+    EVENT_ACK_TIMER = 8,            //!< RoutingTableEntry::m_ackTimer
+    EVENT_RATE_LIMIT_TIMER = 9,     //!< m_rreqRateLimitTimer and m_rerrRateLimitTimer
+    EVENT_QUEUE_SAMPLE_TIMER = 10,  //!< m_queueSampleTimer
+    EVENT_TYPE_COUNT = 11,          //!< number of kinds of events
+  };
+
+  EventAccounting ();
+  /**
+   * Count a scheduled event
+   * \param type the kind of event
+   */
+  void Scheduled (EventType type);
+  /**
+   * Count an event cancelled before it expired
+   * \param type the kind of event
+   */
+  void Cancelled (EventType type);
+  /**
+   * Count an executed event
+   * \param type the kind of event
+   */
+  void Executed (EventType type);
+  /**
+   * \param type the kind of event
+   * \returns the number of events scheduled
+   */
+  uint64_t GetScheduled (EventType type) const
+  {
+    return m_scheduled[type];
+  }
+  /**
+   * \param type the kind of event
+   * \returns the number of events cancelled
+   */
+  uint64_t GetCancelled (EventType type) const
+  {
+    return m_cancelled[type];
+  }
+  /**
+   * \param type the kind of event
+   * \returns the number of events executed
+   */
+  uint64_t GetExecuted (EventType type) const
+  {
+    return m_executed[type];
+  }
+  /**
+   * \param type the kind of event
+   * \returns the number of events pending
+   */
+  uint32_t GetPending (EventType type) const
+  {
+    return m_pending[type];
+  }
+  /**
+   * \param type the kind of event
+   * \returns the largest number of events of this kind pending at the same time
+   */
+  uint32_t GetPeakPending (EventType type) const
+  {
+    return m_peakPending[type];
+  }
+  /**
+   * \returns the largest number of events pending at the same time
+   */
+  uint32_t GetPeakPending () const
+  {
+    return m_peakTotalPending;
+  }
+  /**
+   * \param type the kind of event
+   * \returns the name of the kind, as used in reports
+   */
+  static std::string GetEventTypeName (EventType type);
+  /// Reset the counters, the peaks restart from the events pending
+  void Reset ();
+  /**
+   * Print the header line of CSV reports
+   * \param os the output stream
+   */
+  static void PrintHeader (std::ostream & os);
+  /**
+   * Print the counters as CSV lines, one per kind of event and one for all events
+   * \param os the output stream
+   * \param node the id of the node
+   */
+  void Print (std::ostream & os, uint32_t node) const;
+
+private:
+  /**
+   * Count an event that is no longer pending
+   * \param type the kind of event
+   */
+  void Retire (EventType type);
+
+  uint64_t m_scheduled[EVENT_TYPE_COUNT];   //!< Events scheduled, by kind
+  uint64_t m_cancelled[EVENT_TYPE_COUNT];   //!< Events cancelled, by kind
+  uint64_t m_executed[EVENT_TYPE_COUNT];    //!< Events executed, by kind
+  uint32_t m_pending[EVENT_TYPE_COUNT];     //!< Events pending, by kind
+  uint32_t m_peakPending[EVENT_TYPE_COUNT]; //!< Largest number of events pending, by kind
+  uint32_t m_totalPending;                  //!< Events pending
+  uint32_t m_peakTotalPending;              //!< Largest number of events pending
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_EVENT_ACCOUNTING_H */
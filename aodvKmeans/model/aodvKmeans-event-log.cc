@@ -0,0 +1,375 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-event-log.h"
+#include "aodvKmeans-routing-protocol.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/udp-header.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("aodvKmeansEventLog");
+
+namespace aodvKmeans {
+
+NS_OBJECT_ENSURE_REGISTERED (EventLog);
+
+const uint32_t EventLog::MAGIC;
+const uint16_t EventLog::VERSION;
+
+/// Size of the type and length of a record
+static const uint32_t RECORD_PREFIX = 3;
+
+TypeId
+EventLog::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::aodvKmeans::EventLog")
+    .SetParent<Object> ()
+    .SetGroupName ("aodvKmeans")
+    .AddConstructor<EventLog> ()
+    .AddAttribute ("BufferSize", "Size of the buffered records above which they are written to the file, bytes.",
+                   UintegerValue (64 * 1024),
+                   MakeUintegerAccessor (&EventLog::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlushInterval", "Time between writes of the buffered records to the file.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&EventLog::m_flushInterval),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+EventLog::EventLog ()
+  : m_recordStart (0),
+    m_bufferSize (64 * 1024),
+    m_flushInterval (Seconds (1)),
+    m_records (0),
+    m_bytes (0)
+{
+}
+
+EventLog::~EventLog ()
+{
+  Close ();
+}
+
+void
+EventLog::DoDispose ()
+{
+  Close ();
+  Object::DoDispose ();
+}
+
+bool
+EventLog::Open (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open ())
+    {
+      NS_LOG_WARN ("Cannot open " << filename);
+      return false;
+    }
+  m_buffer.reserve (m_bufferSize + 1024);
+  Append (MAGIC, 4);
+  Append (VERSION, 2);
+  if (m_flushInterval.IsStrictlyPositive ())
+    {
+      m_flushEvent = Simulator::Schedule (m_flushInterval, &EventLog::PeriodicFlush, this);
+    }
+  Simulator::ScheduleDestroy (&EventLog::Close, Ptr<EventLog> (this));
+  return true;
+}
+
+bool
+EventLog::IsOpen () const
+{
+  return m_file.is_open ();
+}
+
+void
+EventLog::Flush ()
+{
+  if (!m_file.is_open () || m_buffer.empty ())
+    {
+      return;
+    }
+  m_file.write (reinterpret_cast<const char *> (&m_buffer[0]), m_buffer.size ());
+  m_file.flush ();
+  m_buffer.clear ();
+}
+
+void
+EventLog::Close ()
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_flushEvent.Cancel ();
+  Flush ();
+  m_file.close ();
+}
+
+void
+EventLog::PeriodicFlush ()
+{
+  Flush ();
+  m_flushEvent = Simulator::Schedule (m_flushInterval, &EventLog::PeriodicFlush, this);
+}
+
+void
+EventLog::Attach (Ptr<RoutingProtocol> routing, Ptr<Ipv4L3Protocol> ipv4, uint32_t node)
+{
+  NS_LOG_FUNCTION (this << routing << ipv4 << node);
+  Ptr<EventLog> log = this;
+  ipv4->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&EventLog::LogTx, log, node));
+  ipv4->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&EventLog::LogRx, log, node));
+  routing->TraceConnectWithoutContext ("KmeansClustering", MakeBoundCallback (&EventLog::LogCluster, log, node));
+  routing->TraceConnectWithoutContext ("RouteChanged", MakeBoundCallback (&EventLog::LogRoute, log, node));
+}
+
+void
+EventLog::Append (uint64_t value, uint32_t bytes)
+{
+  for (uint32_t i = 0; i < bytes; i++)
+    {
+      m_buffer.push_back (static_cast<uint8_t> (value >> (8 * i)));
+    }
+  m_bytes += bytes;
+}
+
+void
+EventLog::BeginRecord (RecordType type, uint32_t node)
+{
+  m_recordStart = m_buffer.size ();
+  Append (type, 1);
+  Append (0, 2);
+  Append (Simulator::Now ().GetNanoSeconds (), 8);
+  Append (node, 4);
+}
+
+void
+EventLog::EndRecord ()
+{
+  uint32_t length = m_buffer.size () - m_recordStart - RECORD_PREFIX;
+  NS_ASSERT_MSG (length <= 0xffff, "Record too long");
+  m_buffer[m_recordStart + 1] = static_cast<uint8_t> (length);
+  m_buffer[m_recordStart + 2] = static_cast<uint8_t> (length >> 8);
+  m_records++;
+  if (m_buffer.size () >= m_bufferSize)
+    {
+      Flush ();
+    }
+}
+
+bool
+EventLog::WriteControl (uint32_t node, bool tx, Ptr<const Packet> ipPacket)
+{
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+  Ptr<Packet> p = ipPacket->Copy ();
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  if (ipHeader.GetProtocol () != UdpL4Protocol::PROT_NUMBER || ipHeader.GetFragmentOffset () != 0)
+    {
+      return false;
+    }
+  UdpHeader udpHeader;
+  p->RemoveHeader (udpHeader);
+  if (udpHeader.GetDestinationPort () != RoutingProtocol::aodvKmeans_PORT)
+    {
+      return false;
+    }
+  BeginRecord (tx ? RECORD_CONTROL_TX : RECORD_CONTROL_RX, node);
+  Append (ipHeader.GetSource ().Get (), 4);
+  Append (ipHeader.GetDestination ().Get (), 4);
+  Append (ipHeader.GetTtl (), 1);
+  uint32_t size = p->GetSize ();
+  m_buffer.resize (m_buffer.size () + size);
+  p->CopyData (&m_buffer[m_buffer.size () - size], size);
+  m_bytes += size;
+  EndRecord ();
+  return true;
+}
+
+void
+EventLog::WriteCluster (uint32_t node, Ipv4Address dst, uint32_t candidates, std::vector<Ipv4Address> const & forwarders)
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  BeginRecord (RECORD_CLUSTER, node);
+  Append (dst.Get (), 4);
+  Append (candidates, 4);
+  for (std::vector<Ipv4Address>::const_iterator i = forwarders.begin (); i != forwarders.end (); ++i)
+    {
+      Append (i->Get (), 4);
+    }
+  EndRecord ();
+}
+
+void
+EventLog::WriteRoute (uint32_t node, RoutingTableEntry const & route, bool valid)
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  BeginRecord (valid ? RECORD_ROUTE_VALID : RECORD_ROUTE_INVALID, node);
+  Append (route.GetDestination ().Get (), 4);
+  Append (route.GetNextHop ().Get (), 4);
+  Append (route.GetSeqNo (), 4);
+  Append (route.GetHop (), 2);
+  Append (route.GetLifeTime ().GetNanoSeconds (), 8);
+  EndRecord ();
+}
+
+void
+EventLog::LogTx (Ptr<EventLog> log, uint32_t node, Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  log->WriteControl (node, true, packet);
+}
+
+void
+EventLog::LogRx (Ptr<EventLog> log, uint32_t node, Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  log->WriteControl (node, false, packet);
+}
+
+void
+EventLog::LogCluster (Ptr<EventLog> log, uint32_t node, Ipv4Address dst, uint32_t candidates,
+                      const std::vector<Ipv4Address> & forwarders)
+{
+  log->WriteCluster (node, dst, candidates, forwarders);
+}
+
+void
+EventLog::LogRoute (Ptr<EventLog> log, uint32_t node, const RoutingTableEntry & route, bool valid)
+{
+  log->WriteRoute (node, route, valid);
+}
+
+/**
+ * Read a little endian integer
+ * \param data the bytes
+ * \param bytes its size
+ * \returns the integer
+ */
+static uint64_t
+ReadInteger (const uint8_t * data, uint32_t bytes)
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < bytes; i++)
+    {
+      value |= static_cast<uint64_t> (data[i]) << (8 * i);
+    }
+  return value;
+}
+
+EventLogReader::EventLogReader ()
+{
+}
+
+bool
+EventLogReader::Open (std::string filename)
+{
+  m_file.open (filename.c_str (), std::ios::in | std::ios::binary);
+  uint8_t header[6];
+  if (!m_file.read (reinterpret_cast<char *> (header), sizeof (header)))
+    {
+      return false;
+    }
+  return ReadInteger (header, 4) == EventLog::MAGIC && ReadInteger (header + 4, 2) == EventLog::VERSION;
+}
+
+bool
+EventLogReader::Read (EventLogRecord & record)
+{
+  while (true)
+    {
+      uint8_t prefix[RECORD_PREFIX];
+      if (!m_file.read (reinterpret_cast<char *> (prefix), RECORD_PREFIX))
+        {
+          return false;
+        }
+      uint32_t length = ReadInteger (prefix + 1, 2);
+      std::vector<uint8_t> data (length);
+      if (length < 12 || !m_file.read (reinterpret_cast<char *> (&data[0]), length))
+        {
+          return false;
+        }
+      record.m_type = EventLog::RecordType (prefix[0]);
+      record.m_time = NanoSeconds (static_cast<int64_t> (ReadInteger (&data[0], 8)));
+      record.m_node = ReadInteger (&data[8], 4);
+      const uint8_t * fields = &data[12];
+      uint32_t size = length - 12;
+      switch (record.m_type)
+        {
+        case EventLog::RECORD_CONTROL_TX:
+        case EventLog::RECORD_CONTROL_RX:
+          if (size < 9)
+            {
+              return false;
+            }
+          record.m_source = Ipv4Address (ReadInteger (fields, 4));
+          record.m_destination = Ipv4Address (ReadInteger (fields + 4, 4));
+          record.m_ttl = fields[8];
+          record.m_message = Create<Packet> (fields + 9, size - 9);
+          return true;
+        case EventLog::RECORD_CLUSTER:
+          if (size < 8)
+            {
+              return false;
+            }
+          record.m_dst = Ipv4Address (ReadInteger (fields, 4));
+          record.m_candidates = ReadInteger (fields + 4, 4);
+          record.m_forwarders.clear ();
+          for (uint32_t i = 8; i + 4 <= size; i += 4)
+            {
+              record.m_forwarders.push_back (Ipv4Address (ReadInteger (fields + i, 4)));
+            }
+          return true;
+        case EventLog::RECORD_ROUTE_VALID:
+        case EventLog::RECORD_ROUTE_INVALID:
+          if (size < 22)
+            {
+              return false;
+            }
+          record.m_dst = Ipv4Address (ReadInteger (fields, 4));
+          record.m_nextHop = Ipv4Address (ReadInteger (fields + 4, 4));
+          record.m_seqNo = ReadInteger (fields + 8, 4);
+          record.m_hops = ReadInteger (fields + 12, 2);
+          record.m_lifetime = NanoSeconds (static_cast<int64_t> (ReadInteger (fields + 14, 8)));
+          return true;
+        default:
+          NS_LOG_LOGIC ("Skip record of unknown type " << uint32_t (prefix[0]));
+          break;
+        }
+    }
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
@@ -0,0 +1,280 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_EVENT_LOG_H
+#define aodvKmeans_EVENT_LOG_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Ipv4;
+class Ipv4L3Protocol;
+
+namespace aodvKmeans {
+
+class RoutingProtocol;
+class RoutingTableEntry;
+
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Compact binary log of the control plane events of some nodes.
+ *
+ * Records the aodvKmeans control messages sent and received by the IP layer of
+ * the nodes, in their wire format with the IP source, destination and TTL, the
+ * forwarder selections by K-means, and the routes becoming valid or
+ * invalidated.  The records are appended to a buffer written to the file when
+ * it exceeds BufferSize bytes, every FlushInterval and when the simulator is
+ * destroyed.
+ *
+ * The file starts with the magic number and the format version, then each
+ * record is its type (1 byte) and the length of the rest of the record
+ * (2 bytes), the time (8 bytes, ns) and the node id (4 bytes), then its
+ * fields.  All integers are little endian, and IPv4 addresses take 4 bytes.
+ * EventLogReader reads the records back.
+ */
+class EventLog : public Object
+{
+public:
+  /// Types of records
+  enum RecordType
+  {
+    RECORD_CONTROL_TX = 0,     //!< control message sent: source, destination, TTL, message
+    RECORD_CONTROL_RX = 1,     //!< control message received: source, destination, TTL, message
+    RECORD_CLUSTER = 2,        //!< forwarder selection: destination, candidates, forwarders
+    RECORD_ROUTE_VALID = 3,    //!< route became valid: destination, next hop, sequence number, hops, lifetime
+    RECORD_ROUTE_INVALID = 4,  //!< route invalidated: same fields
+  };
+
+  /// Magic number at the start of the file
+  static const uint32_t MAGIC = 0x4c454b41;
+  /// Version of the format
+  static const uint16_t VERSION = 1;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  EventLog ();
+  virtual ~EventLog ();
+
+  /**
+   * Create the file and write its header, closing the previous one if any
+   * \param filename the file name
+   * \returns true on success
+   */
+  bool Open (std::string filename);
+  /**
+   * \returns true if a file is open
+   */
+  bool IsOpen () const;
+  /// Write the buffered records to the file
+  void Flush ();
+  /// Flush and close the file
+  void Close ();
+  /**
+   * Log the events of the routing protocol and the IP layer of a node
+   * \param routing the routing protocol
+   * \param ipv4 the IP layer
+   * \param node the id of the node
+   */
+  void Attach (Ptr<RoutingProtocol> routing, Ptr<Ipv4L3Protocol> ipv4, uint32_t node);
+
+  /**
+   * Log a control message, ignoring other packets
+   * \param node the node
+   * \param tx true if sent, false if received
+   * \param ipPacket the packet, starting with its IP header
+   * \returns true if the packet was a control message
+   */
+  bool WriteControl (uint32_t node, bool tx, Ptr<const Packet> ipPacket);
+  /**
+   * Log a forwarder selection
+   * \param node the node
+   * \param dst the destination of the RREQ
+   * \param candidates the number of forwarder candidates
+   * \param forwarders the forwarders selected
+   */
+  void WriteCluster (uint32_t node, Ipv4Address dst, uint32_t candidates, std::vector<Ipv4Address> const & forwarders);
+  /**
+   * Log a route change
+   * \param node the node
+   * \param route the routing table entry
+   * \param valid whether the route became valid or was invalidated
+   */
+  void WriteRoute (uint32_t node, RoutingTableEntry const & route, bool valid);
+
+  /**
+   * \returns the number of records logged
+   */
+  uint64_t GetRecords () const
+  {
+    return m_records;
+  }
+  /**
+   * \returns the number of bytes written to the file, including the buffered ones
+   */
+  uint64_t GetBytes () const
+  {
+    return m_bytes;
+  }
+
+protected:
+  virtual void DoDispose ();
+
+private:
+  /**
+   * Start a record in the buffer
+   * \param type the type of the record
+   * \param node the node
+   */
+  void BeginRecord (RecordType type, uint32_t node);
+  /// Set the length of the record started and flush the buffer if full
+  void EndRecord ();
+  /**
+   * Append an integer to the buffer
+   * \param value the integer
+   * \param bytes its size
+   */
+  void Append (uint64_t value, uint32_t bytes);
+  /// Flush and schedule the next periodic flush
+  void PeriodicFlush ();
+
+  /**
+   * Trace sink for the packets sent by a node
+   * \param log the log
+   * \param node the node
+   * \param packet the packet
+   * \param ipv4 the IP layer
+   * \param interface the interface
+   */
+  static void LogTx (Ptr<EventLog> log, uint32_t node, Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * Trace sink for the packets received by a node
+   * \param log the log
+   * \param node the node
+   * \param packet the packet
+   * \param ipv4 the IP layer
+   * \param interface the interface
+   */
+  static void LogRx (Ptr<EventLog> log, uint32_t node, Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * Trace sink for the forwarder selections of a node
+   * \param log the log
+   * \param node the node
+   * \param dst the destination of the RREQ
+   * \param candidates the number of forwarder candidates
+   * \param forwarders the forwarders selected
+   */
+  static void LogCluster (Ptr<EventLog> log, uint32_t node, Ipv4Address dst, uint32_t candidates,
+                          const std::vector<Ipv4Address> & forwarders);
+  /**
+   * Trace sink for the route changes of a node
+   * \param log the log
+   * \param node the node
+   * \param route the routing table entry
+   * \param valid whether the route became valid
+   */
+  static void LogRoute (Ptr<EventLog> log, uint32_t node, const RoutingTableEntry & route, bool valid);
+
+  /// The file
+  std::ofstream m_file;
+  /// Records not written yet
+  std::vector<uint8_t> m_buffer;
+  /// Start of the record being appended
+  uint32_t m_recordStart;
+  /// Size of the buffer above which it is written
+  uint32_t m_bufferSize;
+  /// Time between periodic flushes
+  Time m_flushInterval;
+  /// Next periodic flush
+  EventId m_flushEvent;
+  /// Number of records logged
+  uint64_t m_records;
+  /// Number of bytes logged
+  uint64_t m_bytes;
+};
+
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief A record of an EventLog.
+ *
+ * Only the fields of the type of the record are set.
+ */
+struct EventLogRecord
+{
+  EventLog::RecordType m_type; //!< type of the record
+  Time m_time;                 //!< time of the event
+  uint32_t m_node;             //!< node id
+  Ipv4Address m_source;        //!< IP source of a control message
+  Ipv4Address m_destination;   //!< IP destination of a control message
+  uint8_t m_ttl;               //!< IP TTL of a control message
+  Ptr<Packet> m_message;       //!< control message, starting with its TypeHeader
+  Ipv4Address m_dst;           //!< destination of a RREQ or route
+  uint32_t m_candidates;       //!< number of forwarder candidates
+  std::vector<Ipv4Address> m_forwarders; //!< forwarders selected
+  Ipv4Address m_nextHop;       //!< next hop of a route
+  uint32_t m_seqNo;            //!< sequence number of a route
+  uint16_t m_hops;             //!< hop count of a route
+  Time m_lifetime;             //!< lifetime of a route
+};
+
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Reads the records of an EventLog file in order.
+ *
+ * Records of unknown types are skipped, and a record truncated at the end of
+ * the file ends the reading.
+ */
+class EventLogReader
+{
+public:
+  EventLogReader ();
+  /**
+   * Open a file and check its header
+   * \param filename the file name
+   * \returns true if the file is an EventLog of a known version
+   */
+  bool Open (std::string filename);
+  /**
+   * Read the next record
+   * \param record set to the record
+   * \returns false at the end of the file
+   */
+  bool Read (EventLogRecord & record);
+
+private:
+  /// The file
+  std::ifstream m_file;
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_EVENT_LOG_H */
@@ -0,0 +1,252 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-feature-space.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+FeatureDescriptor::FeatureDescriptor ()
+  : m_enabled (true),
+    m_weight (1),
+    m_normalization (NORMALIZE_MIN_MAX),
+    m_min (0),
+    m_max (1),
+    m_ideal (0)
+{
+}
+
+/**
+ * Parse a floating point number
+ * \param value the string
+ * \param number the number
+ * \returns false if the string is not a number
+ */
+static bool
+ParseDouble (std::string const & value, double & number)
+{
+  char * end = 0;
+  number = std::strtod (value.c_str (), &end);
+  return !value.empty () && *end == '\0';
+}
+
+bool
+FeatureDescriptor::Parse (std::string const & spec)
+{
+  FeatureDescriptor d = *this;
+  std::istringstream stream (spec);
+  std::string item;
+  while (std::getline (stream, item, '|'))
+    {
+      if (item.empty ())
+        {
+          continue;
+        }
+      std::string::size_type equal = item.find ('=');
+      if (equal == std::string::npos)
+        {
+          return false;
+        }
+      std::string key = item.substr (0, equal);
+      std::string value = item.substr (equal + 1);
+      if (key == "Enabled")
+        {
+          if (value == "true" || value == "1")
+            {
+              d.m_enabled = true;
+            }
+          else if (value == "false" || value == "0")
+            {
+              d.m_enabled = false;
+            }
+          else
+            {
+              return false;
+            }
+        }
+      else if (key == "Normalization")
+        {
+          if (value == "MinMax")
+            {
+              d.m_normalization = NORMALIZE_MIN_MAX;
+            }
+          else if (value == "ZScore")
+            {
+              d.m_normalization = NORMALIZE_Z_SCORE;
+            }
+          else if (value == "FixedRange")
+            {
+              d.m_normalization = NORMALIZE_FIXED_RANGE;
+            }
+          else
+            {
+              return false;
+            }
+        }
+      else if (key == "Weight")
+        {
+          if (!ParseDouble (value, d.m_weight) || d.m_weight < 0)
+            {
+              return false;
+            }
+        }
+      else if (key == "Min")
+        {
+          if (!ParseDouble (value, d.m_min))
+            {
+              return false;
+            }
+        }
+      else if (key == "Max")
+        {
+          if (!ParseDouble (value, d.m_max))
+            {
+              return false;
+            }
+        }
+      else if (key == "Ideal")
+        {
+          if (!ParseDouble (value, d.m_ideal))
+            {
+              return false;
+            }
+        }
+      else
+        {
+          return false;
+        }
+    }
+  *this = d;
+  return true;
+}
+
+std::string
+FeatureDescriptor::ToString () const
+{
+  static const char * normalizations[] = { "MinMax", "ZScore", "FixedRange" };
+  std::ostringstream os;
+  os << "Enabled=" << (m_enabled ? "true" : "false")
+     << "|Weight=" << m_weight
+     << "|Normalization=" << normalizations[m_normalization]
+     << "|Min=" << m_min
+     << "|Max=" << m_max
+     << "|Ideal=" << m_ideal;
+  return os.str ();
+}
+
+FeatureSpace::FeatureSpace ()
+{
+  // The ideal forwarder is at the destination, without errors, with the default buffer empty
+  m_descriptors[FEATURE_FREE_SPACE].m_normalization = NORMALIZE_FIXED_RANGE;
+  m_descriptors[FEATURE_FREE_SPACE].m_max = 64;
+  m_descriptors[FEATURE_FREE_SPACE].m_ideal = 64;
+  // and an idle channel; the channel load is only advertised on demand
+  m_descriptors[FEATURE_MAC_QUEUE].m_enabled = false;
+  m_descriptors[FEATURE_CHANNEL_BUSY].m_enabled = false;
+  // and a strong link, which is only measured over Wi-Fi
+  m_descriptors[FEATURE_SNR].m_enabled = false;
+  m_descriptors[FEATURE_SNR].m_ideal = 40;
+}
+
+uint32_t
+FeatureSpace::GetDimension () const
+{
+  uint32_t dimension = 0;
+  for (uint32_t f = 0; f < FEATURE_COUNT; f++)
+    {
+      if (m_descriptors[f].m_enabled)
+        {
+          dimension++;
+        }
+    }
+  return dimension;
+}
+
+void
+FeatureSpace::Project (std::vector<std::vector<double> > const & raw,
+                       std::vector<std::vector<double> > & points, std::vector<double> & ideal) const
+{
+  uint32_t n = raw.size ();
+  points.assign (n, std::vector<double> ());
+  ideal.clear ();
+  for (uint32_t f = 0; f < FEATURE_COUNT; f++)
+    {
+      FeatureDescriptor const & d = m_descriptors[f];
+      if (!d.m_enabled)
+        {
+          continue;
+        }
+      // value = (raw - offset) / scale * sqrt (weight)
+      double offset = 0;
+      double scale = 1;
+      // the ideal is kept within the range, so that it does not outweigh the other features
+      double idealValue = d.m_ideal;
+      switch (d.m_normalization)
+        {
+        case NORMALIZE_MIN_MAX:
+          if (n > 0)
+            {
+              double mini = raw[0][f];
+              double maxi = raw[0][f];
+              for (uint32_t i = 1; i < n; i++)
+                {
+                  mini = std::min (mini, raw[i][f]);
+                  maxi = std::max (maxi, raw[i][f]);
+                }
+              offset = mini;
+              scale = maxi - mini;
+              idealValue = std::min (std::max (idealValue, mini), maxi);
+            }
+          break;
+        case NORMALIZE_Z_SCORE:
+          if (n > 0)
+            {
+              double sum = 0;
+              double squares = 0;
+              for (uint32_t i = 0; i < n; i++)
+                {
+                  sum += raw[i][f];
+                  squares += raw[i][f] * raw[i][f];
+                }
+              offset = sum / n;
+              scale = std::sqrt (std::max (0.0, squares / n - offset * offset));
+            }
+          break;
+        case NORMALIZE_FIXED_RANGE:
+          offset = d.m_min;
+          scale = d.m_max - d.m_min;
+          idealValue = std::min (std::max (idealValue, std::min (d.m_min, d.m_max)), std::max (d.m_min, d.m_max));
+          break;
+        }
+      if (scale == 0)
+        {
+          scale = 1;
+        }
+      double factor = std::sqrt (d.m_weight) / scale;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          points[i].push_back ((raw[i][f] - offset) * factor);
+        }
+      ideal.push_back ((idealValue - offset) * factor);
+    }
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_FEATURE_SPACE_H
+#define aodvKmeans_FEATURE_SPACE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+/**
+ * \ingroup aodvKmeans
+ * \brief Normalization of a clustering feature
+ */
+enum FeatureNormalization
+{
+  NORMALIZE_MIN_MAX = 0,      //!< scale the observed range to [0, 1], the ideal is clamped to it
+  NORMALIZE_Z_SCORE = 1,      //!< center on the observed mean, in observed standard deviations
+  NORMALIZE_FIXED_RANGE = 2,  //!< scale a configured range to [0, 1], the ideal is clamped to it
+};
+
+/**
+ * \ingroup aodvKmeans
+ * \brief Description of one feature of forwarder selection
+ *
+ * Descriptors are written as a string, e.g.
+ * "Enabled=true|Weight=1|Normalization=MinMax|Min=0|Max=1|Ideal=0";
+ * omitted keys keep their value.
+ */
+struct FeatureDescriptor
+{
+  /// Indicates whether the feature is used
+  bool m_enabled;
+  /// Weight of the feature in the squared distance between candidates
+  double m_weight;
+  /// Normalization of the feature
+  FeatureNormalization m_normalization;
+  /// Lower end of the range with NORMALIZE_FIXED_RANGE
+  double m_min;
+  /// Upper end of the range with NORMALIZE_FIXED_RANGE
+  double m_max;
+  /// Value of the feature for the ideal forwarder, before normalization
+  double m_ideal;
+
+  FeatureDescriptor ();
+  /**
+   * Update the descriptor from a string
+   * \param spec the string, "Key=value" pairs separated by '|'
+   * \returns false if the string is malformed, the descriptor is then unchanged
+   */
+  bool Parse (std::string const & spec);
+  /**
+   * \returns the descriptor as a string accepted by Parse
+   */
+  std::string ToString () const;
+};
+
+/**
+ * \ingroup aodvKmeans
+ * \brief Feature space in which forwarder candidates are clustered
+ *
+ * Every candidate is described by a row of raw feature values, indexed by
+ * FeatureSpace::Feature.  The space keeps the enabled features, normalizes
+ * each of them and scales it by the square root of its weight, so that
+ * squared euclidean distances are weighted sums.  The ideal forwarder is
+ * projected the same way.  Adding a feature only takes a new Feature value,
+ * a default descriptor and the computation of its raw value.
+ */
+class FeatureSpace
+{
+public:
+  /// Features of a forwarder candidate
+  enum Feature
+  {
+    FEATURE_DISTANCE = 0,     //!< squared distance to the destination, m^2
+    FEATURE_TX_ERROR = 1,     //!< transmission errors of the candidate and of the link to it
+    FEATURE_FREE_SPACE = 2,   //!< free space in the route discovery buffer, packets
+    FEATURE_MAC_QUEUE = 3,    //!< occupancy of the MAC queues, in [0, 1]
+    FEATURE_CHANNEL_BUSY = 4, //!< fraction of time the channel is busy, in [0, 1]
+    FEATURE_SNR = 5,          //!< smoothed SNR of the hellos received over the link to the candidate, dB
+    FEATURE_COUNT = 6,        //!< number of features
+  };
+
+  FeatureSpace ();
+  /**
+   * Set the descriptor of a feature
+   * \param feature the feature
+   * \param descriptor the descriptor
+   */
+  void SetDescriptor (Feature feature, FeatureDescriptor const & descriptor)
+  {
+    m_descriptors[feature] = descriptor;
+  }
+  /**
+   * \param feature the feature
+   * \returns the descriptor of the feature
+   */
+  FeatureDescriptor const & GetDescriptor (Feature feature) const
+  {
+    return m_descriptors[feature];
+  }
+  /**
+   * \returns the number of enabled features
+   */
+  uint32_t GetDimension () const;
+  /**
+   * Project candidates into the normalized, weighted space
+   * \param raw one row of FEATURE_COUNT raw values per candidate
+   * \param points the projected candidates, GetDimension () values each
+   * \param ideal the projected ideal forwarder
+   */
+  void Project (std::vector<std::vector<double> > const & raw,
+                std::vector<std::vector<double> > & points, std::vector<double> & ideal) const;
+
+private:
+  /// Descriptor of each feature
+  FeatureDescriptor m_descriptors[FEATURE_COUNT];
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_FEATURE_SPACE_H */
@@ -26,6 +26,7 @@
  *          Pavel Boyko <boyko@iitp.ru>
  */
 #include "aodvKmeans-id-cache.h"
+#include "aodvKmeans-memory-usage.h"
 #include <algorithm>
 
 namespace ns3 {
@@ -33,27 +34,73 @@ namespace aodvKmeans {
 bool
 IdCache::IsDuplicate (Ipv4Address addr, uint32_t id)
 {
-  Purge ();
-  for (std::vector<UniqueId>::const_iterator i = m_idCache.begin ();
-       i != m_idCache.end (); ++i)
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  PurgeBuckets (now);
+  uint64_t key = MakeKey (addr, id);
+  int64_t expire = now + m_lifetime.GetTimeStep ();
+  std::pair<std::unordered_map<uint64_t, int64_t>::iterator, bool> result =
+    m_idCache.insert (std::make_pair (key, expire));
+  if (!result.second)
     {
-      if (i->m_context == addr && i->m_id == id)
+      if (result.first->second >= now)
         {
           return true;
         }
+      // Expired record still waiting in a partially elapsed bucket, reuse it
+      result.first->second = expire;
     }
-  struct UniqueId uniqueId =
-  {
-    addr, id, m_lifetime + Simulator::Now ()
-  };
-  m_idCache.push_back (uniqueId);
+  int64_t bucketEnd = (expire / m_bucketWidth + 1) * m_bucketWidth;
+  m_buckets[bucketEnd].push_back (key);
   return false;
 }
+
+void
+IdCache::PurgeBuckets (int64_t now)
+{
+  while (!m_buckets.empty () && m_buckets.begin ()->first <= now)
+    {
+      std::vector<uint64_t> const & keys = m_buckets.begin ()->second;
+      for (std::vector<uint64_t>::const_iterator k = keys.begin (); k != keys.end (); ++k)
+        {
+          std::unordered_map<uint64_t, int64_t>::iterator i = m_idCache.find (*k);
+          // The key may have been refreshed into a later bucket
+          if (i != m_idCache.end () && i->second < now)
+            {
+              m_idCache.erase (i);
+            }
+        }
+      m_buckets.erase (m_buckets.begin ());
+    }
+}
+
 void
 IdCache::Purge ()
 {
-  m_idCache.erase (remove_if (m_idCache.begin (), m_idCache.end (),
-                              IsExpired ()), m_idCache.end ());
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  PurgeBuckets (now);
+  if (m_buckets.empty ())
+    {
+      return;
+    }
+  // Only the first bucket may still hold expired entries
+  std::vector<uint64_t> & keys = m_buckets.begin ()->second;
+  for (std::vector<uint64_t>::iterator k = keys.begin (); k != keys.end (); )
+    {
+      std::unordered_map<uint64_t, int64_t>::iterator i = m_idCache.find (*k);
+      if (i == m_idCache.end () || i->second < now)
+        {
+          if (i != m_idCache.end ())
+            {
+              m_idCache.erase (i);
+            }
+          *k = keys.back ();
+          keys.pop_back ();
+        }
+      else
+        {
+          ++k;
+        }
+    }
 }
 
 uint32_t
@@ -63,5 +110,16 @@ IdCache::GetSize ()
   return m_idCache.size ();
 }
 
+uint64_t
+IdCache::GetMemoryBytes () const
+{
+  uint64_t bytes = MemoryBytes (m_idCache) + MemoryBytes (m_buckets);
+  for (std::map<int64_t, std::vector<uint64_t> >::const_iterator i = m_buckets.begin (); i != m_buckets.end (); ++i)
+    {
+      bytes += MemoryBytes (i->second);
+    }
+  return bytes;
+}
+
 }
 }
@@ -31,6 +31,9 @@
 
 #include "ns3/ipv4-address.h"
 #include "ns3/simulator.h"
+#include <algorithm>
+#include <map>
+#include <unordered_map>
 #include <vector>
 
 namespace ns3 {
@@ -39,6 +42,11 @@ namespace aodvKmeans {
  * \ingroup aodvKmeans
  *
  * \brief Unique packets identification cache used for simple duplicate detection.
+ *
+ * Entries are kept in a hash table keyed by (address, id), so a lookup does
+ * not depend on the number of cached entries.  Every entry is also filed in an
+ * expiry bucket covering a slice of time; buckets whose slice has fully elapsed
+ * are released as a whole, which makes purging amortized O(1) per entry.
  */
 class IdCache
 {
@@ -47,8 +55,9 @@ public:
    * constructor
    * \param lifetime the lifetime for added entries
    */
-  IdCache (Time lifetime) : m_lifetime (lifetime)
+  IdCache (Time lifetime)
   {
+    SetLifetime (lifetime);
   }
   /**
    * Check that entry (addr, id) exists in cache. Add entry, if it doesn't exist.
@@ -63,6 +72,17 @@ public:
    * \returns number of entries in cache
    */
   uint32_t GetSize ();
+  /**
+   * \returns number of expiry buckets in use
+   */
+  uint32_t GetBucketCount () const
+  {
+    return m_buckets.size ();
+  }
+  /**
+   * \returns the estimated memory held by the cache and its buckets, bytes
+   */
+  uint64_t GetMemoryBytes () const;
   /**
    * Set lifetime for future added entries.
    * \param lifetime the lifetime for entries
@@ -70,6 +90,7 @@ public:
   void SetLifetime (Time lifetime)
   {
     m_lifetime = lifetime;
+    m_bucketWidth = std::max<int64_t> (lifetime.GetTimeStep () / BUCKETS_PER_LIFETIME, 1);
   }
   /**
    * Return lifetime for existing entries in cache
@@ -80,36 +101,32 @@ public:
     return m_lifetime;
   }
 private:
-  /// Unique packet ID
-  struct UniqueId
-  {
-    /// ID is supposed to be unique in single address context (e.g. sender address)
-    Ipv4Address m_context;
-    /// The id
-    uint32_t m_id;
-    /// When record will expire
-    Time m_expire;
-  };
+  /// Number of expiry buckets a lifetime is split into
+  static const int64_t BUCKETS_PER_LIFETIME = 16;
   /**
-   * \brief IsExpired structure
+   * Build the hash key of a unique packet ID
+   * \param addr the IP address, ID is supposed to be unique in single address context (e.g. sender address)
+   * \param id the ID
+   * \returns the key
    */
-  struct IsExpired
+  static uint64_t MakeKey (Ipv4Address addr, uint32_t id)
   {
-    /**
-     * \brief Check if the entry is expired
-     *
-     * \param u UniqueId entry
-     * \return true if expired, false otherwise
-     */
-    bool operator() (const struct UniqueId & u) const
-    {
-      return (u.m_expire < Simulator::Now ());
-    }
-  };
-  /// Already seen IDs
-  std::vector<UniqueId> m_idCache;
+    return (static_cast<uint64_t> (addr.Get ()) << 32) | id;
+  }
+  /**
+   * Remove the buckets whose time slice has fully elapsed
+   * \param now the current time step
+   */
+  void PurgeBuckets (int64_t now);
+
+  /// Already seen IDs, key -> expiration time step
+  std::unordered_map<uint64_t, int64_t> m_idCache;
+  /// Expiry buckets, end of the time slice -> keys expiring within the slice
+  std::map<int64_t, std::vector<uint64_t> > m_buckets;
   /// Default lifetime for ID records
   Time m_lifetime;
+  /// Width of the time slice of a bucket, time steps
+  int64_t m_bucketWidth;
 };
 
 }  // namespace aodvKmeans
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-latency-histogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+LatencyHistogram::LatencyHistogram ()
+  : m_count (0)
+{
+}
+
+int32_t
+LatencyHistogram::GetBucket (Time latency)
+{
+  double ns = std::max<double> (1, latency.GetNanoSeconds ());
+  return static_cast<int32_t> (std::floor (std::log2 (ns) * BUCKETS_PER_OCTAVE));
+}
+
+Time
+LatencyHistogram::GetBucketCenter (int32_t bucket)
+{
+  return NanoSeconds (static_cast<int64_t> (std::llround (std::exp2 ((bucket + 0.5) / BUCKETS_PER_OCTAVE))));
+}
+
+void
+LatencyHistogram::Add (Time latency)
+{
+  m_buckets[GetBucket (latency)]++;
+  m_count++;
+}
+
+void
+LatencyHistogram::Merge (LatencyHistogram const & other)
+{
+  for (std::map<int32_t, uint64_t>::const_iterator i = other.m_buckets.begin (); i != other.m_buckets.end (); ++i)
+    {
+      m_buckets[i->first] += i->second;
+    }
+  m_count += other.m_count;
+}
+
+Time
+LatencyHistogram::GetPercentile (double p) const
+{
+  if (m_count == 0)
+    {
+      return Seconds (0);
+    }
+  // rank of the sample, from 1
+  uint64_t rank = std::max<uint64_t> (1, static_cast<uint64_t> (std::ceil (std::min (std::max (p, 0.0), 1.0) * m_count)));
+  uint64_t seen = 0;
+  for (std::map<int32_t, uint64_t>::const_iterator i = m_buckets.begin (); i != m_buckets.end (); ++i)
+    {
+      seen += i->second;
+      if (seen >= rank)
+        {
+          return GetBucketCenter (i->first);
+        }
+    }
+  return GetBucketCenter (m_buckets.rbegin ()->first);
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_LATENCY_HISTOGRAM_H
+#define aodvKmeans_LATENCY_HISTOGRAM_H
+
+#include <map>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+namespace aodvKmeans {
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Histogram of latencies with logarithmic buckets.
+ *
+ * Each octave of nanoseconds is split into BUCKETS_PER_OCTAVE buckets, so that a
+ * percentile is known within 9%, whatever the scale of the latencies.  Only
+ * the buckets holding a sample are stored.
+ */
+class LatencyHistogram
+{
+public:
+  /// Number of buckets per doubling of the latency
+  static const uint32_t BUCKETS_PER_OCTAVE = 4;
+
+  LatencyHistogram ();
+  /**
+   * Add a sample
+   * \param latency the latency, latencies below 1 ns count as 1 ns
+   */
+  void Add (Time latency);
+  /**
+   * Add the samples of another histogram
+   * \param other the other histogram
+   */
+  void Merge (LatencyHistogram const & other);
+  /**
+   * \returns the number of samples
+   */
+  uint64_t GetCount () const
+  {
+    return m_count;
+  }
+  /**
+   * Get a percentile of the samples
+   * \param p the percentile, in [0, 1]
+   * \returns the geometric center of the bucket holding the percentile, 0 without samples
+   */
+  Time GetPercentile (double p) const;
+  /// Remove all samples
+  void Clear ()
+  {
+    m_buckets.clear ();
+    m_count = 0;
+  }
+
+private:
+  /**
+   * \param latency a latency
+   * \returns the bucket of the latency
+   */
+  static int32_t GetBucket (Time latency);
+  /**
+   * \param bucket a bucket
+   * \returns the geometric center of the bucket
+   */
+  static Time GetBucketCenter (int32_t bucket);
+
+  /// Number of samples in each non empty bucket
+  std::map<int32_t, uint64_t> m_buckets;
+  /// Number of samples
+  uint64_t m_count;
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_LATENCY_HISTOGRAM_H */
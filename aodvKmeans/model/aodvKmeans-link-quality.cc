@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-link-quality.h"
+#include "aodvKmeans-memory-usage.h"
+#include "ns3/simulator.h"
+#include <cmath>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+/// Decayed error count below which a link is forgotten
+static const double LINK_QUALITY_EPSILON = 1e-3;
+/// Number of records between two purges
+static const uint32_t LINK_QUALITY_PURGE_PERIOD = 64;
+
+LinkQualityTable::LinkQualityTable (Time halfLife)
+  : m_halfLife (halfLife),
+    m_recordsSincePurge (0)
+{
+}
+
+double
+LinkQualityTable::Decay (Sample const & s) const
+{
+  if (s.m_value == 0 || !m_halfLife.IsStrictlyPositive ())
+    {
+      return s.m_value;
+    }
+  double age = (Simulator::Now () - s.m_time).GetSeconds ();
+  return s.m_value * std::pow (0.5, age / m_halfLife.GetSeconds ());
+}
+
+double
+LinkQualityTable::ToRate (double value) const
+{
+  // A stream of r errors per second converges to r * halfLife / ln 2
+  if (!m_halfLife.IsStrictlyPositive ())
+    {
+      return value;
+    }
+  return value * std::log (2.0) / m_halfLife.GetSeconds ();
+}
+
+void
+LinkQualityTable::RecordTxError (Mac48Address receiver)
+{
+  Sample & s = m_links[receiver];
+  s.m_value = Decay (s) + 1;
+  s.m_time = Simulator::Now ();
+  m_node.m_value = Decay (m_node) + 1;
+  m_node.m_time = Simulator::Now ();
+  if (++m_recordsSincePurge >= LINK_QUALITY_PURGE_PERIOD)
+    {
+      Purge ();
+    }
+}
+
+double
+LinkQualityTable::GetErrorRate (Mac48Address receiver)
+{
+  std::map<Mac48Address, Sample>::const_iterator i = m_links.find (receiver);
+  if (i == m_links.end ())
+    {
+      return 0;
+    }
+  return ToRate (Decay (i->second));
+}
+
+double
+LinkQualityTable::GetNodeErrorRate () const
+{
+  return ToRate (Decay (m_node));
+}
+
+void
+LinkQualityTable::SetHalfLife (Time halfLife)
+{
+  // Fold the past decay into the samples before the half-life changes
+  for (std::map<Mac48Address, Sample>::iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      i->second.m_value = Decay (i->second);
+      i->second.m_time = Simulator::Now ();
+    }
+  m_node.m_value = Decay (m_node);
+  m_node.m_time = Simulator::Now ();
+  m_halfLife = halfLife;
+}
+
+void
+LinkQualityTable::Purge ()
+{
+  m_recordsSincePurge = 0;
+  for (std::map<Mac48Address, Sample>::iterator i = m_links.begin (); i != m_links.end (); )
+    {
+      if (Decay (i->second) < LINK_QUALITY_EPSILON)
+        {
+          m_links.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+uint64_t
+LinkQualityTable::GetMemoryBytes () const
+{
+  return MemoryBytes (m_links);
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
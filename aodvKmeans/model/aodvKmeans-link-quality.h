@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_LINK_QUALITY_H
+#define aodvKmeans_LINK_QUALITY_H
+
+#include <map>
+#include "ns3/nstime.h"
+#include "ns3/mac48-address.h"
+
+namespace ns3 {
+namespace aodvKmeans {
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Per-link, time decayed transmission error statistics.
+ *
+ * Every MPDU dropped by the MAC is charged to its receiver.  The error count of a
+ * link decays exponentially with a configurable half-life, so that it follows the
+ * current channel conditions rather than the age of the node.  A node-wide value,
+ * advertised in hellos, decays the same way.
+ */
+class LinkQualityTable
+{
+public:
+  /**
+   * constructor
+   * \param halfLife the time after which a past error weighs half
+   */
+  LinkQualityTable (Time halfLife);
+  /**
+   * Record a transmission error
+   * \param receiver the receiver of the dropped MPDU
+   */
+  void RecordTxError (Mac48Address receiver);
+  /**
+   * Get the decayed error rate of a link
+   * \param receiver the receiver address of the link
+   * \returns the error rate, errors per second
+   */
+  double GetErrorRate (Mac48Address receiver);
+  /**
+   * Get the decayed error rate of all links of the node
+   * \returns the error rate, errors per second
+   */
+  double GetNodeErrorRate () const;
+  /**
+   * Set the half-life of recorded errors
+   * \param halfLife the half-life
+   */
+  void SetHalfLife (Time halfLife);
+  /**
+   * \returns the half-life of recorded errors
+   */
+  Time GetHalfLife () const
+  {
+    return m_halfLife;
+  }
+  /**
+   * \returns the number of links with a recorded error
+   */
+  uint32_t GetSize () const
+  {
+    return m_links.size ();
+  }
+  /**
+   * \returns the estimated memory held by the error counts, bytes
+   */
+  uint64_t GetMemoryBytes () const;
+  /// Forget links whose error count decayed to nothing
+  void Purge ();
+  /// Forget all links
+  void Clear ()
+  {
+    m_links.clear ();
+    m_node = Sample ();
+  }
+
+private:
+  /// Decayed error count
+  struct Sample
+  {
+    /// Error count at m_time
+    double m_value;
+    /// Time of the last update
+    Time m_time;
+    Sample ()
+      : m_value (0)
+    {
+    }
+  };
+  /**
+   * Value of a sample at the current time
+   * \param s the sample
+   * \returns the decayed error count
+   */
+  double Decay (Sample const & s) const;
+  /**
+   * Convert a decayed error count into a rate
+   * \param value the decayed error count
+   * \returns the error rate, errors per second
+   */
+  double ToRate (double value) const;
+
+  /// Error count of each link
+  std::map<Mac48Address, Sample> m_links;
+  /// Error count of the node
+  Sample m_node;
+  /// Half-life of recorded errors
+  Time m_halfLife;
+  /// Number of records since the last purge
+  uint32_t m_recordsSincePurge;
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_LINK_QUALITY_H */
@@ -0,0 +1,184 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-location-cache.h"
+#include "aodvKmeans-memory-usage.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+/// Number of updates between two purges
+static const uint32_t LOCATION_CACHE_PURGE_PERIOD = 64;
+
+LocationCache::LocationCache (uint32_t capacity, Time maxAge)
+  : m_capacity (capacity),
+    m_maxAge (maxAge),
+    m_maxExtrapolation (Seconds (0)),
+    m_maxSpeed (20),
+    m_confidenceRadius (250),
+    m_updatesSincePurge (0),
+    m_evictions (0)
+{
+}
+
+bool
+LocationCache::Update (Ipv4Address node, Vector position, Time sampled)
+{
+  if (++m_updatesSincePurge >= LOCATION_CACHE_PURGE_PERIOD)
+    {
+      Purge ();
+    }
+  std::unordered_map<Ipv4Address, Entry, Ipv4AddressHash>::iterator i = m_locations.find (node);
+  if (i != m_locations.end ())
+    {
+      if (i->second.m_location.m_sampled > sampled)
+        {
+          return false;
+        }
+      m_lru.splice (m_lru.begin (), m_lru, i->second.m_lru);
+    }
+  else
+    {
+      if (m_capacity == 0)
+        {
+          return false;
+        }
+      while (m_locations.size () >= m_capacity)
+        {
+          Erase (m_locations.find (m_lru.back ()));
+          m_evictions++;
+        }
+      m_lru.push_front (node);
+      i = m_locations.insert (std::make_pair (node, Entry ())).first;
+      i->second.m_lru = m_lru.begin ();
+    }
+  Location & location = i->second.m_location;
+  location.m_position = position;
+  location.m_hasVelocity = false;
+  location.m_sampled = sampled;
+  return true;
+}
+
+void
+LocationCache::SetVelocity (Ipv4Address node, Vector velocity)
+{
+  std::unordered_map<Ipv4Address, Entry, Ipv4AddressHash>::iterator i = m_locations.find (node);
+  if (i != m_locations.end ())
+    {
+      i->second.m_location.m_velocity = velocity;
+      i->second.m_location.m_hasVelocity = true;
+    }
+}
+
+bool
+LocationCache::Lookup (Ipv4Address node, Location & location)
+{
+  std::unordered_map<Ipv4Address, Entry, Ipv4AddressHash>::iterator i = m_locations.find (node);
+  if (i == m_locations.end ())
+    {
+      return false;
+    }
+  if (Simulator::Now () - i->second.m_location.m_sampled > m_maxAge)
+    {
+      Erase (i);
+      return false;
+    }
+  m_lru.splice (m_lru.begin (), m_lru, i->second.m_lru);
+  location = i->second.m_location;
+  return true;
+}
+
+Vector
+LocationCache::GetEstimate (Location const & location) const
+{
+  Vector estimate = location.m_position;
+  if (location.m_hasVelocity)
+    {
+      Time age = std::min (std::max (Simulator::Now () - location.m_sampled, Seconds (0)), m_maxExtrapolation);
+      estimate.x += location.m_velocity.x * age.GetSeconds ();
+      estimate.y += location.m_velocity.y * age.GetSeconds ();
+    }
+  return estimate;
+}
+
+double
+LocationCache::GetErrorRadius (Location const & location) const
+{
+  Time age = std::max (Simulator::Now () - location.m_sampled, Seconds (0));
+  return m_maxSpeed * age.GetSeconds ();
+}
+
+std::vector<std::pair<Ipv4Address, LocationCache::Location> >
+LocationCache::GetLocations () const
+{
+  std::vector<std::pair<Ipv4Address, Location> > locations;
+  for (std::list<Ipv4Address>::const_iterator i = m_lru.begin (); i != m_lru.end (); ++i)
+    {
+      Location const & location = m_locations.find (*i)->second.m_location;
+      if (Simulator::Now () - location.m_sampled <= m_maxAge)
+        {
+          locations.push_back (std::make_pair (*i, location));
+        }
+    }
+  return locations;
+}
+
+void
+LocationCache::Purge ()
+{
+  m_updatesSincePurge = 0;
+  for (std::unordered_map<Ipv4Address, Entry, Ipv4AddressHash>::iterator i = m_locations.begin (); i != m_locations.end (); )
+    {
+      if (Simulator::Now () - i->second.m_location.m_sampled > m_maxAge)
+        {
+          m_lru.erase (i->second.m_lru);
+          i = m_locations.erase (i);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+void
+LocationCache::SetCapacity (uint32_t capacity)
+{
+  m_capacity = capacity;
+  while (m_locations.size () > m_capacity)
+    {
+      Erase (m_locations.find (m_lru.back ()));
+      m_evictions++;
+    }
+}
+
+void
+LocationCache::Erase (std::unordered_map<Ipv4Address, Entry, Ipv4AddressHash>::iterator i)
+{
+  m_lru.erase (i->second.m_lru);
+  m_locations.erase (i);
+}
+
+uint64_t
+LocationCache::GetMemoryBytes () const
+{
+  return MemoryBytes (m_locations) + MemoryBytes (m_lru);
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
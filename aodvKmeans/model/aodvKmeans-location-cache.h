@@ -0,0 +1,244 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_LOCATION_CACHE_H
+#define aodvKmeans_LOCATION_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+namespace aodvKmeans {
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Bounded cache of the last known positions of other nodes.
+ *
+ * Each position is kept with the time it was sampled at and, when known, the
+ * velocity of the node.  Positions older than the maximum age are forgotten, and
+ * the least recently used one is evicted when the cache is full.  The error of a
+ * cached position is bounded by the distance the node may have covered since it
+ * was sampled; positions whose error radius exceeds the confidence radius should
+ * not be used to steer route discovery.
+ */
+class LocationCache
+{
+public:
+  /// A cached position
+  struct Location
+  {
+    /// Position of the node
+    Vector m_position;
+    /// Velocity of the node, if m_hasVelocity
+    Vector m_velocity;
+    /// Indicates whether the velocity is known
+    bool m_hasVelocity;
+    /// Time the position was sampled at
+    Time m_sampled;
+    Location ()
+      : m_hasVelocity (false)
+    {
+    }
+  };
+
+  /**
+   * constructor
+   * \param capacity the maximum number of cached positions
+   * \param maxAge the age after which a position is forgotten
+   */
+  LocationCache (uint32_t capacity, Time maxAge);
+  /**
+   * Remember the position of a node, unless a more recently sampled one is known
+   * \param node the node
+   * \param position the position
+   * \param sampled the time the position was sampled at
+   * \returns true if the position was remembered
+   */
+  bool Update (Ipv4Address node, Vector position, Time sampled);
+  /**
+   * Set the velocity of a node, sampled with its cached position
+   * \param node the node
+   * \param velocity the velocity
+   */
+  void SetVelocity (Ipv4Address node, Vector velocity);
+  /**
+   * Look up the position of a node, and mark it as recently used
+   * \param node the node
+   * \param location the cached position
+   * \returns true if a position younger than the maximum age is known
+   */
+  bool Lookup (Ipv4Address node, Location & location);
+  /**
+   * Get the estimated current position of a node
+   * \param location the cached position
+   * \returns the position, extrapolated by at most the maximum extrapolation
+   */
+  Vector GetEstimate (Location const & location) const;
+  /**
+   * Get the error radius of a cached position
+   * \param location the cached position
+   * \returns the distance, in meters, the node may have covered since it was sampled
+   */
+  double GetErrorRadius (Location const & location) const;
+  /**
+   * \param location the cached position
+   * \returns true if the error radius is within the confidence radius
+   */
+  bool IsConfident (Location const & location) const
+  {
+    return GetErrorRadius (location) <= m_confidenceRadius;
+  }
+  /**
+   * Get all cached positions younger than the maximum age
+   * \returns the nodes and their positions, least recently used last
+   */
+  std::vector<std::pair<Ipv4Address, Location> > GetLocations () const;
+  /// Forget the positions older than the maximum age, done every few updates
+  void Purge ();
+  /**
+   * \returns the number of cached positions
+   */
+  uint32_t GetSize () const
+  {
+    return m_locations.size ();
+  }
+  /**
+   * \returns the estimated memory held by the cached positions, bytes
+   */
+  uint64_t GetMemoryBytes () const;
+  /**
+   * Set the maximum number of cached positions
+   * \param capacity the capacity, the least recently used positions are evicted
+   */
+  void SetCapacity (uint32_t capacity);
+  /**
+   * \returns the maximum number of cached positions
+   */
+  uint32_t GetCapacity () const
+  {
+    return m_capacity;
+  }
+  /**
+   * \returns the number of positions evicted to make room for others
+   */
+  uint64_t GetEvictions () const
+  {
+    return m_evictions;
+  }
+  /**
+   * Set the age after which a position is forgotten
+   * \param maxAge the maximum age
+   */
+  void SetMaxAge (Time maxAge)
+  {
+    m_maxAge = maxAge;
+  }
+  /**
+   * \returns the age after which a position is forgotten
+   */
+  Time GetMaxAge () const
+  {
+    return m_maxAge;
+  }
+  /**
+   * Set the longest extrapolation of positions with a known velocity
+   * \param t the longest extrapolation
+   */
+  void SetMaxExtrapolation (Time t)
+  {
+    m_maxExtrapolation = t;
+  }
+  /**
+   * Set the speed bounding the movement of nodes
+   * \param speed the speed, m/s
+   */
+  void SetMaxSpeed (double speed)
+  {
+    m_maxSpeed = speed;
+  }
+  /**
+   * \returns the speed bounding the movement of nodes, m/s
+   */
+  double GetMaxSpeed () const
+  {
+    return m_maxSpeed;
+  }
+  /**
+   * Set the largest error radius of a position still used
+   * \param radius the radius, meters
+   */
+  void SetConfidenceRadius (double radius)
+  {
+    m_confidenceRadius = radius;
+  }
+  /**
+   * \returns the largest error radius of a position still used, meters
+   */
+  double GetConfidenceRadius () const
+  {
+    return m_confidenceRadius;
+  }
+  /// Forget all positions
+  void Clear ()
+  {
+    m_locations.clear ();
+    m_lru.clear ();
+  }
+
+private:
+  /// A cached position and its place in the LRU list
+  struct Entry
+  {
+    /// The position
+    Location m_location;
+    /// Place of the node in m_lru
+    std::list<Ipv4Address>::iterator m_lru;
+  };
+  /**
+   * Forget the position of a node
+   * \param i the entry
+   */
+  void Erase (std::unordered_map<Ipv4Address, Entry, Ipv4AddressHash>::iterator i);
+
+  /// Cached positions
+  std::unordered_map<Ipv4Address, Entry, Ipv4AddressHash> m_locations;
+  /// Nodes, most recently used first
+  std::list<Ipv4Address> m_lru;
+  /// Maximum number of cached positions
+  uint32_t m_capacity;
+  /// Age after which a position is forgotten
+  Time m_maxAge;
+  /// Longest extrapolation of positions with a known velocity
+  Time m_maxExtrapolation;
+  /// Speed bounding the movement of nodes, m/s
+  double m_maxSpeed;
+  /// Largest error radius of a position still used, meters
+  double m_confidenceRadius;
+  /// Number of updates since the last purge
+  uint32_t m_updatesSincePurge;
+  /// Number of positions evicted to make room for others
+  uint64_t m_evictions;
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_LOCATION_CACHE_H */
@@ -0,0 +1,231 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_LRU_CACHE_H
+#define aodvKmeans_LRU_CACHE_H
+
+#include <functional>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <stdint.h>
+#include "aodvKmeans-memory-usage.h"
+
+namespace ns3 {
+namespace aodvKmeans {
+
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Bounded map evicting its least recently used entries.
+ *
+ * When an entry is added to a full cache, the least recently used entry that
+ * may be evicted is removed first.  An optional predicate protects entries from
+ * eviction, such as running timers; if no entry may be evicted, the cache
+ * grows beyond its capacity until entries are erased.  The values are never
+ * moved, so references to them stay valid until they are erased or evicted.
+ */
+template <typename K, typename V, typename H = std::hash<K> >
+class LruCache
+{
+public:
+  /// An entry, key and value
+  typedef std::pair<K, V> Item;
+  /// Iterator on the entries, most recently used first
+  typedef typename std::list<Item>::const_iterator ConstIterator;
+  /// Predicate telling whether a value may be evicted
+  typedef bool (* EvictablePredicate)(V const & value);
+
+  /**
+   * constructor
+   * \param capacity the maximum number of entries
+   */
+  explicit LruCache (uint32_t capacity)
+    : m_capacity (capacity),
+      m_evictable (0),
+      m_evictions (0)
+  {
+  }
+  /**
+   * Set the predicate telling whether a value may be evicted, all may by default
+   * \param evictable the predicate
+   */
+  void SetEvictable (EvictablePredicate evictable)
+  {
+    m_evictable = evictable;
+  }
+  /**
+   * Look up an entry, and mark it as recently used
+   * \param key the key
+   * \returns the value, or 0 if there is no entry for the key
+   */
+  V * Find (K const & key)
+  {
+    typename Index::iterator i = m_index.find (key);
+    if (i == m_index.end ())
+      {
+        return 0;
+      }
+    m_items.splice (m_items.begin (), m_items, i->second);
+    return &i->second->second;
+  }
+  /**
+   * Look up an entry, adding it with a default value if there is none, and mark
+   * it as recently used
+   * \param key the key
+   * \returns the value
+   */
+  V & Get (K const & key)
+  {
+    V * value = Find (key);
+    if (value != 0)
+      {
+        return *value;
+      }
+    while (m_items.size () >= m_capacity && EvictOne ())
+      {
+      }
+    m_items.push_front (Item (key, V ()));
+    m_index[key] = m_items.begin ();
+    return m_items.front ().second;
+  }
+  /**
+   * Set the value of an entry, and mark it as recently used
+   * \param key the key
+   * \param value the value
+   */
+  void Put (K const & key, V const & value)
+  {
+    Get (key) = value;
+  }
+  /**
+   * Erase an entry
+   * \param key the key
+   * \returns true if there was an entry for the key
+   */
+  bool Erase (K const & key)
+  {
+    typename Index::iterator i = m_index.find (key);
+    if (i == m_index.end ())
+      {
+        return false;
+      }
+    m_items.erase (i->second);
+    m_index.erase (i);
+    return true;
+  }
+  /// Erase all entries
+  void Clear ()
+  {
+    m_index.clear ();
+    m_items.clear ();
+  }
+  /**
+   * \returns the number of entries
+   */
+  uint32_t GetSize () const
+  {
+    return m_items.size ();
+  }
+  /**
+   * \returns the maximum number of entries
+   */
+  uint32_t GetCapacity () const
+  {
+    return m_capacity;
+  }
+  /**
+   * Set the maximum number of entries, evicting the least recently used ones
+   * beyond it
+   * \param capacity the maximum number of entries
+   */
+  void SetCapacity (uint32_t capacity)
+  {
+    m_capacity = capacity;
+    while (m_items.size () > m_capacity && EvictOne ())
+      {
+      }
+  }
+  /**
+   * \returns the number of entries evicted
+   */
+  uint64_t GetEvictions () const
+  {
+    return m_evictions;
+  }
+  /**
+   * \returns the estimated memory held by the entries, bytes
+   */
+  uint64_t GetMemoryBytes () const
+  {
+    return MemoryBytes (m_items) + MemoryBytes (m_index);
+  }
+  /**
+   * \returns an iterator on the most recently used entry
+   */
+  ConstIterator Begin () const
+  {
+    return m_items.begin ();
+  }
+  /**
+   * \returns the iterator past the least recently used entry
+   */
+  ConstIterator End () const
+  {
+    return m_items.end ();
+  }
+
+private:
+  /// Index of the entries by key
+  typedef std::unordered_map<K, typename std::list<Item>::iterator, H> Index;
+
+  /**
+   * Evict the least recently used entry that may be evicted
+   * \returns false if no entry may be evicted
+   */
+  bool EvictOne ()
+  {
+    for (typename std::list<Item>::reverse_iterator i = m_items.rbegin (); i != m_items.rend (); ++i)
+      {
+        if (m_evictable == 0 || m_evictable (i->second))
+          {
+            typename std::list<Item>::iterator item = std::next (i).base ();
+            m_index.erase (item->first);
+            m_items.erase (item);
+            m_evictions++;
+            return true;
+          }
+      }
+    return false;
+  }
+
+  /// Entries, most recently used first
+  std::list<Item> m_items;
+  /// Index of the entries by key
+  Index m_index;
+  /// Maximum number of entries
+  uint32_t m_capacity;
+  /// Predicate telling whether a value may be evicted, 0 if all may
+  EvictablePredicate m_evictable;
+  /// Number of entries evicted
+  uint64_t m_evictions;
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_LRU_CACHE_H */
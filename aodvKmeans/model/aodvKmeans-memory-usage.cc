@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-memory-usage.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+namespace aodvKmeans {
+
+MemoryUsage::MemoryUsage ()
+{
+  for (uint32_t c = 0; c < MEMORY_COMPONENT_COUNT; c++)
+    {
+      m_bytes[c] = 0;
+      m_evictions[c] = 0;
+    }
+}
+
+void
+MemoryUsage::Add (Component component, uint64_t bytes)
+{
+  m_bytes[component] += bytes;
+}
+
+uint64_t
+MemoryUsage::GetBytes (Component component) const
+{
+  return m_bytes[component];
+}
+
+uint64_t
+MemoryUsage::GetTotalBytes () const
+{
+  uint64_t total = 0;
+  for (uint32_t c = 0; c < MEMORY_COMPONENT_COUNT; c++)
+    {
+      total += m_bytes[c];
+    }
+  return total;
+}
+
+void
+MemoryUsage::AddEvictions (Component component, uint64_t evictions)
+{
+  m_evictions[component] += evictions;
+}
+
+uint64_t
+MemoryUsage::GetEvictions (Component component) const
+{
+  return m_evictions[component];
+}
+
+std::string
+MemoryUsage::GetComponentName (Component component)
+{
+  switch (component)
+    {
+    case MEMORY_ROUTING_TABLE:
+      return "routingTable";
+    case MEMORY_PRECURSORS:
+      return "precursors";
+    case MEMORY_REQUEST_QUEUE:
+      return "requestQueue";
+    case MEMORY_QUEUED_PACKETS:
+      return "queuedPackets";
+    case MEMORY_ID_CACHE:
+      return "idCache";
+    case MEMORY_DPD:
+      return "dpd";
+    case MEMORY_NEIGHBORS:
+      return "neighbors";
+    case MEMORY_LOCATION_CACHE:
+      return "locationCache";
+    case MEMORY_CLUSTER_CACHE:
+      return "clusterCache";
+    case MEMORY_REQUEST_TIMERS:
+      return "requestTimers";
+    case MEMORY_OTHER_TABLES:
+      return "otherTables";
+    default:
+      return "unknown";
+    }
+}
+
+void
+MemoryUsage::PrintHeader (std::ostream & os)
+{
+  os << "time,node,component,bytes,evictions" << std::endl;
+}
+
+void
+MemoryUsage::Print (std::ostream & os, uint32_t node) const
+{
+  uint64_t evictions = 0;
+  for (uint32_t c = 0; c < MEMORY_COMPONENT_COUNT; c++)
+    {
+      os << Simulator::Now ().GetSeconds () << "," << node << "," << GetComponentName (Component (c))
+         << "," << m_bytes[c] << "," << m_evictions[c] << std::endl;
+      evictions += m_evictions[c];
+    }
+  os << Simulator::Now ().GetSeconds () << "," << node << ",all," << GetTotalBytes () << "," << evictions << std::endl;
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
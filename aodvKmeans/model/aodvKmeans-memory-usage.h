@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_MEMORY_USAGE_H
+#define aodvKmeans_MEMORY_USAGE_H
+
+#include <list>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+/**
+ * \ingroup aodvKmeans
+ * \name Heap memory estimates of standard containers
+ *
+ * The estimates assume a 64 bit libstdc++: a node of a std::map holds its
+ * color and three links besides its value, a node of a std::list two links,
+ * a node of a std::unordered_map one link, and its buckets one pointer each.
+ * The memory held by the values themselves, beyond their size, is not counted.
+ */
+//\{
+/// Bytes of the links of a node of a std::map
+static const uint32_t MEMORY_TREE_LINKS = 32;
+/// Bytes of the links of a node of a std::list
+static const uint32_t MEMORY_LIST_LINKS = 16;
+/// Bytes of the links of a node of a std::unordered_map
+static const uint32_t MEMORY_HASH_LINKS = 8;
+
+/**
+ * \param v the vector
+ * \returns the bytes allocated by the vector
+ */
+template <typename T>
+uint64_t
+MemoryBytes (std::vector<T> const & v)
+{
+  return static_cast<uint64_t> (v.capacity ()) * sizeof (T);
+}
+/**
+ * \param l the list
+ * \returns the bytes allocated by the list
+ */
+template <typename T>
+uint64_t
+MemoryBytes (std::list<T> const & l)
+{
+  return static_cast<uint64_t> (l.size ()) * (sizeof (T) + MEMORY_LIST_LINKS);
+}
+/**
+ * \param m the map
+ * \returns the bytes allocated by the map
+ */
+template <typename K, typename V, typename C>
+uint64_t
+MemoryBytes (std::map<K, V, C> const & m)
+{
+  return static_cast<uint64_t> (m.size ()) * (sizeof (typename std::map<K, V, C>::value_type) + MEMORY_TREE_LINKS);
+}
+/**
+ * \param m the hash map
+ * \returns the bytes allocated by the hash map
+ */
+template <typename K, typename V, typename H>
+uint64_t
+MemoryBytes (std::unordered_map<K, V, H> const & m)
+{
+  return static_cast<uint64_t> (m.size ()) * (sizeof (typename std::unordered_map<K, V, H>::value_type) + MEMORY_HASH_LINKS)
+         + static_cast<uint64_t> (m.bucket_count ()) * sizeof (void *);
+}
+/**
+ * \param m the hash multimap
+ * \returns the bytes allocated by the hash multimap
+ */
+template <typename K, typename V, typename H>
+uint64_t
+MemoryBytes (std::unordered_multimap<K, V, H> const & m)
+{
+  return static_cast<uint64_t> (m.size ()) * (sizeof (typename std::unordered_multimap<K, V, H>::value_type) + MEMORY_HASH_LINKS)
+         + static_cast<uint64_t> (m.bucket_count ()) * sizeof (void *);
+}
+//\}
+
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Estimated heap memory held by the data structures of a routing protocol.
+ *
+ * RoutingProtocol::GetMemoryUsage () fills it from the estimates of each data
+ * structure.  The objects the structures point to, such as the timer
+ * implementations and the scheduled events, are not counted, except the routes
+ * of the routing table; the queued packets are counted by their size, although
+ * their buffers may be shared with other copies.
+ */
+class MemoryUsage
+{
+public:
+  /// Data structures
+  enum Component
+  {
+    MEMORY_ROUTING_TABLE = 0,       //!< routing table entries and their routes
+    MEMORY_PRECURSORS = 1,          //!< precursor lists of the routing table entries
+    MEMORY_REQUEST_QUEUE = 2,       //!< route discovery buffer, its flows and samples
+    MEMORY_QUEUED_PACKETS = 3,      //!< packets referenced by the route discovery buffer
+    MEMORY_ID_CACHE = 4,            //!< RREQ id cache
+    MEMORY_DPD = 5,                 //!< duplicate packet detection
+    MEMORY_NEIGHBORS = 6,           //!< neighbors and their indexes
+    MEMORY_LOCATION_CACHE = 7,      //!< last known positions of the nodes
+    MEMORY_CLUSTER_CACHE = 8,       //!< last known clusters of forwarders
+    MEMORY_REQUEST_TIMERS = 9,      //!< route request timers, by destination
+    MEMORY_OTHER_TABLES = 10,       //!< other tables by node or destination
+    MEMORY_COMPONENT_COUNT = 11,    //!< number of data structures
+  };
+
+  MemoryUsage ();
+  /**
+   * Add memory held by a data structure
+   * \param component the data structure
+   * \param bytes the bytes
+   */
+  void Add (Component component, uint64_t bytes);
+  /**
+   * \param component the data structure
+   * \returns the bytes held by the data structure
+   */
+  uint64_t GetBytes (Component component) const;
+  /**
+   * \returns the bytes held by all data structures
+   */
+  uint64_t GetTotalBytes () const;
+  /**
+   * Add entries evicted from a bounded data structure
+   * \param component the data structure
+   * \param evictions the number of entries evicted
+   */
+  void AddEvictions (Component component, uint64_t evictions);
+  /**
+   * \param component the data structure
+   * \returns the number of entries evicted from the data structure
+   */
+  uint64_t GetEvictions (Component component) const;
+
+  /**
+   * \param component the data structure
+   * \returns the name of the data structure, as in the CSV lines
+   */
+  static std::string GetComponentName (Component component);
+  /**
+   * Print the CSV header line
+   * \param os the output stream
+   */
+  static void PrintHeader (std::ostream & os);
+  /**
+   * Print a CSV line per data structure, then one for their totals
+   * \param os the output stream
+   * \param node the node id
+   */
+  void Print (std::ostream & os, uint32_t node) const;
+
+private:
+  /// Bytes held by each data structure
+  uint64_t m_bytes[MEMORY_COMPONENT_COUNT];
+  /// Entries evicted from each data structure
+  uint64_t m_evictions[MEMORY_COMPONENT_COUNT];
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_MEMORY_USAGE_H */
@@ -30,71 +30,171 @@
 #include "ns3/log.h"
 #include "ns3/wifi-mac-header.h"
 #include "aodvKmeans-neighbor.h"
+#include "aodvKmeans-memory-usage.h"
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("aodvKmeansNeighbors");
 
 namespace aodvKmeans {
-Neighbors::Neighbors (Time delay)
-  : m_ntimer (Timer::CANCEL_ON_DESTROY)
+Neighbors::Neighbors ()
+  : m_ntimer (Timer::CANCEL_ON_DESTROY),
+    m_timerScheduled (0),
+    m_timerCancelled (0),
+    m_events (0)
 {
-  m_ntimer.SetDelay (delay);
-  m_ntimer.SetFunction (&Neighbors::Purge, this);
+  m_ntimer.SetFunction (&Neighbors::TimerExpire, this);
   m_txErrorCallback = MakeCallback (&Neighbors::ProcessTxError, this);
 }
 
 bool
 Neighbors::IsNeighbor (Ipv4Address addr)
 {
-  Purge ();
-  for (std::vector<Neighbor>::const_iterator i = m_nb.begin ();
-       i != m_nb.end (); ++i)
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator i = m_ipIndex.find (addr);
+  return (i != m_ipIndex.end () && m_nb[i->second].m_expireTime >= Simulator::Now ());
+}
+
+Time
+Neighbors::GetExpireTime (Ipv4Address addr)
+{
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator i = m_ipIndex.find (addr);
+  if (i != m_ipIndex.end () && m_nb[i->second].m_expireTime >= Simulator::Now ())
+    {
+      return (m_nb[i->second].m_expireTime - Simulator::Now ());
+    }
+  return Seconds (0);
+}
+
+Mac48Address
+Neighbors::GetMacAddress (Ipv4Address addr)
+{
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator i = m_ipIndex.find (addr);
+  if (i != m_ipIndex.end () && m_nb[i->second].m_hardwareAddress != Mac48Address ())
+    {
+      return m_nb[i->second].m_hardwareAddress;
+    }
+  return LookupMacAddress (addr);
+}
+
+void
+Neighbors::Update (Ipv4Address addr, Time expire)
+{
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator i = m_ipIndex.find (addr);
+  if (i != m_ipIndex.end ())
     {
-      if (i->m_neighborAddress == addr)
+      Neighbor & nb = m_nb[i->second];
+      nb.m_expireTime
+        = std::max (expire + Simulator::Now (), nb.m_expireTime);
+      if (nb.m_hardwareAddress == Mac48Address ())
         {
-          return true;
+          nb.m_hardwareAddress = LookupMacAddress (nb.m_neighborAddress);
+          IndexMac (i->second);
         }
+      return;
     }
-  return false;
+
+  NS_LOG_LOGIC ("Open link to " << addr);
+  // Indexed first, so that its MAC address is cached while it is a neighbor
+  m_ipIndex[addr] = m_nb.size ();
+  m_nb.push_back (Neighbor (addr, LookupMacAddress (addr), expire + Simulator::Now ()));
+  IndexMac (m_nb.size () - 1);
+  ArmTimer (m_nb.back ().m_expireTime);
 }
 
-Time
-Neighbors::GetExpireTime (Ipv4Address addr)
+void
+Neighbors::ArmTimer (Time expire)
 {
-  Purge ();
-  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i
-       != m_nb.end (); ++i)
+  // Entries expire strictly after their expire time
+  Time at = expire + TimeStep (1);
+  if (m_ntimer.IsRunning ())
     {
-      if (i->m_neighborAddress == addr)
+      if (m_ntimerExpire <= at)
+        {
+          return;
+        }
+      m_ntimer.Cancel ();
+      m_timerCancelled++;
+      if (m_events != 0)
         {
-          return (i->m_expireTime - Simulator::Now ());
+          m_events->Cancelled (EventAccounting::EVENT_NEIGHBOR_TIMER);
         }
     }
-  return Seconds (0);
+  m_ntimerExpire = std::max (at, Simulator::Now ());
+  m_ntimer.Schedule (m_ntimerExpire - Simulator::Now ());
+  m_timerScheduled++;
+  if (m_events != 0)
+    {
+      m_events->Scheduled (EventAccounting::EVENT_NEIGHBOR_TIMER);
+    }
 }
 
 void
-Neighbors::Update (Ipv4Address addr, Time expire)
+Neighbors::TimerExpire ()
+{
+  if (m_events != 0)
+    {
+      m_events->Executed (EventAccounting::EVENT_NEIGHBOR_TIMER);
+    }
+  Purge ();
+}
+
+uint64_t
+Neighbors::MacKey (Mac48Address mac)
+{
+  uint8_t buffer[6];
+  mac.CopyTo (buffer);
+  uint64_t key = 0;
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      key = (key << 8) | buffer[i];
+    }
+  return key;
+}
+
+void
+Neighbors::IndexMac (uint32_t index)
 {
-  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+  if (m_nb[index].m_hardwareAddress != Mac48Address ())
     {
-      if (i->m_neighborAddress == addr)
+      m_macIndex.insert (std::make_pair (MacKey (m_nb[index].m_hardwareAddress), index));
+    }
+}
+
+void
+Neighbors::UnindexMac (uint32_t index)
+{
+  if (m_nb[index].m_hardwareAddress == Mac48Address ())
+    {
+      return;
+    }
+  typedef std::unordered_multimap<uint64_t, uint32_t>::iterator MacIterator;
+  std::pair<MacIterator, MacIterator> range = m_macIndex.equal_range (MacKey (m_nb[index].m_hardwareAddress));
+  for (MacIterator i = range.first; i != range.second; ++i)
+    {
+      if (i->second == index)
         {
-          i->m_expireTime
-            = std::max (expire + Simulator::Now (), i->m_expireTime);
-          if (i->m_hardwareAddress == Mac48Address ())
-            {
-              i->m_hardwareAddress = LookupMacAddress (i->m_neighborAddress);
-            }
+          m_macIndex.erase (i);
           return;
         }
     }
+}
 
-  NS_LOG_LOGIC ("Open link to " << addr);
-  Neighbor neighbor (addr, LookupMacAddress (addr), expire + Simulator::Now ());
-  m_nb.push_back (neighbor);
-  Purge ();
+void
+Neighbors::Remove (uint32_t index)
+{
+  uint32_t last = m_nb.size () - 1;
+  UnindexMac (index);
+  m_ipIndex.erase (m_nb[index].m_neighborAddress);
+  // The ARP entry may change before the neighbor is heard again
+  m_macCache.erase (m_nb[index].m_neighborAddress);
+  if (index != last)
+    {
+      UnindexMac (last);
+      m_nb[index] = m_nb[last];
+      m_ipIndex[m_nb[index].m_neighborAddress] = index;
+      IndexMac (index);
+    }
+  m_nb.pop_back ();
 }
 
 
@@ -123,50 +223,68 @@ struct CloseNeighbor
 void
 Neighbors::Purge ()
 {
-  if (m_nb.empty ())
+  CloseNeighbor pred;
+  std::vector<Ipv4Address> closed;
+  for (uint32_t j = 0; j < m_nb.size (); )
     {
-      return;
+      if (pred (m_nb[j]))
+        {
+          NS_LOG_LOGIC ("Close link to " << m_nb[j].m_neighborAddress);
+          closed.push_back (m_nb[j].m_neighborAddress);
+          Remove (j);
+        }
+      else
+        {
+          ++j;
+        }
     }
-
-  CloseNeighbor pred;
   if (!m_handleLinkFailure.IsNull ())
     {
-      for (std::vector<Neighbor>::iterator j = m_nb.begin (); j != m_nb.end (); ++j)
+      for (std::vector<Ipv4Address>::const_iterator j = closed.begin (); j != closed.end (); ++j)
         {
-          if (pred (*j))
-            {
-              NS_LOG_LOGIC ("Close link to " << j->m_neighborAddress);
-              m_handleLinkFailure (j->m_neighborAddress);
-            }
+          m_handleLinkFailure (*j);
         }
     }
-  m_nb.erase (std::remove_if (m_nb.begin (), m_nb.end (), pred), m_nb.end ());
-  m_ntimer.Cancel ();
-  m_ntimer.Schedule ();
+  ScheduleTimer ();
 }
 
 void
 Neighbors::ScheduleTimer ()
 {
-  m_ntimer.Cancel ();
-  m_ntimer.Schedule ();
+  if (m_nb.empty ())
+    {
+      return;
+    }
+  Time earliest = m_nb.front ().m_expireTime;
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      earliest = std::min (earliest, i->m_expireTime);
+    }
+  ArmTimer (earliest);
 }
 
 void
 Neighbors::AddArpCache (Ptr<ArpCache> a)
 {
   m_arp.push_back (a);
+  m_macCache.clear ();
 }
 
 void
 Neighbors::DelArpCache (Ptr<ArpCache> a)
 {
   m_arp.erase (std::remove (m_arp.begin (), m_arp.end (), a), m_arp.end ());
+  m_macCache.clear ();
 }
 
 Mac48Address
 Neighbors::LookupMacAddress (Ipv4Address addr)
 {
+  std::unordered_map<Ipv4Address, Mac48Address, Ipv4AddressHash>::const_iterator cached = m_macCache.find (addr);
+  if (cached != m_macCache.end ())
+    {
+      return cached->second;
+    }
   Mac48Address hwaddr;
   for (std::vector<Ptr<ArpCache> >::const_iterator i = m_arp.begin ();
        i != m_arp.end (); ++i)
@@ -175,6 +293,11 @@ Neighbors::LookupMacAddress (Ipv4Address addr)
       if (entry != 0 && (entry->IsAlive () || entry->IsPermanent ()) && !entry->IsExpired ())
         {
           hwaddr = Mac48Address::ConvertFrom (entry->GetMacAddress ());
+          // Only resolved addresses of neighbors are cached, a miss is retried on the next update
+          if (m_ipIndex.find (addr) != m_ipIndex.end ())
+            {
+              m_macCache[addr] = hwaddr;
+            }
           break;
         }
     }
@@ -187,15 +310,37 @@ void
 Neighbors::ProcessTxError (WifiMacHeader const & hdr)
 {
   Mac48Address addr = hdr.GetAddr1 ();
+  if (addr == Mac48Address ())
+    {
+      return;
+    }
 
-  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+  // Only the neighbors behind the failed MAC address are closed, expired entries are left to the timer
+  std::vector<Ipv4Address> closed;
+  typedef std::unordered_multimap<uint64_t, uint32_t>::iterator MacIterator;
+  std::pair<MacIterator, MacIterator> range = m_macIndex.equal_range (MacKey (addr));
+  while (range.first != range.second)
     {
-      if (i->m_hardwareAddress == addr)
+      uint32_t index = range.first->second;
+      NS_LOG_LOGIC ("Close link to " << m_nb[index].m_neighborAddress);
+      closed.push_back (m_nb[index].m_neighborAddress);
+      Remove (index);
+      range = m_macIndex.equal_range (MacKey (addr));
+    }
+  if (!m_handleLinkFailure.IsNull ())
+    {
+      for (std::vector<Ipv4Address>::const_iterator i = closed.begin (); i != closed.end (); ++i)
         {
-          i->close = true;
+          m_handleLinkFailure (*i);
         }
     }
-  Purge ();
+}
+
+uint64_t
+Neighbors::GetMemoryBytes () const
+{
+  return MemoryBytes (m_nb) + MemoryBytes (m_ipIndex) + MemoryBytes (m_macIndex)
+         + MemoryBytes (m_arp) + MemoryBytes (m_macCache);
 }
 
 }  // namespace aodvKmeans
@@ -30,11 +30,13 @@
 #define aodvKmeansNEIGHBOR_H
 
 #include <vector>
+#include <unordered_map>
 #include "ns3/simulator.h"
 #include "ns3/timer.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/callback.h"
 #include "ns3/arp-cache.h"
+#include "aodvKmeans-event-accounting.h"
 
 namespace ns3 {
 
@@ -47,15 +49,20 @@ class RoutingProtocol;
 /**
  * \ingroup aodvKmeans
  * \brief maintain list of active neighbors
+ *
+ * Neighbors are stored in a flat array indexed by IPv4 address and by MAC address,
+ * so that lookups on the control path and layer 2 tx error notifications do not
+ * scan the whole list.  Entries are removed by moving the last entry in their slot.
+ *
+ * Expiry is driven by a single timer armed for the earliest neighbor expiry.  It is
+ * re-armed only when that expiry moves earlier or after it fires, and lookups are
+ * pure reads that compare the expire time with the current time.
  */
 class Neighbors
 {
 public:
-  /**
-   * constructor
-   * \param delay the delay time for purging the list of neighbors
-   */
-  Neighbors (Time delay);
+  /// constructor
+  Neighbors ();
   /// Neighbor description
   struct Neighbor
   {
@@ -98,21 +105,72 @@ public:
    * \returns true if the node with IP address is a neighbor
    */
   bool IsNeighbor (Ipv4Address addr);
+  /**
+   * Get the MAC address of a neighbor, resolved by the ARP caches if unknown
+   * \param addr the IP address of the neighbor
+   * \returns the MAC address, 00:00:00:00:00:00 if unresolved
+   */
+  Mac48Address GetMacAddress (Ipv4Address addr);
   /**
    * Update expire time for entry with address addr, if it exists, else add new entry
    * \param addr the IP address to check
    * \param expire the expire time for the address
    */
   void Update (Ipv4Address addr, Time expire);
-  /// Remove all expired entries
+  /// Remove all expired entries and re-arm m_ntimer for the earliest expiry
   void Purge ();
-  /// Schedule m_ntimer.
+  /// Schedule m_ntimer for the earliest expiry.
   void ScheduleTimer ();
   /// Remove all entries
   void Clear ()
   {
     m_nb.clear ();
+    m_ipIndex.clear ();
+    m_macIndex.clear ();
+    m_macCache.clear ();
+    if (m_ntimer.IsRunning ())
+      {
+        m_ntimer.Cancel ();
+        m_timerCancelled++;
+        if (m_events != 0)
+          {
+            m_events->Cancelled (EventAccounting::EVENT_NEIGHBOR_TIMER);
+          }
+      }
+  }
+  /**
+   * Report the events of m_ntimer
+   * \param events the event accounting of the routing protocol, or 0
+   */
+  void SetEventAccounting (EventAccounting * events)
+  {
+    m_events = events;
+  }
+  /**
+   * \returns the number of times m_ntimer was scheduled
+   */
+  uint64_t GetTimerScheduledCount () const
+  {
+    return m_timerScheduled;
+  }
+  /**
+   * \returns the number of times a pending m_ntimer was cancelled
+   */
+  uint64_t GetTimerCancelledCount () const
+  {
+    return m_timerCancelled;
   }
+  /**
+   * \returns the number of neighbors
+   */
+  uint32_t GetSize () const
+  {
+    return m_nb.size ();
+  }
+  /**
+   * \returns the estimated memory held by the neighbors and their indexes, bytes
+   */
+  uint64_t GetMemoryBytes () const;
 
   // set cluster id
   void SetClusterId(Ipv4Address addr, uint32_t cid);
@@ -166,10 +224,53 @@ private:
   Callback<void, WifiMacHeader const &> m_txErrorCallback;
   /// Timer for neighbor's list. Schedule Purge().
   Timer m_ntimer;
+  /// Time m_ntimer expires at, when running
+  Time m_ntimerExpire;
+  /// Number of times m_ntimer was scheduled
+  uint64_t m_timerScheduled;
+  /// Number of times a pending m_ntimer was cancelled
+  uint64_t m_timerCancelled;
+  /// Event accounting the events of m_ntimer are reported to, if any
+  EventAccounting * m_events;
   /// vector of entries
   std::vector<Neighbor> m_nb;
+  /// index of entries by IP address
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash> m_ipIndex;
+  /// index of entries by MAC address, neighbors with unresolved MAC address are not indexed
+  std::unordered_multimap<uint64_t, uint32_t> m_macIndex;
   /// list of ARP cached to be used for layer 2 notifications processing
   std::vector<Ptr<ArpCache> > m_arp;
+  /// MAC addresses of the neighbors already resolved by the ARP caches, dropped with the neighbors
+  std::unordered_map<Ipv4Address, Mac48Address, Ipv4AddressHash> m_macCache;
+
+  /**
+   * Build the MAC index key of a MAC address
+   * \param mac the MAC address
+   * \returns the key
+   */
+  static uint64_t MacKey (Mac48Address mac);
+  /**
+   * Add an entry to the MAC index
+   * \param index the position of the entry in m_nb
+   */
+  void IndexMac (uint32_t index);
+  /**
+   * Remove an entry from the MAC index
+   * \param index the position of the entry in m_nb
+   */
+  void UnindexMac (uint32_t index);
+  /**
+   * Make sure m_ntimer fires no later than just after the given expire time
+   * \param expire the expire time of a neighbor
+   */
+  void ArmTimer (Time expire);
+  /// Handle the expiry of m_ntimer
+  void TimerExpire ();
+  /**
+   * Remove an entry, the last entry takes its place
+   * \param index the position of the entry in m_nb
+   */
+  void Remove (uint32_t index);
 
   
   /**
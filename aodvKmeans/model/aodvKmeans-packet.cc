@@ -25,6 +25,9 @@
  * Authors: Elena Buchatskaia <borovkovaes@iitp.ru>
  *          Pavel Boyko <boyko@iitp.ru>
  */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include "aodvKmeans-packet.h"
 #include "ns3/address-utils.h"
 #include "ns3/packet.h"
@@ -32,6 +35,46 @@
 namespace ns3 {
 namespace aodvKmeans {
 
+/// Type of the compact K-means extension
+static const uint8_t KMEANS_TLV_TYPE = 1;
+/// Version of the compact K-means extension
+static const uint8_t KMEANS_TLV_VERSION = 1;
+/// Resolution of the fixed point positions, steps per meter
+static const double KMEANS_POSITION_SCALE = 16.0;
+
+/**
+ * \brief Write a signed 24 bit integer
+ * \param i the buffer iterator
+ * \param value the value, saturated to 24 bits
+ */
+static void
+WriteS24 (Buffer::Iterator & i, int64_t value)
+{
+  value = std::min<int64_t> (std::max<int64_t> (value, -(1 << 23)), (1 << 23) - 1);
+  uint32_t bits = static_cast<uint32_t> (value) & 0xffffff;
+  i.WriteU8 (bits >> 16);
+  i.WriteU8 ((bits >> 8) & 0xff);
+  i.WriteU8 (bits & 0xff);
+}
+
+/**
+ * \brief Read a signed 24 bit integer
+ * \param i the buffer iterator
+ * \return the value
+ */
+static int32_t
+ReadS24 (Buffer::Iterator & i)
+{
+  uint32_t bits = i.ReadU8 () << 16;
+  bits |= i.ReadU8 () << 8;
+  bits |= i.ReadU8 ();
+  if (bits & 0x800000)
+    {
+      bits |= 0xff000000;
+    }
+  return static_cast<int32_t> (bits);
+}
+
 NS_OBJECT_ENSURE_REGISTERED (TypeHeader);
 
 TypeHeader::TypeHeader (MessageType t)
@@ -148,7 +191,9 @@ RreqHeader::RreqHeader (uint8_t flags, uint8_t reserved, uint8_t hopCount, uint3
     m_dst (dst),
     m_dstSeqNo (dstSeqNo),
     m_origin (origin),
-    m_originSeqNo (originSeqNo)
+    m_originSeqNo (originSeqNo),
+    m_originX (0),
+    m_originY (0)
 {
 }
 
@@ -174,7 +219,7 @@ RreqHeader::GetInstanceTypeId () const
 uint32_t
 RreqHeader::GetSerializedSize () const
 {
-  return 23;
+  return HasOriginPosition () ? 23 + 6 : 23;
 }
 
 void
@@ -188,6 +233,11 @@ RreqHeader::Serialize (Buffer::Iterator i) const
   i.WriteHtonU32 (m_dstSeqNo);
   WriteTo (i, m_origin);
   i.WriteHtonU32 (m_originSeqNo);
+  if (HasOriginPosition ())
+    {
+      WriteS24 (i, m_originX);
+      WriteS24 (i, m_originY);
+    }
 }
 
 uint32_t
@@ -202,6 +252,13 @@ RreqHeader::Deserialize (Buffer::Iterator start)
   m_dstSeqNo = i.ReadNtohU32 ();
   ReadFrom (i, m_origin);
   m_originSeqNo = i.ReadNtohU32 ();
+  m_originX = 0;
+  m_originY = 0;
+  if (HasOriginPosition ())
+    {
+      m_originX = ReadS24 (i);
+      m_originY = ReadS24 (i);
+    }
 
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
@@ -217,8 +274,12 @@ RreqHeader::Print (std::ostream &os) const
      << " flags:" << " Gratuitous RREP " << (*this).GetGratuitousRrep ()
      << " Destination only " << (*this).GetDestinationOnly ()
      << " Unknown sequence number " << (*this).GetUnknownSeqno ()
-     << " Hop count " <<  unsigned((*this).GetHopCount())
-     << "\n";
+     << " Hop count " <<  unsigned((*this).GetHopCount());
+  if (HasOriginPosition ())
+    {
+      os << " origin position " << GetOriginPosition ().first << ":" << GetOriginPosition ().second;
+    }
+  os << "\n";
 }
 
 std::ostream &
@@ -285,13 +346,36 @@ RreqHeader::GetUnknownSeqno () const
   return (m_flags & (1 << 3));
 }
 
+void
+RreqHeader::SetOriginPosition (double positionX, double positionY)
+{
+  m_flags |= (1 << 2);
+  m_originX = static_cast<int32_t> (std::llround (positionX * KMEANS_POSITION_SCALE));
+  m_originY = static_cast<int32_t> (std::llround (positionY * KMEANS_POSITION_SCALE));
+  m_originX = std::min (std::max (m_originX, -(1 << 23)), (1 << 23) - 1);
+  m_originY = std::min (std::max (m_originY, -(1 << 23)), (1 << 23) - 1);
+}
+
+bool
+RreqHeader::HasOriginPosition () const
+{
+  return (m_flags & (1 << 2));
+}
+
+std::pair<double, double>
+RreqHeader::GetOriginPosition () const
+{
+  return std::make_pair (m_originX / KMEANS_POSITION_SCALE, m_originY / KMEANS_POSITION_SCALE);
+}
+
 bool
 RreqHeader::operator== (RreqHeader const & o) const
 {
   return (m_flags == o.m_flags && m_reserved == o.m_reserved
           && m_hopCount == o.m_hopCount && m_requestID == o.m_requestID
           && m_dst == o.m_dst && m_dstSeqNo == o.m_dstSeqNo
-          && m_origin == o.m_origin && m_originSeqNo == o.m_originSeqNo);
+          && m_origin == o.m_origin && m_originSeqNo == o.m_originSeqNo
+          && m_originX == o.m_originX && m_originY == o.m_originY);
 }
 
 //-----------------------------------------------------------------------------
@@ -301,7 +385,7 @@ RreqHeader::operator== (RreqHeader const & o) const
 RrepHeader::RrepHeader (uint8_t prefixSize, uint8_t hopCount, Ipv4Address dst,
                         uint32_t dstSeqNo, Ipv4Address origin, Time lifeTime, 
                         uint32_t errorCount, uint32_t freeSpace,
-                        uint32_t positionX, uint32_t positionY)
+                        double positionX, double positionY)
   : m_flags (0),
     m_prefixSize (prefixSize),
     m_hopCount (hopCount),
@@ -311,11 +395,21 @@ RrepHeader::RrepHeader (uint8_t prefixSize, uint8_t hopCount, Ipv4Address dst,
     m_txErrorCount(errorCount),
     m_freeSpace(freeSpace),
     m_positionX(positionX),
-    m_positionY(positionY)
+    m_positionY(positionY),
+    m_positionEncoding (POSITION_ABSOLUTE),
+    m_keyframe (0),
+    m_referenceX (0),
+    m_referenceY (0),
+    m_velocityX (0),
+    m_velocityY (0),
+    m_positionTime (0),
+    m_macQueue (0),
+    m_channelBusy (0)
 {
   m_lifeTime = uint32_t (lifeTime.GetMilliSeconds ());
 }
 
+
 NS_OBJECT_ENSURE_REGISTERED (RrepHeader);
 
 TypeId
@@ -338,7 +432,31 @@ RrepHeader::GetInstanceTypeId () const
 uint32_t
 RrepHeader::GetSerializedSize () const
 {
-  return 19 + 4 * 4;
+  uint32_t size = 19;
+  switch (GetKmeansExtension ())
+    {
+    case KMEANS_EXT_LEGACY:
+      size += 4 * 4;
+      break;
+    case KMEANS_EXT_COMPACT:
+      size += GetCompactSize ();
+      break;
+    case KMEANS_EXT_NONE:
+      break;
+    }
+  if (HasVelocity ())
+    {
+      size += 3 * 4;
+    }
+  if (m_flags & (1 << 2))
+    {
+      size += 1 + m_gossip.size () * (4 + 6 + 2);
+    }
+  if (HasChannelLoad ())
+    {
+      size += 2;
+    }
+  return size;
 }
 void
 RrepHeader::Serialize (Buffer::Iterator i) const
@@ -350,10 +468,70 @@ RrepHeader::Serialize (Buffer::Iterator i) const
   i.WriteHtonU32 (m_dstSeqNo);
   WriteTo (i, m_origin);
   i.WriteHtonU32 (m_lifeTime);
-  i.WriteU32 (m_txErrorCount);
-  i.WriteU32 (m_freeSpace);
-  i.WriteU32 (m_positionX);
-  i.WriteU32 (m_positionY);
+  switch (GetKmeansExtension ())
+    {
+    case KMEANS_EXT_LEGACY:
+      i.WriteU32 (m_txErrorCount);
+      i.WriteU32 (m_freeSpace);
+      i.WriteU32 (static_cast<uint32_t> (std::max (m_positionX, 0.0)));
+      i.WriteU32 (static_cast<uint32_t> (std::max (m_positionY, 0.0)));
+      break;
+    case KMEANS_EXT_COMPACT:
+      {
+        uint8_t code = GetPositionCode ();
+        i.WriteU8 (KMEANS_TLV_TYPE);
+        i.WriteU8 (GetCompactSize () - 2);
+        i.WriteU8 ((KMEANS_TLV_VERSION << 4) | code);
+        if (code != 0)
+          {
+            i.WriteU8 (m_keyframe);
+          }
+        int64_t x = std::llround ((m_positionX - m_referenceX) * KMEANS_POSITION_SCALE);
+        int64_t y = std::llround ((m_positionY - m_referenceY) * KMEANS_POSITION_SCALE);
+        if (code < 2)
+          {
+            WriteS24 (i, x);
+            WriteS24 (i, y);
+          }
+        else if (code == 2)
+          {
+            i.WriteU8 (static_cast<uint8_t> (x));
+            i.WriteU8 (static_cast<uint8_t> (y));
+          }
+        else
+          {
+            i.WriteHtonU16 (static_cast<uint16_t> (std::min<int64_t> (std::max<int64_t> (x, INT16_MIN), INT16_MAX)));
+            i.WriteHtonU16 (static_cast<uint16_t> (std::min<int64_t> (std::max<int64_t> (y, INT16_MIN), INT16_MAX)));
+          }
+        i.WriteU8 (EncodeMetric (m_txErrorCount));
+        i.WriteU8 (EncodeMetric (m_freeSpace));
+        break;
+      }
+    case KMEANS_EXT_NONE:
+      break;
+    }
+  if (HasVelocity ())
+    {
+      i.WriteHtonU32 (static_cast<uint32_t> (m_velocityX));
+      i.WriteHtonU32 (static_cast<uint32_t> (m_velocityY));
+      i.WriteHtonU32 (m_positionTime);
+    }
+  if (m_flags & (1 << 2))
+    {
+      i.WriteU8 (m_gossip.size ());
+      for (std::vector<LocationGossip>::const_iterator g = m_gossip.begin (); g != m_gossip.end (); ++g)
+        {
+          WriteTo (i, g->m_node);
+          WriteS24 (i, std::llround (g->m_positionX * KMEANS_POSITION_SCALE));
+          WriteS24 (i, std::llround (g->m_positionY * KMEANS_POSITION_SCALE));
+          i.WriteHtonU16 (std::min<int64_t> (g->m_age.GetMilliSeconds () / 100, 0xffff));
+        }
+    }
+  if (HasChannelLoad ())
+    {
+      i.WriteU8 (m_macQueue);
+      i.WriteU8 (m_channelBusy);
+    }
 }
 uint32_t
 RrepHeader::Deserialize (Buffer::Iterator start)
@@ -367,14 +545,100 @@ RrepHeader::Deserialize (Buffer::Iterator start)
   m_dstSeqNo = i.ReadNtohU32 ();
   ReadFrom (i, m_origin);
   m_lifeTime = i.ReadNtohU32 ();
-  m_txErrorCount = i.ReadU32();
-  m_freeSpace = i.ReadU32();
-  m_positionX = i.ReadU32();
-  m_positionY = i.ReadU32();
-
+  m_positionEncoding = POSITION_ABSOLUTE;
+  m_keyframe = 0;
+  m_referenceX = 0;
+  m_referenceY = 0;
+  m_txErrorCount = 0;
+  m_freeSpace = 0;
+  m_positionX = 0;
+  m_positionY = 0;
+  uint32_t skipped = 0;
+  switch (GetKmeansExtension ())
+    {
+    case KMEANS_EXT_LEGACY:
+      m_txErrorCount = i.ReadU32();
+      m_freeSpace = i.ReadU32();
+      m_positionX = i.ReadU32();
+      m_positionY = i.ReadU32();
+      break;
+    case KMEANS_EXT_COMPACT:
+      {
+        uint8_t type = i.ReadU8 ();
+        uint8_t length = i.ReadU8 ();
+        uint8_t version = i.PeekU8 () >> 4;
+        if (type != KMEANS_TLV_TYPE || version != KMEANS_TLV_VERSION)
+          {
+            // Unknown extension, skip it and carry on without the metrics
+            i.Next (length);
+            skipped = 2 + length;
+            SetKmeansExtension (KMEANS_EXT_NONE);
+            break;
+          }
+        uint8_t code = i.ReadU8 () & 0x3;
+        if (code != 0)
+          {
+            m_keyframe = i.ReadU8 ();
+          }
+        if (code < 2)
+          {
+            m_positionX = ReadS24 (i) / KMEANS_POSITION_SCALE;
+            m_positionY = ReadS24 (i) / KMEANS_POSITION_SCALE;
+          }
+        else if (code == 2)
+          {
+            m_positionX = static_cast<int8_t> (i.ReadU8 ()) / KMEANS_POSITION_SCALE;
+            m_positionY = static_cast<int8_t> (i.ReadU8 ()) / KMEANS_POSITION_SCALE;
+          }
+        else
+          {
+            m_positionX = static_cast<int16_t> (i.ReadNtohU16 ()) / KMEANS_POSITION_SCALE;
+            m_positionY = static_cast<int16_t> (i.ReadNtohU16 ()) / KMEANS_POSITION_SCALE;
+          }
+        m_positionEncoding = std::min<uint8_t> (code, POSITION_DELTA);
+        m_txErrorCount = DecodeMetric (i.ReadU8 ());
+        m_freeSpace = DecodeMetric (i.ReadU8 ());
+        break;
+      }
+    case KMEANS_EXT_NONE:
+      break;
+    }
+  if (HasVelocity ())
+    {
+      m_velocityX = static_cast<int32_t> (i.ReadNtohU32 ());
+      m_velocityY = static_cast<int32_t> (i.ReadNtohU32 ());
+      m_positionTime = i.ReadNtohU32 ();
+    }
+  else
+    {
+      m_velocityX = 0;
+      m_velocityY = 0;
+      m_positionTime = 0;
+    }
+  m_gossip.clear ();
+  if (m_flags & (1 << 2))
+    {
+      uint8_t count = i.ReadU8 ();
+      for (uint8_t n = 0; n < count; ++n)
+        {
+          LocationGossip gossip;
+          ReadFrom (i, gossip.m_node);
+          gossip.m_positionX = ReadS24 (i) / KMEANS_POSITION_SCALE;
+          gossip.m_positionY = ReadS24 (i) / KMEANS_POSITION_SCALE;
+          gossip.m_age = MilliSeconds (100 * i.ReadNtohU16 ());
+          m_gossip.push_back (gossip);
+        }
+    }
+  m_macQueue = 0;
+  m_channelBusy = 0;
+  if (HasChannelLoad ())
+    {
+      m_macQueue = i.ReadU8 ();
+      m_channelBusy = i.ReadU8 ();
+    }
 
   uint32_t dist = i.GetDistanceFrom (start);
-  NS_ASSERT (dist == GetSerializedSize ());
+  NS_ASSERT (dist == GetSerializedSize () + skipped);
   return dist;
 }
 
@@ -388,6 +652,27 @@ RrepHeader::Print (std::ostream &os) const
     }
   os << " source ipv4 " << m_origin << " lifetime " << m_lifeTime
      << " acknowledgment required flag " << (*this).GetAckRequired ();
+  if (GetKmeansExtension () != KMEANS_EXT_NONE)
+    {
+      os << " tx errors " << m_txErrorCount << " free space " << m_freeSpace
+         << " position " << m_positionX << ":" << m_positionY;
+      if (m_positionEncoding != POSITION_ABSOLUTE)
+        {
+          os << (IsPositionDelta () ? " delta to keyframe " : " keyframe ") << uint32_t (m_keyframe);
+        }
+    }
+  if (HasVelocity ())
+    {
+      os << " velocity " << GetVelocity () << " position time " << m_positionTime;
+    }
+  if (!m_gossip.empty ())
+    {
+      os << " gossiped positions " << m_gossip.size ();
+    }
+  if (HasChannelLoad ())
+    {
+      os << " MAC queue " << GetMacQueueOccupancy () << " channel busy " << GetChannelBusy ();
+    }
 }
 
 void
@@ -441,7 +726,247 @@ RrepHeader::operator== (RrepHeader const & o) const
           && m_hopCount == o.m_hopCount && m_dst == o.m_dst && m_dstSeqNo == o.m_dstSeqNo
           && m_origin == o.m_origin && m_lifeTime == o.m_lifeTime 
           && m_txErrorCount == o.m_txErrorCount && m_freeSpace == o.m_freeSpace
-          && m_positionX == o.m_positionX && m_positionY == o.m_positionY);
+          && m_positionX == o.m_positionX && m_positionY == o.m_positionY
+          && m_positionEncoding == o.m_positionEncoding && m_keyframe == o.m_keyframe
+          && m_velocityX == o.m_velocityX && m_velocityY == o.m_velocityY
+          && m_positionTime == o.m_positionTime && m_gossip == o.m_gossip
+          && m_macQueue == o.m_macQueue && m_channelBusy == o.m_channelBusy);
+}
+
+void
+RrepHeader::SetKmeansExtension (KmeansExtension format)
+{
+  m_flags &= ~((1 << 4) | (1 << 3));
+  if (format == KMEANS_EXT_COMPACT)
+    {
+      m_flags |= (1 << 4);
+    }
+  else if (format == KMEANS_EXT_NONE)
+    {
+      m_flags |= (1 << 3);
+    }
+}
+
+KmeansExtension
+RrepHeader::GetKmeansExtension () const
+{
+  if (m_flags & (1 << 4))
+    {
+      return KMEANS_EXT_COMPACT;
+    }
+  if (m_flags & (1 << 3))
+    {
+      return KMEANS_EXT_NONE;
+    }
+  return KMEANS_EXT_LEGACY;
+}
+
+void
+RrepHeader::SetPositionKeyframe (uint8_t keyframe)
+{
+  m_positionEncoding = POSITION_KEYFRAME;
+  m_keyframe = keyframe;
+  m_referenceX = 0;
+  m_referenceY = 0;
+}
+
+void
+RrepHeader::SetPositionDelta (uint8_t keyframe, double referenceX, double referenceY)
+{
+  NS_ASSERT (FitsPositionDelta (m_positionX - referenceX, m_positionY - referenceY));
+  m_positionEncoding = POSITION_DELTA;
+  m_keyframe = keyframe;
+  m_referenceX = referenceX;
+  m_referenceY = referenceY;
+}
+
+bool
+RrepHeader::IsPositionKeyframe () const
+{
+  return (m_positionEncoding == POSITION_KEYFRAME);
+}
+
+bool
+RrepHeader::IsPositionDelta () const
+{
+  return (m_positionEncoding == POSITION_DELTA);
+}
+
+uint8_t
+RrepHeader::GetPositionKeyframe () const
+{
+  return m_keyframe;
+}
+
+void
+RrepHeader::ResolvePositionDelta (double referenceX, double referenceY)
+{
+  NS_ASSERT (IsPositionDelta ());
+  m_positionX += referenceX - m_referenceX;
+  m_positionY += referenceY - m_referenceY;
+  m_positionEncoding = POSITION_ABSOLUTE;
+  m_referenceX = 0;
+  m_referenceY = 0;
+}
+
+bool
+RrepHeader::FitsPositionDelta (double dx, double dy)
+{
+  double limit = INT16_MAX / KMEANS_POSITION_SCALE;
+  return (std::abs (dx) < limit && std::abs (dy) < limit);
+}
+
+uint8_t
+RrepHeader::EncodeMetric (uint32_t value)
+{
+  if (value < 16)
+    {
+      return value;
+    }
+  // The smallest exponent leaving a mantissa of 16 to 31 after rounding
+  uint32_t exponent = 1;
+  uint64_t mantissa = value;
+  for (; exponent <= 15; ++exponent)
+    {
+      uint64_t step = uint64_t (1) << (exponent - 1);
+      mantissa = (value + step / 2) / step;
+      if (mantissa <= 31)
+        {
+          break;
+        }
+    }
+  if (exponent > 15)
+    {
+      return 0xff;
+    }
+  return (exponent << 4) | (mantissa - 16);
+}
+
+uint32_t
+RrepHeader::DecodeMetric (uint8_t code)
+{
+  uint32_t exponent = code >> 4;
+  uint32_t mantissa = code & 0xf;
+  if (exponent == 0)
+    {
+      return mantissa;
+    }
+  return (16 + mantissa) << (exponent - 1);
+}
+
+uint32_t
+RrepHeader::GetCompactSize () const
+{
+  // Type, length, version and the two metrics
+  uint32_t size = 5;
+  switch (GetPositionCode ())
+    {
+    case 0:
+      size += 6;
+      break;
+    case 1:
+      size += 1 + 6;
+      break;
+    case 2:
+      size += 1 + 2;
+      break;
+    default:
+      size += 1 + 4;
+      break;
+    }
+  return size;
+}
+
+uint8_t
+RrepHeader::GetPositionCode () const
+{
+  if (m_positionEncoding != POSITION_DELTA)
+    {
+      return m_positionEncoding;
+    }
+  int64_t x = std::llround ((m_positionX - m_referenceX) * KMEANS_POSITION_SCALE);
+  int64_t y = std::llround ((m_positionY - m_referenceY) * KMEANS_POSITION_SCALE);
+  if (x >= INT8_MIN && x <= INT8_MAX && y >= INT8_MIN && y <= INT8_MAX)
+    {
+      return 2;
+    }
+  return 3;
+}
+
+void
+RrepHeader::SetVelocity (Vector velocity, Time positionTime)
+{
+  m_flags |= (1 << 5);
+  m_velocityX = static_cast<int32_t> (std::lround (velocity.x * 1000));
+  m_velocityY = static_cast<int32_t> (std::lround (velocity.y * 1000));
+  m_positionTime = static_cast<uint32_t> (positionTime.GetMilliSeconds ());
+}
+
+void
+RrepHeader::ClearVelocity ()
+{
+  m_flags &= ~(1 << 5);
+  m_velocityX = 0;
+  m_velocityY = 0;
+  m_positionTime = 0;
+}
+
+bool
+RrepHeader::HasVelocity () const
+{
+  return (m_flags & (1 << 5));
+}
+
+Vector
+RrepHeader::GetVelocity () const
+{
+  return Vector (m_velocityX / 1000.0, m_velocityY / 1000.0, 0);
+}
+
+Time
+RrepHeader::GetPositionTime () const
+{
+  return MilliSeconds (m_positionTime);
+}
+
+void
+RrepHeader::AddLocationGossip (LocationGossip const & gossip)
+{
+  NS_ASSERT (m_gossip.size () < 255);
+  m_flags |= (1 << 2);
+  m_gossip.push_back (gossip);
+}
+
+std::vector<LocationGossip> const &
+RrepHeader::GetLocationGossip () const
+{
+  return m_gossip;
+}
+
+void
+RrepHeader::SetChannelLoad (double macQueue, double channelBusy)
+{
+  m_flags |= (1 << 1);
+  m_macQueue = static_cast<uint8_t> (std::lround (std::min (std::max (macQueue, 0.0), 1.0) * 255));
+  m_channelBusy = static_cast<uint8_t> (std::lround (std::min (std::max (channelBusy, 0.0), 1.0) * 255));
+}
+
+bool
+RrepHeader::HasChannelLoad () const
+{
+  return (m_flags & (1 << 1));
+}
+
+double
+RrepHeader::GetMacQueueOccupancy () const
+{
+  return m_macQueue / 255.0;
+}
+
+double
+RrepHeader::GetChannelBusy () const
+{
+  return m_channelBusy / 255.0;
 }
 
 void
@@ -455,6 +980,11 @@ RrepHeader::SetHello (Ipv4Address origin, uint32_t srcSeqNo, Time lifetime)
   m_origin = origin;
   m_lifeTime = lifetime.GetMilliSeconds ();
   m_txErrorCount = 0;
+  m_positionEncoding = POSITION_ABSOLUTE;
+  m_gossip.clear ();
+  m_macQueue = 0;
+  m_channelBusy = 0;
+  ClearVelocity ();
 }
 
 std::ostream &
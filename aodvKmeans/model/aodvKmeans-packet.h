@@ -33,7 +33,9 @@
 #include "ns3/enum.h"
 #include "ns3/ipv4-address.h"
 #include <map>
+#include <vector>
 #include "ns3/nstime.h"
+#include "ns3/vector.h"
 
 namespace ns3 {
 namespace aodvKmeans {
@@ -127,6 +129,9 @@ std::ostream & operator<< (std::ostream & os, TypeHeader const & h);
   |                  Originator Sequence Number                   |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   \endverbatim
+
+  With the P flag (reserved bit 2) the position of the originator follows,
+  as two signed 24 bit coordinates in 1/16 m.
 */
 class RreqHeader : public Header
 {
@@ -288,6 +293,22 @@ public:
    * \return the unknown sequence number flag
    */
   bool GetUnknownSeqno () const;
+  /**
+   * \brief Attach the position of the originator (P flag)
+   * \param positionX the X position, m
+   * \param positionY the Y position, m
+   */
+  void SetOriginPosition (double positionX, double positionY);
+  /**
+   * \brief Check the originator position extension
+   * \return true if the position of the originator is present
+   */
+  bool HasOriginPosition () const;
+  /**
+   * \brief Get the position of the originator, 0 if absent
+   * \return the position (resolution 1/16 m)
+   */
+  std::pair<double, double> GetOriginPosition () const;
 
   /**
    * \brief Comparison operator
@@ -304,6 +325,8 @@ private:
   uint32_t       m_dstSeqNo;       ///< Destination Sequence Number
   Ipv4Address    m_origin;         ///< Originator IP Address
   uint32_t       m_originSeqNo;    ///< Source Sequence Number
+  int32_t        m_originX;        ///< X position of the originator, 1/16 m (P flag)
+  int32_t        m_originY;        ///< Y position of the originator, 1/16 m (P flag)
 };
 
 /**
@@ -313,6 +336,40 @@ private:
   */
 std::ostream & operator<< (std::ostream & os, RreqHeader const &);
 
+/**
+ * \ingroup aodvKmeans
+ * \brief Position of a node gossiped in a hello
+ */
+struct LocationGossip
+{
+  Ipv4Address m_node;   ///< the node
+  double m_positionX;   ///< X position, m
+  double m_positionY;   ///< Y position, m
+  Time m_age;           ///< age of the position when the hello was sent
+
+  /**
+   * \brief Comparison operator
+   * \param o other gossiped position
+   * \return true if equal
+   */
+  bool operator== (LocationGossip const & o) const
+  {
+    return m_node == o.m_node && m_positionX == o.m_positionX && m_positionY == o.m_positionY && m_age == o.m_age;
+  }
+};
+
+/**
+ * \ingroup aodvKmeans
+ * \brief Encoding of the K-means metrics (transmission errors, free buffer
+ * space and position) carried by hellos and replies
+ */
+enum KmeansExtension
+{
+  KMEANS_EXT_LEGACY = 0,  //!< four 32 bit fields, 16 bytes
+  KMEANS_EXT_COMPACT = 1, //!< quantized TLV, 8 to 12 bytes (C flag)
+  KMEANS_EXT_NONE = 2     //!< no metrics (N flag)
+};
+
 /**
 * \ingroup aodvKmeans
 * \brief Route Reply (RREP) Message Format
@@ -331,6 +388,29 @@ std::ostream & operator<< (std::ostream & os, RreqHeader const &);
   |                           Lifetime                            |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   \endverbatim
+
+  The K-means metrics follow, as four 32 bit fields (legacy), as the compact
+  TLV below (C flag) or not at all (N flag).  Positions are signed, in 1/16 m,
+  and a hello may carry them as an offset to the last keyframe of its
+  originator.  The error count and the free space are 8 bit minifloats.  The velocity
+  extension (V flag) and the location gossip (G flag, reserved bit 2: a count
+  then address, 24 bit coordinates and 16 bit age in 100 ms per node) come
+  last, followed by the channel load (L flag, reserved bit 1: MAC queue
+  occupancy and channel busy fraction, 8 bits each in 1/255).
+  \verbatim
+  0                   1                   2
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |   Type (1)    |    Length     |Version| 0 |Enc|
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | Keyframe (Enc 1 to 3) |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  X, Y: 24 bit (Enc 0, 1), 8 bit (Enc 2) or   |
+  |        16 bit (Enc 3) offsets                 |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |   Tx errors   |  Free space   |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
 */
 class RrepHeader : public Header
 {
@@ -348,7 +428,7 @@ public:
   RrepHeader (uint8_t prefixSize = 0, uint8_t hopCount = 0, Ipv4Address dst =
                 Ipv4Address (), uint32_t dstSeqNo = 0, Ipv4Address origin =
                 Ipv4Address (), Time lifetime = MilliSeconds (0),
-                uint32_t txErrorCount = 0, uint32_t freeSpace = 0, uint32_t positionX=0, uint32_t positionY=0);
+                uint32_t txErrorCount = 0, uint32_t freeSpace = 0, double positionX = 0, double positionY = 0);
   /**
    * \brief Get the type ID.
    * \return the object TypeId
@@ -498,7 +578,7 @@ public:
    * \brief Get the position
    * \return the position
    */
-  std::pair<uint32_t, uint32_t> GetPosition() const
+  std::pair<double, double> GetPosition() const
   {
     return std::make_pair(m_positionX, m_positionY);
   }
@@ -506,12 +586,135 @@ public:
   /**
    * \brief Set the position
    */
-  void SetPosition(uint32_t positionX, uint32_t positionY)
+  void SetPosition(double positionX, double positionY)
   {
     m_positionX = positionX;
     m_positionY = positionY;
+    m_positionEncoding = POSITION_ABSOLUTE;
   }
 
+  /**
+   * \brief Set the encoding of the K-means metrics
+   * \param format the encoding
+   */
+  void SetKmeansExtension (KmeansExtension format);
+  /**
+   * \brief Get the encoding of the K-means metrics
+   * \return the encoding
+   */
+  KmeansExtension GetKmeansExtension () const;
+  /**
+   * \brief Mark the position as a keyframe of the originator (compact encoding only)
+   * \param keyframe the keyframe number
+   */
+  void SetPositionKeyframe (uint8_t keyframe);
+  /**
+   * \brief Encode the position as an offset to a keyframe (compact encoding only)
+   * \param keyframe the keyframe number
+   * \param referenceX the X position of the keyframe
+   * \param referenceY the Y position of the keyframe
+   */
+  void SetPositionDelta (uint8_t keyframe, double referenceX, double referenceY);
+  /**
+   * \brief Check whether the position is a keyframe
+   * \return true if the position is a keyframe
+   */
+  bool IsPositionKeyframe () const;
+  /**
+   * \brief Check whether the position is an offset to a keyframe; once received,
+   * GetPosition returns the offset until ResolvePositionDelta is called
+   * \return true if the position is an offset
+   */
+  bool IsPositionDelta () const;
+  /**
+   * \brief Get the keyframe number of a keyframe or offset position
+   * \return the keyframe number
+   */
+  uint8_t GetPositionKeyframe () const;
+  /**
+   * \brief Turn a received offset into an absolute position
+   * \param referenceX the X position of the keyframe
+   * \param referenceY the Y position of the keyframe
+   */
+  void ResolvePositionDelta (double referenceX, double referenceY);
+  /**
+   * \brief Check whether an offset fits the compact delta encoding
+   * \param dx the X offset, m
+   * \param dy the Y offset, m
+   * \return true if the offset can be delta encoded
+   */
+  static bool FitsPositionDelta (double dx, double dy);
+  /**
+   * \brief Quantize a metric to an 8 bit minifloat (4 bit exponent, 4 bit
+   * mantissa, relative error below 3.2%, saturates at 507904)
+   * \param value the metric
+   * \return the code
+   */
+  static uint8_t EncodeMetric (uint32_t value);
+  /**
+   * \brief Expand an 8 bit minifloat metric
+   * \param code the code
+   * \return the metric
+   */
+  static uint32_t DecodeMetric (uint8_t code);
+
+  /**
+   * \brief Attach the velocity extension (V flag)
+   * \param velocity the velocity of the node, m/s
+   * \param positionTime the time the position was sampled at
+   */
+  void SetVelocity (Vector velocity, Time positionTime);
+  /**
+   * \brief Remove the velocity extension
+   */
+  void ClearVelocity ();
+  /**
+   * \brief Check the velocity extension
+   * \return true if the velocity extension is present
+   */
+  bool HasVelocity () const;
+  /**
+   * \brief Get the velocity, 0 if the extension is absent
+   * \return the velocity, m/s (resolution 1 mm/s)
+   */
+  Vector GetVelocity () const;
+  /**
+   * \brief Get the time the position was sampled at
+   * \return the sampling time (resolution 1 ms)
+   */
+  Time GetPositionTime () const;
+  /**
+   * \brief Gossip the position of another node (G flag), at most 255 per hello
+   * \param gossip the position
+   */
+  void AddLocationGossip (LocationGossip const & gossip);
+  /**
+   * \brief Get the gossiped positions
+   * \return the positions (resolution 1/16 m and 100 ms)
+   */
+  std::vector<LocationGossip> const & GetLocationGossip () const;
+  /**
+   * \brief Attach the channel load of the node (L flag)
+   * \param macQueue the occupancy of the MAC queues, in [0, 1]
+   * \param channelBusy the fraction of time the channel was busy, in [0, 1]
+   */
+  void SetChannelLoad (double macQueue, double channelBusy);
+  /**
+   * \brief Check the channel load extension
+   * \return true if the channel load extension is present
+   */
+  bool HasChannelLoad () const;
+  /**
+   * \brief Get the occupancy of the MAC queues, 0 if the extension is absent
+   * \return the occupancy (resolution 1/255)
+   */
+  double GetMacQueueOccupancy () const;
+  /**
+   * \brief Get the channel busy fraction, 0 if the extension is absent
+   * \return the busy fraction (resolution 1/255)
+   */
+  double GetChannelBusy () const;
+
   /**
    * Configure RREP to be a Hello message
    *
@@ -528,19 +731,46 @@ public:
    */
   bool operator== (RrepHeader const & o) const;
 private:
-  uint8_t       m_flags;            ///< A - acknowledgment required flag
+  /// Position encodings of the compact extension
+  enum PositionEncoding
+  {
+    POSITION_ABSOLUTE = 0, //!< 24 bit coordinates
+    POSITION_KEYFRAME = 1, //!< 24 bit coordinates starting a keyframe
+    POSITION_DELTA = 2     //!< 8 or 16 bit offsets to a keyframe
+  };
+  /**
+   * \brief Get the size of the compact extension
+   * \return the size, in bytes
+   */
+  uint32_t GetCompactSize () const;
+  /**
+   * \brief Get the wire code of the position encoding
+   * \return 0 absolute, 1 keyframe, 2 8 bit delta, 3 16 bit delta
+   */
+  uint8_t GetPositionCode () const;
+
+  uint8_t       m_flags;            ///< A - acknowledgment required flag, V - velocity extension,
+                                    ///< C - compact K-means extension, N - no K-means extension
   uint8_t       m_prefixSize;       ///< Prefix Size
   uint8_t       m_hopCount;         ///< Hop Count
   Ipv4Address   m_dst;              ///< Destination IP Address
   uint32_t      m_dstSeqNo;         ///< Destination Sequence Number
   Ipv4Address   m_origin;           ///< Source IP Address
   uint32_t      m_lifeTime;         ///< Lifetime (in milliseconds)
-  uint32_t      m_txErrorCount;    ///< number of successful txerror by this node
+  uint32_t      m_txErrorCount;    ///< decayed tx error rate of this node, 1/1000 errors per second
   uint32_t      m_freeSpace;        ///< free space left in this node
-  uint32_t      m_positionX;        ///< x position of node
-  uint32_t      m_positionY;        ///< y position of node
-  
-  
+  double        m_positionX;        ///< x position of node
+  double        m_positionY;        ///< y position of node
+  uint8_t       m_positionEncoding; ///< absolute, keyframe or delta position (C flag)
+  uint8_t       m_keyframe;         ///< keyframe number of the position (C flag)
+  double        m_referenceX;       ///< x position of the keyframe of a delta position
+  double        m_referenceY;       ///< y position of the keyframe of a delta position
+  int32_t       m_velocityX;        ///< x velocity of node, mm/s (V flag)
+  int32_t       m_velocityY;        ///< y velocity of node, mm/s (V flag)
+  uint32_t      m_positionTime;     ///< time the position was sampled at, ms (V flag)
+  std::vector<LocationGossip> m_gossip; ///< positions of other nodes (G flag)
+  uint8_t       m_macQueue;         ///< MAC queue occupancy, 1/255 (L flag)
+  uint8_t       m_channelBusy;      ///< channel busy fraction, 1/255 (L flag)
 };
 
 /**
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-profiler.h"
+
+#ifdef AODVKMEANS_PROFILING
+
+namespace ns3 {
+namespace aodvKmeans {
+
+uint64_t Profiler::s_calls[Profiler::PROBE_COUNT] = {};
+uint64_t Profiler::s_ns[Profiler::PROBE_COUNT] = {};
+
+const char *
+Profiler::GetProbeName (Probe probe)
+{
+  switch (probe)
+    {
+    case PROBE_ROUTE_INPUT:
+      return "RouteInput";
+    case PROBE_ROUTE_OUTPUT:
+      return "RouteOutput";
+    case PROBE_RECV_REQUEST:
+      return "RecvRequest";
+    case PROBE_RECV_REPLY:
+      return "RecvReply";
+    case PROBE_KMEANS:
+      return "Kmeans";
+    case PROBE_PURGE:
+      return "Purge";
+    case PROBE_ENQUEUE:
+      return "Enqueue";
+    default:
+      return "unknown";
+    }
+}
+
+void
+Profiler::Dump (std::ostream & os)
+{
+  bool called = false;
+  for (uint32_t p = 0; p < PROBE_COUNT; p++)
+    {
+      called = called || s_calls[p] > 0;
+    }
+  if (!called)
+    {
+      return;
+    }
+  os << "probe,calls,totalNs,meanNs" << std::endl;
+  for (uint32_t p = 0; p < PROBE_COUNT; p++)
+    {
+      os << GetProbeName (Probe (p)) << "," << s_calls[p] << "," << s_ns[p]
+         << "," << (s_calls[p] > 0 ? s_ns[p] / s_calls[p] : 0) << std::endl;
+    }
+  Reset ();
+}
+
+void
+Profiler::Reset ()
+{
+  for (uint32_t p = 0; p < PROBE_COUNT; p++)
+    {
+      s_calls[p] = 0;
+      s_ns[p] = 0;
+    }
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* AODVKMEANS_PROFILING */
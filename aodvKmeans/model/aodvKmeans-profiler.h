@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_PROFILER_H
+#define aodvKmeans_PROFILER_H
+
+/**
+ * \ingroup aodvKmeans
+ * \def AODVKMEANS_PROFILE(probe)
+ *
+ * Time the rest of the enclosing scope against a Profiler::Probe.  Expands to
+ * nothing unless aodvKmeans is built with AODVKMEANS_PROFILING defined
+ * (./waf configure --enable-aodvKmeans-profiling).
+ */
+#ifdef AODVKMEANS_PROFILING
+
+#include <chrono>
+#include <ostream>
+#include <stdint.h>
+
+namespace ns3 {
+namespace aodvKmeans {
+
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Wall clock time and number of calls of the hot paths of the protocol.
+ *
+ * The counters are shared by all the nodes of the simulation.  The time of a
+ * probe includes the time of the probes it calls, e.g. PROBE_RECV_REQUEST
+ * includes PROBE_KMEANS when forwarding the RREQ to a cluster.
+ */
+class Profiler
+{
+public:
+  /// Profiled functions
+  enum Probe
+  {
+    PROBE_ROUTE_INPUT,    //!< RoutingProtocol::RouteInput
+    PROBE_ROUTE_OUTPUT,   //!< RoutingProtocol::RouteOutput
+    PROBE_RECV_REQUEST,   //!< RoutingProtocol::RecvRequest
+    PROBE_RECV_REPLY,     //!< RoutingProtocol::RecvReply
+    PROBE_KMEANS,         //!< RoutingTable::Kmeans
+    PROBE_PURGE,          //!< RoutingTable::Purge
+    PROBE_ENQUEUE,        //!< RequestQueue::Enqueue
+    PROBE_COUNT,          //!< number of probes
+  };
+
+  /**
+   * Count a call
+   * \param probe the probe
+   * \param ns the wall clock duration of the call, in nanoseconds
+   */
+  static void Record (Probe probe, uint64_t ns)
+  {
+    s_calls[probe]++;
+    s_ns[probe] += ns;
+  }
+  /**
+   * \param probe the probe
+   * \returns the number of calls
+   */
+  static uint64_t GetCalls (Probe probe)
+  {
+    return s_calls[probe];
+  }
+  /**
+   * \param probe the probe
+   * \returns the total wall clock time of the calls, in nanoseconds
+   */
+  static uint64_t GetNanoSeconds (Probe probe)
+  {
+    return s_ns[probe];
+  }
+  /**
+   * \param probe the probe
+   * \returns the name of the profiled function
+   */
+  static const char * GetProbeName (Probe probe);
+  /**
+   * Print the counters of the probes called since the last dump, then reset them
+   * \param os the output stream
+   */
+  static void Dump (std::ostream & os);
+  /// Reset the counters
+  static void Reset ();
+
+private:
+  static uint64_t s_calls[PROBE_COUNT]; //!< Number of calls, by probe
+  static uint64_t s_ns[PROBE_COUNT];    //!< Wall clock time of the calls, by probe
+};
+
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Record the wall clock time of its lifetime in a probe.
+ */
+class ProfilerScope
+{
+public:
+  /**
+   * Start the timer
+   * \param probe the probe
+   */
+  explicit ProfilerScope (Profiler::Probe probe)
+    : m_probe (probe),
+      m_start (std::chrono::steady_clock::now ())
+  {
+  }
+  ~ProfilerScope ()
+  {
+    Profiler::Record (m_probe, std::chrono::duration_cast<std::chrono::nanoseconds> (
+                        std::chrono::steady_clock::now () - m_start).count ());
+  }
+
+private:
+  Profiler::Probe m_probe;                             //!< The probe
+  std::chrono::steady_clock::time_point m_start;       //!< Start of the scope
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#define AODVKMEANS_PROFILE(probe) \
+  ns3::aodvKmeans::ProfilerScope aodvKmeansProfilerScope (ns3::aodvKmeans::Profiler::probe)
+
+#else /* AODVKMEANS_PROFILING */
+
+#define AODVKMEANS_PROFILE(probe)
+
+#endif /* AODVKMEANS_PROFILING */
+
+#endif /* aodvKmeans_PROFILER_H */
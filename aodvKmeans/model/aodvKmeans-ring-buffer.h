@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_RING_BUFFER_H
+#define aodvKmeans_RING_BUFFER_H
+
+#include <vector>
+#include <stdint.h>
+#include "ns3/assert.h"
+
+namespace ns3 {
+namespace aodvKmeans {
+
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Fixed capacity buffer keeping the most recent items.
+ *
+ * Once full, each new item overwrites the oldest one.  The storage is
+ * allocated once, when the capacity is set.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+  /**
+   * constructor
+   * \param capacity the largest number of items kept
+   */
+  explicit RingBuffer (uint32_t capacity = 0)
+    : m_items (capacity),
+      m_head (0),
+      m_size (0)
+  {
+  }
+  /**
+   * Add an item, overwriting the oldest one if full
+   * \param item the item
+   */
+  void Push (T const & item)
+  {
+    if (m_items.empty ())
+      {
+        return;
+      }
+    m_items[(m_head + m_size) % m_items.size ()] = item;
+    if (m_size < m_items.size ())
+      {
+        m_size++;
+      }
+    else
+      {
+        m_head = (m_head + 1) % m_items.size ();
+      }
+  }
+  /**
+   * \param i the index of the item, 0 for the oldest
+   * \returns the item
+   */
+  T const & Get (uint32_t i) const
+  {
+    NS_ASSERT (i < m_size);
+    return m_items[(m_head + i) % m_items.size ()];
+  }
+  /**
+   * \returns the number of items
+   */
+  uint32_t GetSize () const
+  {
+    return m_size;
+  }
+  /**
+   * \returns the largest number of items kept
+   */
+  uint32_t GetCapacity () const
+  {
+    return m_items.size ();
+  }
+  /**
+   * Change the capacity, removing all items
+   * \param capacity the largest number of items kept
+   */
+  void SetCapacity (uint32_t capacity)
+  {
+    m_items.assign (capacity, T ());
+    Clear ();
+  }
+  /// Remove all items
+  void Clear ()
+  {
+    m_head = 0;
+    m_size = 0;
+  }
+
+private:
+  std::vector<T> m_items; //!< Storage
+  uint32_t m_head;        //!< Position of the oldest item
+  uint32_t m_size;        //!< Number of items
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_RING_BUFFER_H */
@@ -29,8 +29,11 @@
   if (m_ipv4) { std::clog << "[node " << m_ipv4->GetObject<Node> ()->GetId () << "] "; }
 
 #include "aodvKmeans-routing-protocol.h"
+#include "aodvKmeans-profiler.h"
 #include "ns3/log.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/double.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/trace-source-accessor.h"
@@ -40,10 +43,15 @@
 #include "ns3/wifi-net-device.h"
 #include "ns3/adhoc-wifi-mac.h"
 #include "ns3/wifi-mac-queue-item.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/llc-snap-header.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include <algorithm>
+#include <functional>
 #include <limits>
+#include <iterator>
+#include <sstream>
 
 namespace ns3 {
 
@@ -55,6 +63,39 @@ NS_OBJECT_ENSURE_REGISTERED (RoutingProtocol);
 /// UDP Port for aodvKmeans control traffic
 const uint32_t RoutingProtocol::aodvKmeans_PORT = 654;
 
+/// Transmission error rates are advertised in units of 1/TX_ERROR_RATE_SCALE errors per second
+static const double TX_ERROR_RATE_SCALE = 1000.0;
+
+/**
+ * \param timer a route request timer
+ * \returns true if no discovery is running, so that the timer may be evicted
+ */
+static bool
+IsRequestTimerIdle (Timer const & timer)
+{
+  return !timer.IsRunning ();
+}
+
+/**
+ * \param spec a feature descriptor string
+ * \param key a descriptor key
+ * \returns true if the string sets the key
+ */
+static bool
+SpecifiesKey (std::string const & spec, std::string const & key)
+{
+  std::istringstream stream (spec);
+  std::string item;
+  while (std::getline (stream, item, '|'))
+    {
+      if (item.compare (0, key.size () + 1, key + "=") == 0)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
 /**
 * \ingroup aodvKmeans
 * \brief Tag used by aodvKmeans implementation
@@ -154,6 +195,11 @@ RoutingProtocol::RoutingProtocol ()
     m_myRouteTimeout (Time (2 * std::max (m_pathDiscoveryTime, m_activeRouteTimeout))),
     m_helloInterval (Seconds (1)),
     m_allowedHelloLoss (2),
+    m_adaptiveHello (false),
+    m_minHelloInterval (MilliSeconds (500)),
+    m_maxHelloInterval (Seconds (5)),
+    m_helloMovementThreshold (5),
+    m_currentHelloInterval (m_helloInterval),
     m_deletePeriod (Time (5 * std::max (m_activeRouteTimeout, m_helloInterval))),
     m_nextHopWait (m_nodeTraversalTime + MilliSeconds (10)),
     m_blackListTimeout (Time (m_rreqRetries * m_netTraversalTime)),
@@ -162,23 +208,55 @@ RoutingProtocol::RoutingProtocol ()
     m_destinationOnly (false),
     m_gratuitousReply (true),
     m_enableHello (false),
+    m_enableVelocity (false),
+    m_kmeansExtension (KMEANS_EXT_LEGACY),
+    m_helloKeyframeInterval (8),
+    m_locationService (false),
+    m_locationGossipSize (0),
+    m_kmeansClusterCount (KMEANS_K_FIXED),
+    m_kmeansClusters (2),
+    m_kmeansMaxClusters (8),
+    m_targetForwarders (4),
+    m_kmeansMinInertiaDrop (0.3),
+    m_maxForwarders (0),
+    m_freeSpaceMaxSet (false),
+    m_freeSpaceIdealSet (false),
+    m_advertiseChannelLoad (false),
+    m_snrSmoothing (0.25),
     m_routingTable (m_deletePeriod),
     m_queue (m_maxQueueLen, m_maxQueueTime),
     m_requestId (0),
     m_seqNo (0),
     m_rreqIdCache (m_pathDiscoveryTime),
     m_dpd (m_pathDiscoveryTime),
-    m_nb (m_helloInterval * 2),
     m_rreqCount (0),
     m_rerrCount (0),
-    m_txerrorCount(0),
+    m_linkQuality (Seconds (10)),
+    m_channelLoad (Seconds (1)),
+    m_rxSnr (256),
+    m_locationCache (256, Seconds (30)),
+    m_keyframe (0),
+    m_hellosSinceKeyframe (0),
+    m_lastKnonwCluster (256),
+    m_previousSelection (256),
     m_htimer (Timer::CANCEL_ON_DESTROY),
+    m_helloChurn (0),
+    m_helloMovement (0),
     m_rreqRateLimitTimer (Timer::CANCEL_ON_DESTROY),
     m_rerrRateLimitTimer (Timer::CANCEL_ON_DESTROY),
+    m_queueSampleTimer (Timer::CANCEL_ON_DESTROY),
+    m_queueSampleInterval (Seconds (0)),
+    m_addressReqTimer (256),
     m_lastBcastTime (Seconds (0))
     
 {
   m_nb.SetCallback (MakeCallback (&RoutingProtocol::SendRerrWhenBreaksLinkToNextHop, this));
+  m_nb.SetEventAccounting (&m_events);
+  m_routingTable.SetEventAccounting (&m_events);
+  m_addressReqTimer.SetEvictable (&IsRequestTimerIdle);
+  m_queue.SetDropCallback (MakeCallback (&RoutingProtocol::NotifyQueueDrop, this));
+  m_queue.SetSojournCallback (MakeCallback (&RoutingProtocol::NotifyQueueSojourn, this));
+  m_routingTable.SetChangeCallback (MakeCallback (&RoutingProtocol::NotifyRouteChange, this));
 }
 
 TypeId
@@ -192,6 +270,24 @@ RoutingProtocol::GetTypeId (void)
                    TimeValue (Seconds (1)),
                    MakeTimeAccessor (&RoutingProtocol::m_helloInterval),
                    MakeTimeChecker ())
+    .AddAttribute ("AdaptiveHello", "Indicates whether the hello interval adapts to topology changes, "
+                   "between MinHelloInterval and MaxHelloInterval, starting from HelloInterval.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_adaptiveHello),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MinHelloInterval", "Shortest hello interval when AdaptiveHello is enabled.",
+                   TimeValue (MilliSeconds (500)),
+                   MakeTimeAccessor (&RoutingProtocol::m_minHelloInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxHelloInterval", "Longest hello interval when AdaptiveHello is enabled.",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&RoutingProtocol::m_maxHelloInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("HelloMovementThreshold", "Movement (m) of this node or of a neighbor between two of its hellos "
+                   "that shortens the adaptive hello interval.",
+                   DoubleValue (5),
+                   MakeDoubleAccessor (&RoutingProtocol::m_helloMovementThreshold),
+                   MakeDoubleChecker<double> (0))
     .AddAttribute ("TtlStart", "Initial TTL value for RREQ.",
                    UintegerValue (1),
                    MakeUintegerAccessor (&RoutingProtocol::m_ttlStart),
@@ -269,6 +365,39 @@ RoutingProtocol::GetTypeId (void)
                    MakeTimeAccessor (&RoutingProtocol::SetMaxQueueTime,
                                      &RoutingProtocol::GetMaxQueueTime),
                    MakeTimeChecker ())
+    .AddAttribute ("QueueScheduling", "Scheduling discipline of the route discovery buffer: a single drop-front queue, "
+                   "or per-flow fair queuing with DSCP priority classes.",
+                   EnumValue (QUEUE_FIFO),
+                   MakeEnumAccessor (&RoutingProtocol::SetQueueScheduling,
+                                     &RoutingProtocol::GetQueueScheduling),
+                   MakeEnumChecker (QUEUE_FIFO, "Fifo",
+                                    QUEUE_FAIR, "Fair"))
+    .AddAttribute ("QueueFlowKey", "How buffered packets are grouped into flows when QueueScheduling is Fair.",
+                   EnumValue (FLOW_BY_DESTINATION),
+                   MakeEnumAccessor (&RoutingProtocol::SetQueueFlowKey,
+                                     &RoutingProtocol::GetQueueFlowKey),
+                   MakeEnumChecker (FLOW_BY_DESTINATION, "Destination",
+                                    FLOW_BY_FIVE_TUPLE, "FiveTuple"))
+    .AddAttribute ("QueueFlowQuota", "Maximum number of packets a single flow may buffer when QueueScheduling is Fair (0 for no quota).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RoutingProtocol::SetQueueFlowQuota,
+                                         &RoutingProtocol::GetQueueFlowQuota),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("QueueQuantum", "Deficit round robin quantum (bytes) used when QueueScheduling is Fair.",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&RoutingProtocol::SetQueueQuantum,
+                                         &RoutingProtocol::GetQueueQuantum),
+                   MakeUintegerChecker<uint32_t> (64))
+    .AddAttribute ("QueueSampleInterval", "Interval between samples of the route discovery buffer occupancy "
+                   "(0 to disable sampling).",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&RoutingProtocol::m_queueSampleInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("QueueSampleCapacity", "Number of most recent route discovery buffer occupancy samples kept.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&RoutingProtocol::SetQueueSampleCapacity,
+                                         &RoutingProtocol::GetQueueSampleCapacity),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("AllowedHelloLoss", "Number of hello messages which may be loss for valid link.",
                    UintegerValue (2),
                    MakeUintegerAccessor (&RoutingProtocol::m_allowedHelloLoss),
@@ -293,11 +422,262 @@ RoutingProtocol::GetTypeId (void)
                    MakeBooleanAccessor (&RoutingProtocol::SetBroadcastEnable,
                                         &RoutingProtocol::GetBroadcastEnable),
                    MakeBooleanChecker ())
+    .AddAttribute ("TxErrorHalfLife", "Half-life of the per-link transmission error statistics advertised in hellos "
+                   "and used to select forwarders.",
+                   TimeValue (Seconds (10)),
+                   MakeTimeAccessor (&RoutingProtocol::SetTxErrorHalfLife,
+                                     &RoutingProtocol::GetTxErrorHalfLife),
+                   MakeTimeChecker ())
+    .AddAttribute ("EnableVelocity", "Indicates whether hellos and replies carry the velocity of the node, "
+                   "used to extrapolate positions when selecting forwarders.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableVelocity),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxPositionExtrapolation", "Longest extrapolation of an advertised position from its velocity, "
+                   "0 uses the advertised positions as they are.",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&RoutingProtocol::SetMaxPositionExtrapolation,
+                                     &RoutingProtocol::GetMaxPositionExtrapolation),
+                   MakeTimeChecker ())
+    .AddAttribute ("DpdMode", "Duplicate detection of broadcast data packets: an exact cache of every packet seen, "
+                   "or a fixed size rotating Bloom filter.",
+                   EnumValue (DPD_EXACT),
+                   MakeEnumAccessor (&RoutingProtocol::SetDpdMode,
+                                     &RoutingProtocol::GetDpdMode),
+                   MakeEnumChecker (DPD_EXACT, "Exact",
+                                    DPD_BLOOM, "Bloom"))
+    .AddAttribute ("KmeansExtension", "Encoding of the K-means metrics in the hellos and replies of this node. "
+                   "Nodes decode every encoding, so it can differ between nodes.",
+                   EnumValue (KMEANS_EXT_LEGACY),
+                   MakeEnumAccessor (&RoutingProtocol::m_kmeansExtension),
+                   MakeEnumChecker (KMEANS_EXT_LEGACY, "Legacy",
+                                    KMEANS_EXT_COMPACT, "Compact",
+                                    KMEANS_EXT_NONE, "None"))
+    .AddAttribute ("HelloKeyframeInterval", "With the compact encoding, number of hellos between two absolute positions; "
+                   "the others carry an offset to the last one. 1 sends absolute positions only.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&RoutingProtocol::m_helloKeyframeInterval),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("LocationCacheSize", "Maximum number of positions of other nodes remembered, "
+                   "the least recently used one is evicted when full.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&RoutingProtocol::SetLocationCacheSize,
+                                         &RoutingProtocol::GetLocationCacheSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ClusterCacheSize", "Maximum number of destinations whose last cluster of forwarders is remembered, "
+                   "the least recently used one is evicted when full.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&RoutingProtocol::SetClusterCacheSize,
+                                         &RoutingProtocol::GetClusterCacheSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("SelectionHistorySize", "Maximum number of destinations whose last K-means selection is remembered "
+                   "to trace the selection stability, the least recently used one is evicted when full.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&RoutingProtocol::SetSelectionHistorySize,
+                                         &RoutingProtocol::GetSelectionHistorySize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("RequestTimerCacheSize", "Maximum number of route request timers kept, the least recently used "
+                   "timer without a running discovery is evicted when full.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&RoutingProtocol::SetRequestTimerCacheSize,
+                                         &RoutingProtocol::GetRequestTimerCacheSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("LocationMaxAge", "Age after which a remembered position is forgotten.",
+                   TimeValue (Seconds (30)),
+                   MakeTimeAccessor (&RoutingProtocol::SetLocationMaxAge,
+                                     &RoutingProtocol::GetLocationMaxAge),
+                   MakeTimeChecker ())
+    .AddAttribute ("LocationMaxSpeed", "Speed bounding the movement of nodes (m/s), "
+                   "from which the error radius of a remembered position grows.",
+                   DoubleValue (20),
+                   MakeDoubleAccessor (&RoutingProtocol::SetLocationMaxSpeed,
+                                       &RoutingProtocol::GetLocationMaxSpeed),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LocationConfidenceRadius", "Largest error radius (m) of the destination position for which "
+                   "RREQs are sent to a cluster of neighbors rather than broadcast.",
+                   DoubleValue (250),
+                   MakeDoubleAccessor (&RoutingProtocol::SetLocationConfidenceRadius,
+                                       &RoutingProtocol::GetLocationConfidenceRadius),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LocationService", "Indicates whether RREQs carry the position of their originator, "
+                   "which every node receiving them remembers for forwarder selection.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_locationService),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LocationGossipSize", "Number of recently learned positions of non-neighbors gossiped in each hello, "
+                   "0 disables the gossip.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RoutingProtocol::m_locationGossipSize),
+                   MakeUintegerChecker<uint32_t> (0, 255))
+    .AddAttribute ("KmeansClusterCount", "How the number of clusters of forwarder candidates is chosen: "
+                   "Fixed uses KmeansClusters, Target enough clusters for TargetForwarders per cluster, "
+                   "Elbow adds clusters while each reduces the inertia by at least KmeansMinInertiaDrop.",
+                   EnumValue (KMEANS_K_FIXED),
+                   MakeEnumAccessor (&RoutingProtocol::m_kmeansClusterCount),
+                   MakeEnumChecker (KMEANS_K_FIXED, "Fixed",
+                                    KMEANS_K_TARGET, "Target",
+                                    KMEANS_K_ELBOW, "Elbow"))
+    .AddAttribute ("KmeansClusters", "Number of clusters of forwarder candidates when KmeansClusterCount is Fixed.",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&RoutingProtocol::m_kmeansClusters),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KmeansMaxClusters", "Largest number of clusters of forwarder candidates when KmeansClusterCount is Target or Elbow.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&RoutingProtocol::m_kmeansMaxClusters),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("TargetForwarders", "Forwarders per cluster aimed at when KmeansClusterCount is Target.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&RoutingProtocol::m_targetForwarders),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("KmeansMinInertiaDrop", "Smallest relative inertia reduction worth one more cluster when KmeansClusterCount is Elbow.",
+                   DoubleValue (0.3),
+                   MakeDoubleAccessor (&RoutingProtocol::m_kmeansMinInertiaDrop),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("MaxForwarders", "Largest number of neighbors a RREQ is unicast to, the airtime budget of a "
+                   "clustered RREQ; the candidates closest to the destination are kept. 0 for no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxForwarders),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DistanceFeature", "Forwarder selection feature: squared distance to the destination (m^2). "
+                   "\"Key=value\" pairs separated by '|' among Enabled, Weight, Normalization "
+                   "(MinMax, ZScore or FixedRange), Min, Max (the FixedRange) and Ideal (the value of the ideal forwarder).",
+                   StringValue ("Enabled=true|Weight=1|Normalization=MinMax|Min=0|Max=1|Ideal=0"),
+                   MakeStringAccessor (&RoutingProtocol::SetDistanceFeature,
+                                       &RoutingProtocol::GetDistanceFeature),
+                   MakeStringChecker ())
+    .AddAttribute ("TxErrorFeature", "Forwarder selection feature: transmission errors of the candidate and of the link to it, "
+                   "described as DistanceFeature.",
+                   StringValue ("Enabled=true|Weight=1|Normalization=MinMax|Min=0|Max=1|Ideal=0"),
+                   MakeStringAccessor (&RoutingProtocol::SetTxErrorFeature,
+                                       &RoutingProtocol::GetTxErrorFeature),
+                   MakeStringChecker ())
+    .AddAttribute ("FreeSpaceFeature", "Forwarder selection feature: free space in the buffer of the candidate (packets), "
+                   "described as DistanceFeature. Max and Ideal follow MaxQueueLen unless given.",
+                   StringValue ("Enabled=true|Weight=1|Normalization=FixedRange|Min=0"),
+                   MakeStringAccessor (&RoutingProtocol::SetFreeSpaceFeature,
+                                       &RoutingProtocol::GetFreeSpaceFeature),
+                   MakeStringChecker ())
+    .AddAttribute ("MacQueueFeature", "Forwarder selection feature: occupancy of the MAC queues of the candidate (0 to 1), "
+                   "described as DistanceFeature. Only known for candidates with AdvertiseChannelLoad set.",
+                   StringValue ("Enabled=false|Weight=1|Normalization=MinMax|Min=0|Max=1|Ideal=0"),
+                   MakeStringAccessor (&RoutingProtocol::SetMacQueueFeature,
+                                       &RoutingProtocol::GetMacQueueFeature),
+                   MakeStringChecker ())
+    .AddAttribute ("ChannelBusyFeature", "Forwarder selection feature: fraction of time the channel of the candidate was busy "
+                   "(0 to 1), described as DistanceFeature. Only known for candidates with AdvertiseChannelLoad set.",
+                   StringValue ("Enabled=false|Weight=1|Normalization=MinMax|Min=0|Max=1|Ideal=0"),
+                   MakeStringAccessor (&RoutingProtocol::SetChannelBusyFeature,
+                                       &RoutingProtocol::GetChannelBusyFeature),
+                   MakeStringChecker ())
+    .AddAttribute ("SnrFeature", "Forwarder selection feature: smoothed SNR (dB) of the hellos received over the link "
+                   "to the candidate, described as DistanceFeature. Links never measured count as average ones.",
+                   StringValue ("Enabled=false|Weight=1|Normalization=MinMax|Min=0|Max=1|Ideal=40"),
+                   MakeStringAccessor (&RoutingProtocol::SetSnrFeature,
+                                       &RoutingProtocol::GetSnrFeature),
+                   MakeStringChecker ())
+    .AddAttribute ("SnrCacheSize", "Maximum number of nodes whose last SNR is remembered until their next hello, "
+                   "the least recently heard one is evicted when full.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&RoutingProtocol::SetSnrCacheSize,
+                                         &RoutingProtocol::GetSnrCacheSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("SnrSmoothing", "Weight of the SNR of a new hello in the moving average of the SNR of its link.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&RoutingProtocol::m_snrSmoothing),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("AdvertiseChannelLoad", "Indicates whether hellos and replies carry the MAC queue occupancy "
+                   "and the channel busy fraction of their originator.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_advertiseChannelLoad),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ChannelLoadWindow", "Length of the windows the channel busy fraction is measured over.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::SetChannelLoadWindow,
+                                     &RoutingProtocol::GetChannelLoadWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("DpdBloomCapacity", "Number of broadcast packets remembered per PathDiscoveryTime when DpdMode is Bloom.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&RoutingProtocol::SetDpdBloomCapacity,
+                                         &RoutingProtocol::GetDpdBloomCapacity),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("DpdBloomFalsePositiveRate", "Target rate of packets wrongly taken for duplicates when DpdMode is Bloom.",
+                   DoubleValue (0.001),
+                   MakeDoubleAccessor (&RoutingProtocol::SetDpdBloomFpRate,
+                                       &RoutingProtocol::GetDpdBloomFpRate),
+                   MakeDoubleChecker<double> (1e-9, 0.5))
     .AddAttribute ("UniformRv",
                    "Access to the underlying UniformRandomVariable",
                    StringValue ("ns3::UniformRandomVariable"),
                    MakePointerAccessor (&RoutingProtocol::m_uniformRandomVariable),
                    MakePointerChecker<UniformRandomVariable> ())
+    .AddTraceSource ("RequestQueueDrop", "A packet was dropped from the route discovery buffer.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_queueDropTrace),
+                     "ns3::aodvKmeans::RequestQueue::DropTracedCallback")
+    .AddTraceSource ("RequestQueueSojourn", "A packet left the route discovery buffer, dequeued or dropped.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_queueSojournTrace),
+                     "ns3::aodvKmeans::RequestQueue::SojournTracedCallback")
+    .AddTraceSource ("RequestQueueOccupancy", "The occupancy of the route discovery buffer was sampled.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_queueSampleTrace),
+                     "ns3::aodvKmeans::RequestQueue::SampleTracedCallback")
+    .AddTraceSource ("ClusteredRreqs", "Number of RREQs originated or forwarded to a cluster of neighbors.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_clusteredRreqs),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("FloodedRreqs", "Number of RREQs originated or forwarded by broadcast.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_floodedRreqs),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("CurrentHelloInterval", "The hello interval in use.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_currentHelloInterval),
+                     "ns3::TracedValueCallback::Time")
+    .AddTraceSource ("RoutingTableSize", "Number of routing table entries, sampled after every control packet "
+                     "received and route discovery started.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_routingTableSize),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("RreqOriginated", "A RREQ was originated, once per interface.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_rreqOriginateTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::RreqTracedCallback")
+    .AddTraceSource ("RreqForwarded", "A received RREQ is forwarded.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_rreqForwardTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::RreqTracedCallback")
+    .AddTraceSource ("RreqDropped", "A received RREQ was dropped, with the reason (see RreqDropReason).",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_rreqDropTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::RreqDropTracedCallback")
+    .AddTraceSource ("RreqSent", "A RREQ was sent from an interface, to a cluster of neighbors or broadcast.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_rreqSendTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::RreqSendTracedCallback")
+    .AddTraceSource ("KmeansClustering", "Forwarders were selected by K-means.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_kmeansTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::KmeansTracedCallback")
+    .AddTraceSource ("ClusterQuality", "Quality of the clusters of a forwarder selection by K-means, "
+                     "and its stability for the destination.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_clusterQualityTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::ClusterQualityTracedCallback")
+    .AddTraceSource ("ClusterCache", "The cluster of forwarders of a destination was looked up in the cache.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_clusterCacheTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::ClusterCacheTracedCallback")
+    .AddTraceSource ("RrepSent", "A RREP was originated or forwarded.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_rrepSendTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::RrepTracedCallback")
+    .AddTraceSource ("RrepReceived", "A RREP other than a hello was received.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_rrepReceiveTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::RrepTracedCallback")
+    .AddTraceSource ("RerrSent", "A RERR was sent.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_rerrSendTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::RerrTracedCallback")
+    .AddTraceSource ("RouteReplyLatency", "Time from the first RREQ of a route discovery for buffered packets "
+                     "to its first RREP.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_replyLatencyTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::DiscoveryLatencyTracedCallback")
+    .AddTraceSource ("RouteDiscoveryLatency", "Time from buffering the first packet of a route discovery "
+                     "to sending the buffered packets.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_discoveryLatencyTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::DiscoveryLatencyTracedCallback")
+    .AddTraceSource ("RouteDiscoveryStarted", "The first RREQ of a route discovery for buffered packets was sent.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_discoveryStartTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::DiscoveryTracedCallback")
+    .AddTraceSource ("RouteChanged", "A route became valid or changed its next hop, or a valid route "
+                     "was invalidated.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_routeChangeTrace),
+                     "ns3::aodvKmeans::RoutingProtocol::RouteChangeTracedCallback")
   ;
   return tid;
 }
@@ -305,6 +685,17 @@ RoutingProtocol::GetTypeId (void)
 void
 RoutingProtocol::SetMaxQueueLen (uint32_t len)
 {
+  // The free space feature follows the buffer size, unless configured otherwise
+  FeatureDescriptor freeSpace = m_featureSpace.GetDescriptor (FeatureSpace::FEATURE_FREE_SPACE);
+  if (!m_freeSpaceMaxSet)
+    {
+      freeSpace.m_max = len;
+    }
+  if (!m_freeSpaceIdealSet)
+    {
+      freeSpace.m_ideal = len;
+    }
+  m_featureSpace.SetDescriptor (FeatureSpace::FEATURE_FREE_SPACE, freeSpace);
   m_maxQueueLen = len;
   m_queue.SetMaxQueueLen (len);
 }
@@ -315,6 +706,24 @@ RoutingProtocol::SetMaxQueueTime (Time t)
   m_queue.SetQueueTimeout (t);
 }
 
+void
+RoutingProtocol::NotifyQueueDrop (Ptr<const Packet> p, const Ipv4Header & header, std::string reason, uint8_t priorityClass)
+{
+  m_queueDropTrace (p, header, reason, priorityClass);
+}
+
+void
+RoutingProtocol::NotifyQueueSojourn (Ptr<const Packet> p, const Ipv4Header & header, Time sojourn, bool dropped)
+{
+  m_queueSojournTrace (p, header, sojourn, dropped);
+}
+
+void
+RoutingProtocol::NotifyRouteChange (RoutingTableEntry const & route, bool valid)
+{
+  m_routeChangeTrace (route, valid);
+}
+
 RoutingProtocol::~RoutingProtocol ()
 {
 }
@@ -335,6 +744,10 @@ RoutingProtocol::DoDispose ()
       iter->first->Close ();
     }
   m_socketSubnetBroadcastAddresses.clear ();
+#ifdef AODVKMEANS_PROFILING
+  // The counters are shared by all nodes: the first node disposed dumps them
+  Profiler::Dump (std::clog);
+#endif /* AODVKMEANS_PROFILING */
   Ipv4RoutingProtocol::DoDispose ();
 }
 
@@ -368,12 +781,17 @@ RoutingProtocol::Start ()
     }
   m_rreqRateLimitTimer.SetFunction (&RoutingProtocol::RreqRateLimitTimerExpire,
                                     this);
-  m_rreqRateLimitTimer.Schedule (Seconds (1));
+  ScheduleTimer (m_rreqRateLimitTimer, Seconds (1), EventAccounting::EVENT_RATE_LIMIT_TIMER);
 
   m_rerrRateLimitTimer.SetFunction (&RoutingProtocol::RerrRateLimitTimerExpire,
                                     this);
-  m_rerrRateLimitTimer.Schedule (Seconds (1));
+  ScheduleTimer (m_rerrRateLimitTimer, Seconds (1), EventAccounting::EVENT_RATE_LIMIT_TIMER);
 
+  if (m_queueSampleInterval.IsStrictlyPositive ())
+    {
+      m_queueSampleTimer.SetFunction (&RoutingProtocol::QueueSampleTimerExpire, this);
+      ScheduleTimer (m_queueSampleTimer, m_queueSampleInterval, EventAccounting::EVENT_QUEUE_SAMPLE_TIMER);
+    }
 }
 
 Ptr<Ipv4Route>
@@ -381,6 +799,7 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
                               Ptr<NetDevice> oif, Socket::SocketErrno &sockerr)
 {
   NS_LOG_FUNCTION (this << header << (oif ? oif->GetIfIndex () : 0));
+  AODVKMEANS_PROFILE (PROBE_ROUTE_OUTPUT);
   if (!p)
     {
       NS_LOG_DEBUG ("Packet is == 0");
@@ -435,7 +854,6 @@ RoutingProtocol::DeferredRouteOutput (Ptr<const Packet> p, const Ipv4Header & he
 
   QueueEntry newEntry (p, header, ucb, ecb);
   bool result = m_queue.Enqueue (newEntry);
-  //std::cout << "my queue size = " << m_queue.GetSize()  << " after adding packet for " << header.GetDestination() << "\n";
   if (result)
     {
       NS_LOG_LOGIC ("Add packet " << p->GetUid () << " to queue. Protocol " << (uint16_t) header.GetProtocol ());
@@ -444,6 +862,12 @@ RoutingProtocol::DeferredRouteOutput (Ptr<const Packet> p, const Ipv4Header & he
       if (!result || ((rt.GetFlag () != IN_SEARCH) && result))
         {
           NS_LOG_LOGIC ("Send new RREQ for outbound packet to " << header.GetDestination ());
+          DiscoveryTiming timing;
+          timing.m_queued = Simulator::Now ();
+          timing.m_rreqs = 0;
+          timing.m_clustered = false;
+          timing.m_replied = false;
+          m_discoveries[header.GetDestination ()] = timing;
           SendRequest (header.GetDestination ());
         }
     }
@@ -455,6 +879,7 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
                              MulticastForwardCallback mcb, LocalDeliverCallback lcb, ErrorCallback ecb)
 {
   NS_LOG_FUNCTION (this << p->GetUid () << header.GetDestination () << idev->GetAddress ());
+  AODVKMEANS_PROFILE (PROBE_ROUTE_INPUT);
   if (m_socketAddresses.empty ())
     {
       NS_LOG_LOGIC ("No aodvKmeans interfaces");
@@ -730,15 +1155,375 @@ RoutingProtocol::NotifyInterfaceUp (uint32_t i)
     }
 
   mac->TraceConnectWithoutContext ("DroppedMpdu", MakeCallback (&RoutingProtocol::NotifyTxError, this));
+  if (m_featureSpace.GetDescriptor (FeatureSpace::FEATURE_SNR).m_enabled)
+    {
+      MonitorSnr (wifi, true);
+    }
+  m_channelLoad.AddDevice (wifi);
 }
 
 void
 RoutingProtocol::NotifyTxError (WifiMacDropReason reason, Ptr<const WifiMacQueueItem> mpdu)
 {
-  m_txerrorCount++;
+  m_linkQuality.RecordTxError (mpdu->GetHeader ().GetAddr1 ());
   m_nb.GetTxErrorCallback ()(mpdu->GetHeader ());
 }
 
+void
+RoutingProtocol::NotifySnifferRx (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                                  MpduInfo aMpdu, SignalNoiseDbm signalNoise, uint16_t staId)
+{
+  // aodvKmeans packets are never aggregated, and are sent again by every hop:
+  // their IP source is the neighbor that transmitted them
+  if (aMpdu.type != NORMAL_MPDU)
+    {
+      return;
+    }
+  Ptr<Packet> p = packet->Copy ();
+  WifiMacHeader hdr;
+  p->RemoveHeader (hdr);
+  if (!hdr.HasData () || (hdr.IsQosData () && hdr.IsQosAmsdu ()))
+    {
+      return;
+    }
+  LlcSnapHeader llc;
+  p->RemoveHeader (llc);
+  if (llc.GetType () != Ipv4L3Protocol::PROT_NUMBER)
+    {
+      return;
+    }
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  if (ipHeader.GetProtocol () != UdpL4Protocol::PROT_NUMBER || ipHeader.GetFragmentOffset () != 0)
+    {
+      return;
+    }
+  UdpHeader udpHeader;
+  p->RemoveHeader (udpHeader);
+  if (udpHeader.GetDestinationPort () == aodvKmeans_PORT)
+    {
+      m_rxSnr.Put (ipHeader.GetSource (), signalNoise.signal - signalNoise.noise);
+    }
+}
+
+void
+RoutingProtocol::MonitorSnr (Ptr<WifiNetDevice> wifi, bool enable)
+{
+  // every overheard frame is parsed down to UDP, only do it while the SNR is used
+  if (enable)
+    {
+      wifi->GetPhy ()->TraceConnectWithoutContext ("MonitorSnifferRx", MakeCallback (&RoutingProtocol::NotifySnifferRx, this));
+    }
+  else
+    {
+      wifi->GetPhy ()->TraceDisconnectWithoutContext ("MonitorSnifferRx", MakeCallback (&RoutingProtocol::NotifySnifferRx, this));
+    }
+}
+
+bool
+RoutingProtocol::GetLinkSnr (Ipv4Address neighbor, double & snr)
+{
+  RoutingTableEntry toNeighbor;
+  if (!m_routingTable.LookupRoute (neighbor, toNeighbor) || !toNeighbor.HasSnr ())
+    {
+      return false;
+    }
+  snr = toNeighbor.GetSnr ();
+  return true;
+}
+
+void
+RoutingProtocol::UpdateLinkSnr (RoutingTableEntry & neighbor)
+{
+  double const * snr = m_rxSnr.Find (neighbor.GetDestination ());
+  if (snr == 0)
+    {
+      return;
+    }
+  neighbor.UpdateSnr (*snr, m_snrSmoothing);
+  m_rxSnr.Erase (neighbor.GetDestination ());
+}
+
+uint32_t
+RoutingProtocol::GetAdvertisedTxError () const
+{
+  return static_cast<uint32_t> (m_linkQuality.GetNodeErrorRate () * TX_ERROR_RATE_SCALE + 0.5);
+}
+
+double
+RoutingProtocol::GetLinkTxError (Ipv4Address nextHop)
+{
+  return m_linkQuality.GetErrorRate (m_nb.GetMacAddress (nextHop)) * TX_ERROR_RATE_SCALE;
+}
+
+void
+RoutingProtocol::AddVelocity (RrepHeader & rrepHeader)
+{
+  if (!m_enableVelocity)
+    {
+      return;
+    }
+  Ptr<MobilityModel> mobility = m_ipv4->GetObject<Node> ()->GetObject<MobilityModel> ();
+  rrepHeader.SetVelocity (mobility->GetVelocity (), Simulator::Now ());
+}
+
+void
+RoutingProtocol::AddChannelLoad (RrepHeader & rrepHeader)
+{
+  if (!m_advertiseChannelLoad)
+    {
+      return;
+    }
+  rrepHeader.SetChannelLoad (m_channelLoad.GetMacQueueOccupancy (), m_channelLoad.GetChannelBusy ());
+}
+
+bool
+RoutingProtocol::LearnPosition (Ipv4Address node, double positionX, double positionY, Time sampled)
+{
+  return m_locationCache.Update (node, Vector (positionX, positionY, 0), sampled);
+}
+
+void
+RoutingProtocol::UpdateLastKnownPosition (RrepHeader const & rrepHeader)
+{
+  Time sampled = rrepHeader.HasVelocity () ? rrepHeader.GetPositionTime () : Simulator::Now ();
+  if (!LearnPosition (rrepHeader.GetDst (), rrepHeader.GetPosition ().first, rrepHeader.GetPosition ().second, sampled))
+    {
+      return;
+    }
+  if (rrepHeader.HasVelocity ())
+    {
+      m_locationCache.SetVelocity (rrepHeader.GetDst (), rrepHeader.GetVelocity ());
+    }
+}
+
+void
+RoutingProtocol::AddLocationGossip (RrepHeader & helloHeader)
+{
+  if (m_locationGossipSize == 0)
+    {
+      return;
+    }
+  // Neighbors advertise their own position, gossip the most recent ones of the other nodes
+  std::vector<std::pair<Ipv4Address, LocationCache::Location> > locations = m_locationCache.GetLocations ();
+  std::vector<std::pair<Time, uint32_t> > recent;
+  for (uint32_t i = 0; i < locations.size (); ++i)
+    {
+      if (!m_nb.IsNeighbor (locations[i].first))
+        {
+          recent.push_back (std::make_pair (locations[i].second.m_sampled, i));
+        }
+    }
+  uint32_t count = std::min<uint32_t> (std::min<uint32_t> (m_locationGossipSize, 255), recent.size ());
+  std::partial_sort (recent.begin (), recent.begin () + count, recent.end (),
+                     std::greater<std::pair<Time, uint32_t> > ());
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      std::pair<Ipv4Address, LocationCache::Location> const & location = locations[recent[i].second];
+      LocationGossip gossip;
+      gossip.m_node = location.first;
+      gossip.m_positionX = location.second.m_position.x;
+      gossip.m_positionY = location.second.m_position.y;
+      gossip.m_age = Simulator::Now () - location.second.m_sampled;
+      helloHeader.AddLocationGossip (gossip);
+    }
+}
+
+bool
+RoutingProtocol::NextHelloKeyframe ()
+{
+  if (m_hellosSinceKeyframe == 0 || m_hellosSinceKeyframe >= m_helloKeyframeInterval
+      || !RrepHeader::FitsPositionDelta (m_position.x - m_keyframePosition.x, m_position.y - m_keyframePosition.y))
+    {
+      m_keyframe++;
+      m_keyframePosition = m_position;
+      m_hellosSinceKeyframe = 1;
+      return true;
+    }
+  m_hellosSinceKeyframe++;
+  return false;
+}
+
+bool
+RoutingProtocol::ResolvePosition (RrepHeader & rrepHeader, bool & located)
+{
+  Ipv4Address origin = rrepHeader.GetDst ();
+  bool known = true;
+  located = true;
+  if (rrepHeader.GetKmeansExtension () == KMEANS_EXT_NONE)
+    {
+      known = false;
+    }
+  else if (rrepHeader.IsPositionKeyframe ())
+    {
+      std::pair<double, double> position = rrepHeader.GetPosition ();
+      m_neighborKeyframes[origin] = std::make_pair (rrepHeader.GetPositionKeyframe (), Vector (position.first, position.second, 0));
+    }
+  else if (rrepHeader.IsPositionDelta ())
+    {
+      std::map<Ipv4Address, std::pair<uint8_t, Vector> >::const_iterator i = m_neighborKeyframes.find (origin);
+      if (i != m_neighborKeyframes.end () && i->second.first == rrepHeader.GetPositionKeyframe ())
+        {
+          rrepHeader.ResolvePositionDelta (i->second.second.x, i->second.second.y);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("Missed position keyframe " << uint32_t (rrepHeader.GetPositionKeyframe ()) << " of " << origin);
+          known = false;
+        }
+    }
+  if (!known)
+    {
+      LocationCache::Location last;
+      if (m_locationCache.Lookup (origin, last))
+        {
+          rrepHeader.SetPosition (last.m_position.x, last.m_position.y);
+        }
+      else
+        {
+          rrepHeader.SetPosition (0, 0);
+          located = false;
+        }
+    }
+  return known;
+}
+
+KmeansParameters
+RoutingProtocol::GetKmeansParameters () const
+{
+  KmeansParameters parameters;
+  parameters.m_clusterCount = m_kmeansClusterCount;
+  parameters.m_clusters = m_kmeansClusters;
+  parameters.m_maxClusters = m_kmeansMaxClusters;
+  parameters.m_targetForwarders = m_targetForwarders;
+  parameters.m_minInertiaDrop = m_kmeansMinInertiaDrop;
+  parameters.m_maxForwarders = m_maxForwarders;
+  parameters.m_featureSpace = m_featureSpace;
+  return parameters;
+}
+
+std::vector<Ipv4Address>
+RoutingProtocol::SelectForwarders (Ipv4Address dst, Vector const & posDst)
+{
+  std::vector<Ipv4Address> const * cached = m_lastKnonwCluster.Find (dst);
+  m_clusterCacheTrace (dst, cached != 0);
+  if (cached != 0)
+    {
+      return *cached;
+    }
+  KmeansQuality quality;
+  std::vector<Ipv4Address> selected = m_routingTable.Kmeans (dst, posDst.x, posDst.y, GetKmeansParameters (),
+                                                             MakeCallback (&RoutingProtocol::GetLinkTxError, this),
+                                                             &quality);
+  m_kmeansTrace (dst, quality.m_candidates, selected);
+  if (quality.m_candidates > 0)
+    {
+      std::vector<Ipv4Address> const * previous = m_previousSelection.Find (dst);
+      m_clusterQualityTrace (dst, quality, previous == 0 ? -1 : Jaccard (*previous, selected));
+      m_previousSelection.Put (dst, selected);
+    }
+  return selected;
+}
+
+double
+RoutingProtocol::Jaccard (std::vector<Ipv4Address> a, std::vector<Ipv4Address> b)
+{
+  std::sort (a.begin (), a.end ());
+  a.erase (std::unique (a.begin (), a.end ()), a.end ());
+  std::sort (b.begin (), b.end ());
+  b.erase (std::unique (b.begin (), b.end ()), b.end ());
+  std::vector<Ipv4Address> common;
+  std::set_intersection (a.begin (), a.end (), b.begin (), b.end (), std::back_inserter (common));
+  uint32_t united = a.size () + b.size () - common.size ();
+  return united == 0 ? 1 : double (common.size ()) / united;
+}
+
+MemoryUsage
+RoutingProtocol::GetMemoryUsage () const
+{
+  MemoryUsage usage;
+  usage.Add (MemoryUsage::MEMORY_ROUTING_TABLE, m_routingTable.GetMemoryBytes ());
+  usage.Add (MemoryUsage::MEMORY_PRECURSORS, m_routingTable.GetPrecursorMemoryBytes ());
+  usage.Add (MemoryUsage::MEMORY_REQUEST_QUEUE, m_queue.GetMemoryBytes ());
+  usage.Add (MemoryUsage::MEMORY_QUEUED_PACKETS, m_queue.GetPacketBytes ());
+  usage.Add (MemoryUsage::MEMORY_ID_CACHE, m_rreqIdCache.GetMemoryBytes ());
+  usage.Add (MemoryUsage::MEMORY_DPD, m_dpd.GetMemoryBytes ());
+  usage.Add (MemoryUsage::MEMORY_NEIGHBORS, m_nb.GetMemoryBytes ());
+  usage.Add (MemoryUsage::MEMORY_LOCATION_CACHE, m_locationCache.GetMemoryBytes ());
+  usage.AddEvictions (MemoryUsage::MEMORY_LOCATION_CACHE, m_locationCache.GetEvictions ());
+  usage.Add (MemoryUsage::MEMORY_CLUSTER_CACHE, m_lastKnonwCluster.GetMemoryBytes ());
+  usage.AddEvictions (MemoryUsage::MEMORY_CLUSTER_CACHE, m_lastKnonwCluster.GetEvictions ());
+  for (LruCache<Ipv4Address, std::vector<Ipv4Address>, Ipv4AddressHash>::ConstIterator i = m_lastKnonwCluster.Begin ();
+       i != m_lastKnonwCluster.End (); ++i)
+    {
+      usage.Add (MemoryUsage::MEMORY_CLUSTER_CACHE, MemoryBytes (i->second));
+    }
+  usage.Add (MemoryUsage::MEMORY_REQUEST_TIMERS, m_addressReqTimer.GetMemoryBytes ());
+  usage.AddEvictions (MemoryUsage::MEMORY_REQUEST_TIMERS, m_addressReqTimer.GetEvictions ());
+  usage.Add (MemoryUsage::MEMORY_OTHER_TABLES, m_previousSelection.GetMemoryBytes ());
+  usage.AddEvictions (MemoryUsage::MEMORY_OTHER_TABLES, m_previousSelection.GetEvictions ());
+  for (LruCache<Ipv4Address, std::vector<Ipv4Address>, Ipv4AddressHash>::ConstIterator i = m_previousSelection.Begin ();
+       i != m_previousSelection.End (); ++i)
+    {
+      usage.Add (MemoryUsage::MEMORY_OTHER_TABLES, MemoryBytes (i->second));
+    }
+  usage.Add (MemoryUsage::MEMORY_OTHER_TABLES, m_rxSnr.GetMemoryBytes ());
+  usage.AddEvictions (MemoryUsage::MEMORY_OTHER_TABLES, m_rxSnr.GetEvictions ());
+  usage.Add (MemoryUsage::MEMORY_OTHER_TABLES, MemoryBytes (m_discoveries)
+             + MemoryBytes (m_neighborKeyframes) + m_linkQuality.GetMemoryBytes ());
+  return usage;
+}
+
+void
+RoutingProtocol::SetFreeSpaceFeature (std::string spec)
+{
+  SetFeature (FeatureSpace::FEATURE_FREE_SPACE, spec);
+  m_freeSpaceMaxSet = m_freeSpaceMaxSet || SpecifiesKey (spec, "Max");
+  m_freeSpaceIdealSet = m_freeSpaceIdealSet || SpecifiesKey (spec, "Ideal");
+}
+
+void
+RoutingProtocol::SetFeature (FeatureSpace::Feature feature, std::string const & spec)
+{
+  FeatureDescriptor descriptor = m_featureSpace.GetDescriptor (feature);
+  bool wasEnabled = descriptor.m_enabled;
+  NS_ABORT_MSG_UNLESS (descriptor.Parse (spec), "Malformed feature descriptor \"" << spec << "\"");
+  m_featureSpace.SetDescriptor (feature, descriptor);
+  if (feature != FeatureSpace::FEATURE_SNR || descriptor.m_enabled == wasEnabled || m_ipv4 == 0)
+    {
+      return;
+    }
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      Ptr<WifiNetDevice> wifi = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (j->second.GetLocal ()))->GetObject<WifiNetDevice> ();
+      if (wifi != 0)
+        {
+          MonitorSnr (wifi, descriptor.m_enabled);
+        }
+    }
+  if (!descriptor.m_enabled)
+    {
+      m_rxSnr.Clear ();
+    }
+}
+
+bool
+RoutingProtocol::GetDestinationPosition (Ipv4Address dst, Vector & position)
+{
+  LocationCache::Location location;
+  if (!m_locationCache.Lookup (dst, location))
+    {
+      return false;
+    }
+  if (!m_locationCache.IsConfident (location))
+    {
+      NS_LOG_LOGIC ("Position of " << dst << " is " << m_locationCache.GetErrorRadius (location) << " m uncertain");
+      return false;
+    }
+  position = m_locationCache.GetEstimate (location);
+  return true;
+}
+
 void
 RoutingProtocol::NotifyInterfaceDown (uint32_t i)
 {
@@ -750,6 +1535,8 @@ RoutingProtocol::NotifyInterfaceDown (uint32_t i)
   Ptr<WifiNetDevice> wifi = dev->GetObject<WifiNetDevice> ();
   if (wifi != 0)
     {
+      m_channelLoad.DelDevice (wifi);
+      MonitorSnr (wifi, false);
       Ptr<WifiMac> mac = wifi->GetMac ()->GetObject<AdhocWifiMac> ();
       if (mac != 0)
         {
@@ -774,7 +1561,7 @@ RoutingProtocol::NotifyInterfaceDown (uint32_t i)
   if (m_socketAddresses.empty ())
     {
       NS_LOG_LOGIC ("No aodvKmeans interfaces");
-      m_htimer.Cancel ();
+      CancelTimer (m_htimer, EventAccounting::EVENT_HELLO_TIMER);
       m_nb.Clear ();
       m_routingTable.Clear ();
       return;
@@ -891,7 +1678,7 @@ RoutingProtocol::NotifyRemoveAddress (uint32_t i, Ipv4InterfaceAddress address)
       if (m_socketAddresses.empty ())
         {
           NS_LOG_LOGIC ("No aodvKmeans interfaces");
-          m_htimer.Cancel ();
+          CancelTimer (m_htimer, EventAccounting::EVENT_HELLO_TIMER);
           m_nb.Clear ();
           m_routingTable.Clear ();
           return;
@@ -974,8 +1761,9 @@ RoutingProtocol::SendRequest (Ipv4Address dst)
   // A node SHOULD NOT originate more than RREQ_RATELIMIT RREQ messages per second.
   if (m_rreqCount == m_rreqRateLimit)
     {
+      m_events.Scheduled (EventAccounting::EVENT_DEFERRED_RREQ);
       Simulator::Schedule (m_rreqRateLimitTimer.GetDelayLeft () + MicroSeconds (100),
-                           &RoutingProtocol::SendRequest, this, dst);
+                           &RoutingProtocol::DeferredSendRequest, this, dst);
       return;
     }
   else
@@ -1050,8 +1838,13 @@ RoutingProtocol::SendRequest (Ipv4Address dst)
   rreqHeader.SetOriginSeqno (m_seqNo);
   m_requestId++;
   rreqHeader.SetId (m_requestId);
+  if (m_locationService)
+    {
+      m_position = m_ipv4->GetObject<Node> ()->GetObject<MobilityModel> ()->GetPosition ();
+      rreqHeader.SetOriginPosition (m_position.x, m_position.y);
+    }
 
-  //std::cout << "Sending...\n";
+  bool clustered = false;
   // Send RREQ as subnet directed broadcast from each interface used by aodvKmeans
   for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
          m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
@@ -1061,9 +1854,9 @@ RoutingProtocol::SendRequest (Ipv4Address dst)
       Ptr<Socket> socket = j->first;
       Ipv4InterfaceAddress iface = j->second;
 
-      //std::cout << iface.GetLocal() << " --> " <<dst << "\n";
       rreqHeader.SetOrigin (iface.GetLocal ());
       m_rreqIdCache.IsDuplicate (iface.GetLocal (), m_requestId);
+      m_rreqOriginateTrace (rreqHeader);
 
       Ptr<Packet> packet = Create<Packet> ();
       SocketIpTtlTag tag;
@@ -1074,20 +1867,24 @@ RoutingProtocol::SendRequest (Ipv4Address dst)
       packet->AddHeader (tHeader);
       // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
       Ipv4Address destination;
+      Vector posDst;
       if (iface.GetMask () == Ipv4Mask::GetOnes ())
           {
-            std::cout << "Broadcast\n";
             destination = Ipv4Address ("255.255.255.255");
             NS_LOG_DEBUG ("Send RREQ with id " << rreqHeader.GetId () << " to socket");
             m_lastBcastTime = Simulator::Now ();
-          Simulator::Schedule (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), &RoutingProtocol::SendTo, this, socket, packet, destination);
+            m_floodedRreqs++;
+            m_rreqSendTrace (rreqHeader, 0);
+          ScheduleSendTo (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), socket, packet, destination, EventAccounting::EVENT_SEND_BROADCAST);
             
           }
-        else if(m_lastKnownPosition.find(dst) == m_lastKnownPosition.end())
+        else if(!GetDestinationPosition (dst, posDst))
           {
             destination = iface.GetBroadcast ();
             m_lastBcastTime = Simulator::Now ();
-            Simulator::Schedule (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), &RoutingProtocol::SendTo, this, socket, packet, destination);
+            m_floodedRreqs++;
+            m_rreqSendTrace (rreqHeader, 0);
+            ScheduleSendTo (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), socket, packet, destination, EventAccounting::EVENT_SEND_BROADCAST);
             
    
            
@@ -1096,19 +1893,7 @@ RoutingProtocol::SendRequest (Ipv4Address dst)
       
       else 
       {
-        std::vector<Ipv4Address>selectedCluster;
-        if(m_lastKnonwCluster.find(dst) != m_lastKnonwCluster.end())
-        {
-            //std::cout << rreqHeader.GetId() << " " << dst << " used from list\n";
-            selectedCluster = m_lastKnonwCluster[dst];
-        }
-        else
-        {
-            std::pair<uint32_t, uint32_t> posDst = m_lastKnownPosition.find(dst)->second;
-          
-            selectedCluster = m_routingTable.Kmeans(dst, posDst.first, posDst.second);
-        
-        }
+        std::vector<Ipv4Address> selectedCluster = SelectForwarders (dst, posDst);
          
         int interval = m_uniformRandomVariable->GetInteger (0, 10);
         int neighbours = selectedCluster.size();
@@ -1116,7 +1901,9 @@ RoutingProtocol::SendRequest (Ipv4Address dst)
         {
             destination = iface.GetBroadcast ();
             m_lastBcastTime = Simulator::Now ();
-            Simulator::Schedule (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), &RoutingProtocol::SendTo, this, socket, packet, destination);
+            m_floodedRreqs++;
+            m_rreqSendTrace (rreqHeader, 0);
+            ScheduleSendTo (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), socket, packet, destination, EventAccounting::EVENT_SEND_BROADCAST);
             continue;
    
         }
@@ -1124,15 +1911,31 @@ RoutingProtocol::SendRequest (Ipv4Address dst)
         {
           destination = selectedCluster[i];
           NS_LOG_DEBUG ("Send RREQ with id " << rreqHeader.GetId () << " to socket");
-          Simulator::Schedule (Time (MilliSeconds ((i+1) * interval)), &RoutingProtocol::SendTo, this, socket, packet, destination);
+          ScheduleSendTo (Time (MilliSeconds ((i+1) * interval)), socket, packet, destination, EventAccounting::EVENT_SEND_MEMBER);
         }
         m_lastBcastTime = Simulator::Now () + Time(MilliSeconds(neighbours * interval));
-        m_lastKnonwCluster[dst] = selectedCluster;
+        m_lastKnonwCluster.Put (dst, selectedCluster);
+        m_clusteredRreqs++;
+        m_rreqSendTrace (rreqHeader, neighbours);
+        clustered = true;
         
-        Simulator::Schedule(Time(Seconds(1)), &RoutingProtocol::ClusterTimerExpire, this, dst);
+        m_events.Scheduled (EventAccounting::EVENT_CLUSTER_TIMER);
+        Simulator::Schedule (Time (Seconds (1)), &RoutingProtocol::ClusterTimerExpire, this, dst);
       }
       
     }
+  std::map<Ipv4Address, DiscoveryTiming>::iterator timing = m_discoveries.find (dst);
+  if (timing != m_discoveries.end ())
+    {
+      if (timing->second.m_rreqs == 0)
+        {
+          timing->second.m_requested = Simulator::Now ();
+          m_discoveryStartTrace (dst, clustered);
+        }
+      timing->second.m_rreqs++;
+      timing->second.m_clustered = clustered;
+    }
+  m_routingTableSize = m_routingTable.GetSize ();
   ScheduleRreqRetry (dst);
 }
 
@@ -1142,18 +1945,59 @@ RoutingProtocol::SendTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address des
   socket->SendTo (packet, 0, InetSocketAddress (destination, aodvKmeans_PORT));
 
 }
+
+void
+RoutingProtocol::ScheduleSendTo (Time delay, Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination,
+                                 EventAccounting::EventType type)
+{
+  m_events.Scheduled (type);
+  Simulator::Schedule (delay, &RoutingProtocol::ScheduledSendTo, this, socket, packet, destination, type);
+}
+
+void
+RoutingProtocol::ScheduledSendTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination,
+                                  EventAccounting::EventType type)
+{
+  m_events.Executed (type);
+  SendTo (socket, packet, destination);
+}
+
+void
+RoutingProtocol::DeferredSendRequest (Ipv4Address dst)
+{
+  m_events.Executed (EventAccounting::EVENT_DEFERRED_RREQ);
+  SendRequest (dst);
+}
+
+void
+RoutingProtocol::ScheduleTimer (Timer & timer, Time delay, EventAccounting::EventType type)
+{
+  timer.Schedule (delay);
+  m_events.Scheduled (type);
+}
+
+void
+RoutingProtocol::CancelTimer (Timer & timer, EventAccounting::EventType type)
+{
+  if (timer.IsRunning ())
+    {
+      timer.Cancel ();
+      m_events.Cancelled (type);
+    }
+}
 void
 RoutingProtocol::ScheduleRreqRetry (Ipv4Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
-  if (m_addressReqTimer.find (dst) == m_addressReqTimer.end ())
+  Timer * timer = m_addressReqTimer.Find (dst);
+  if (timer == 0)
     {
-      Timer timer (Timer::CANCEL_ON_DESTROY);
-      m_addressReqTimer[dst] = timer;
+      timer = &m_addressReqTimer.Get (dst);
+      *timer = Timer (Timer::CANCEL_ON_DESTROY);
     }
-  m_addressReqTimer[dst].SetFunction (&RoutingProtocol::RouteRequestTimerExpire, this);
-  m_addressReqTimer[dst].Cancel ();
-  m_addressReqTimer[dst].SetArguments (dst);
+  timer->SetFunction (&RoutingProtocol::RouteRequestTimerExpire, this);
+  CancelTimer (*timer, EventAccounting::EVENT_ROUTE_REQUEST_TIMER);
+  timer->SetArguments (dst);
   RoutingTableEntry rt;
   m_routingTable.LookupRoute (dst, rt);
   Time retry;
@@ -1168,7 +2012,7 @@ RoutingProtocol::ScheduleRreqRetry (Ipv4Address dst)
       NS_LOG_LOGIC ("Applying binary exponential backoff factor " << backoffFactor);
       retry = m_netTraversalTime * (1 << backoffFactor);
     }
-  m_addressReqTimer[dst].Schedule (retry);
+  ScheduleTimer (*timer, retry, EventAccounting::EVENT_ROUTE_REQUEST_TIMER);
   NS_LOG_LOGIC ("Scheduled RREQ retry in " << retry.As (Time::S));
 }
 
@@ -1227,6 +2071,7 @@ RoutingProtocol::RecvaodvKmeans (Ptr<Socket> socket)
         break;
       }
     }
+  m_routingTableSize = m_routingTable.GetSize ();
 }
 
 bool
@@ -1275,6 +2120,7 @@ RoutingProtocol::UpdateRouteToNeighbor (Ipv4Address sender, Ipv4Address receiver
                                                   /*iface=*/ m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0),
                                                   /*hops=*/ 1, /*next hop=*/ sender, /*lifetime=*/ std::max (m_activeRouteTimeout, toNeighbor.GetLifeTime ())
                                                   );
+          newEntry.KeepMeasurements (toNeighbor, false, false);
           m_routingTable.Update (newEntry);
 
         }
@@ -1286,6 +2132,7 @@ void
 RoutingProtocol::RecvRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
 {
   NS_LOG_FUNCTION (this);
+  AODVKMEANS_PROFILE (PROBE_RECV_REQUEST);
   RreqHeader rreqHeader;
   p->RemoveHeader (rreqHeader);
 
@@ -1296,6 +2143,7 @@ RoutingProtocol::RecvRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address s
       if (toPrev.IsUnidirectional ())
         {
           NS_LOG_DEBUG ("Ignoring RREQ from node in blacklist");
+          m_rreqDropTrace (rreqHeader, RREQ_DROP_BLACKLISTED);
           return;
         }
     }
@@ -1312,9 +2160,16 @@ RoutingProtocol::RecvRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address s
   if (m_rreqIdCache.IsDuplicate (origin, id))
     {
       NS_LOG_DEBUG ("Ignoring RREQ due to duplicate");
+      m_rreqDropTrace (rreqHeader, RREQ_DROP_DUPLICATE);
       return;
     }
 
+  if (rreqHeader.HasOriginPosition ())
+    {
+      LearnPosition (origin, rreqHeader.GetOriginPosition ().first, rreqHeader.GetOriginPosition ().second,
+                     Simulator::Now ());
+    }
+
   // Increment RREQ hop count
   uint8_t hop = rreqHeader.GetHopCount () + 1;
   rreqHeader.SetHopCount (hop);
@@ -1416,6 +2271,7 @@ RoutingProtocol::RecvRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address s
       if (toDst.GetNextHop () == src)
         {
           NS_LOG_DEBUG ("Drop RREQ from " << src << ", dest next hop " << toDst.GetNextHop ());
+          m_rreqDropTrace (rreqHeader, RREQ_DROP_LOOP);
           return;
         }
       /*
@@ -1443,8 +2299,10 @@ RoutingProtocol::RecvRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address s
   if (tag.GetTtl () < 2)
     {
       NS_LOG_DEBUG ("TTL exceeded. Drop RREQ origin " << src << " destination " << dst );
+      m_rreqDropTrace (rreqHeader, RREQ_DROP_TTL);
       return;
     }
+  m_rreqForwardTrace (rreqHeader);
 
   for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
          m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
@@ -1460,48 +2318,43 @@ RoutingProtocol::RecvRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address s
       packet->AddHeader (tHeader);
       // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
       Ipv4Address destination;
+      Vector posDst;
       
       
         if (iface.GetMask () == Ipv4Mask::GetOnes ())
         {
           destination = Ipv4Address ("255.255.255.255");
            m_lastBcastTime = Simulator::Now ();
-          Simulator::Schedule (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), &RoutingProtocol::SendTo, this, socket, packet, destination);
+           m_floodedRreqs++;
+           m_rreqSendTrace (rreqHeader, 0);
+          ScheduleSendTo (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), socket, packet, destination, EventAccounting::EVENT_SEND_BROADCAST);
 
           
         }
-        else if(m_lastKnownPosition.find(dst) == m_lastKnownPosition.end() || m_routingTable.isEmpty()) 
+        else if(!GetDestinationPosition (dst, posDst) || m_routingTable.isEmpty()) 
         { 
           
             destination = iface.GetBroadcast ();
             m_lastBcastTime = Simulator::Now ();
-           Simulator::Schedule (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), &RoutingProtocol::SendTo, this, socket, packet, destination);
+            m_floodedRreqs++;
+            m_rreqSendTrace (rreqHeader, 0);
+           ScheduleSendTo (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), socket, packet, destination, EventAccounting::EVENT_SEND_BROADCAST);
 
         }
          
        
       else 
       {
-        std::vector<Ipv4Address>selectedCluster;
-        if(m_lastKnonwCluster.find(dst) != m_lastKnonwCluster.end())
-        {
-            //std::cout << rreqHeader.GetId() << " " << dst << " used from list\n";
-            selectedCluster = m_lastKnonwCluster[dst];
-        }
-        else
-        {
-            std::pair<uint32_t, uint32_t> posDst = m_lastKnownPosition.find(dst)->second;
-          
-            selectedCluster = m_routingTable.Kmeans(dst, posDst.first, posDst.second);
-        
-        }
+        std::vector<Ipv4Address> selectedCluster = SelectForwarders (dst, posDst);
         int interval = m_uniformRandomVariable->GetInteger (0, 10);
         int neighbours = selectedCluster.size();
         if(neighbours == 0)
         {
             destination = iface.GetBroadcast ();
             m_lastBcastTime = Simulator::Now ();
-            Simulator::Schedule (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), &RoutingProtocol::SendTo, this, socket, packet, destination);
+            m_floodedRreqs++;
+            m_rreqSendTrace (rreqHeader, 0);
+            ScheduleSendTo (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), socket, packet, destination, EventAccounting::EVENT_SEND_BROADCAST);
             continue;
    
         }
@@ -1509,13 +2362,16 @@ RoutingProtocol::RecvRequest (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address s
         {
           destination = selectedCluster[i];
           NS_LOG_DEBUG ("Send RREQ with id " << rreqHeader.GetId () << " to socket");
-          Simulator::Schedule (Time (MilliSeconds ((i+1) * interval)), &RoutingProtocol::SendTo, this, socket, packet, destination);
+          ScheduleSendTo (Time (MilliSeconds ((i+1) * interval)), socket, packet, destination, EventAccounting::EVENT_SEND_MEMBER);
         }
         m_lastBcastTime = Simulator::Now () + Time(MilliSeconds(neighbours * interval));
-        m_lastKnonwCluster[dst] = selectedCluster;
+        m_lastKnonwCluster.Put (dst, selectedCluster);
+        m_clusteredRreqs++;
+        m_rreqSendTrace (rreqHeader, neighbours);
         
 
-        Simulator::Schedule(Time(Seconds(1)), &RoutingProtocol::ClusterTimerExpire, this, dst);    
+        m_events.Scheduled (EventAccounting::EVENT_CLUSTER_TIMER);
+        Simulator::Schedule (Time (Seconds (1)), &RoutingProtocol::ClusterTimerExpire, this, dst);    
       }
       
     }
@@ -1542,8 +2398,11 @@ RoutingProtocol::SendReply (RreqHeader const & rreqHeader, RoutingTableEntry con
   
   RrepHeader rrepHeader ( /*prefixSize=*/ 0, /*hops=*/ 0, /*dst=*/ rreqHeader.GetDst (),
                                           /*dstSeqNo=*/ m_seqNo, /*origin=*/ toOrigin.GetDestination (), /*lifeTime=*/ m_myRouteTimeout,
-                                          /*txerrors=*/m_txerrorCount, /*freeSpace=*/ m_queue.GetFreeQueueLen(),
-                                          /*positionX=*/(uint32_t) m_position.x, /*positionY=*/(uint32_t) m_position.y);
+                                          /*txerrors=*/ GetAdvertisedTxError (), /*freeSpace=*/ m_queue.GetFreeQueueLen(),
+                                          /*positionX=*/ m_position.x, /*positionY=*/ m_position.y);
+  rrepHeader.SetKmeansExtension (m_kmeansExtension);
+  AddVelocity (rrepHeader);
+  AddChannelLoad (rrepHeader);
   Ptr<Packet> packet = Create<Packet> ();
   SocketIpTtlTag tag;
   tag.SetTtl (toOrigin.GetHop ());
@@ -1554,6 +2413,7 @@ RoutingProtocol::SendReply (RreqHeader const & rreqHeader, RoutingTableEntry con
   Ptr<Socket> socket = FindSocketWithInterfaceAddress (toOrigin.GetInterface ());
   NS_ASSERT (socket);
   socket->SendTo (packet, 0, InetSocketAddress (toOrigin.GetNextHop (), aodvKmeans_PORT));
+  m_rrepSendTrace (rrepHeader, toOrigin.GetNextHop ());
 }
 
 void
@@ -1568,6 +2428,15 @@ RoutingProtocol::SendReplyByIntermediateNode (RoutingTableEntry & toDst, Routing
                                           /*origin=*/ toOrigin.GetDestination (), /*lifetime=*/ toDst.GetLifeTime (),
                                           /*txerrors=*/ toDst.GetTxErrorCount(), /*freeSpace=*/toDst.GetFreeSpace(),
                                           /*positionX=*/toDst.GetPositionX(), /*positionY*/toDst.GetPositionY());
+  rrepHeader.SetKmeansExtension (m_kmeansExtension);
+  if (m_enableVelocity)
+    {
+      rrepHeader.SetVelocity (toDst.GetVelocity (), toDst.GetPositionTime ());
+    }
+  if (m_advertiseChannelLoad && toDst.HasChannelLoad ())
+    {
+      rrepHeader.SetChannelLoad (toDst.GetMacQueueOccupancy (), toDst.GetChannelBusy ());
+    }
   /* If the node we received a RREQ for is a neighbor we are
    * probably facing a unidirectional link... Better request a RREP-ack
    */
@@ -1595,6 +2464,7 @@ RoutingProtocol::SendReplyByIntermediateNode (RoutingTableEntry & toDst, Routing
   Ptr<Socket> socket = FindSocketWithInterfaceAddress (toOrigin.GetInterface ());
   NS_ASSERT (socket);
   socket->SendTo (packet, 0, InetSocketAddress (toOrigin.GetNextHop (), aodvKmeans_PORT));
+  m_rrepSendTrace (rrepHeader, toOrigin.GetNextHop ());
 
   // Generating gratuitous RREPs
   if (gratRep)
@@ -1606,6 +2476,15 @@ RoutingProtocol::SendReplyByIntermediateNode (RoutingTableEntry & toDst, Routing
                                                  /*lifetime=*/ toOrigin.GetLifeTime (), 
                                                  /*txerrors=*/toOrigin.GetTxErrorCount(), /*freeSpace=*/toOrigin.GetFreeSpace(),
                                                  /*positionX*/ toOrigin.GetPositionX(), /*positiony=*/toOrigin.GetPositionY());
+      gratRepHeader.SetKmeansExtension (m_kmeansExtension);
+      if (m_enableVelocity)
+        {
+          gratRepHeader.SetVelocity (toOrigin.GetVelocity (), toOrigin.GetPositionTime ());
+        }
+      if (m_advertiseChannelLoad && toOrigin.HasChannelLoad ())
+        {
+          gratRepHeader.SetChannelLoad (toOrigin.GetMacQueueOccupancy (), toOrigin.GetChannelBusy ());
+        }
       Ptr<Packet> packetToDst = Create<Packet> ();
       SocketIpTtlTag gratTag;
       gratTag.SetTtl (toDst.GetHop ());
@@ -1617,6 +2496,7 @@ RoutingProtocol::SendReplyByIntermediateNode (RoutingTableEntry & toDst, Routing
       NS_ASSERT (socket);
       NS_LOG_LOGIC ("Send gratuitous RREP " << packet->GetUid ());
       socket->SendTo (packetToDst, 0, InetSocketAddress (toDst.GetNextHop (), aodvKmeans_PORT));
+      m_rrepSendTrace (gratRepHeader, toDst.GetNextHop ());
     }
 }
 
@@ -1643,6 +2523,7 @@ void
 RoutingProtocol::RecvReply (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address sender)
 {
   NS_LOG_FUNCTION (this << " src " << sender);
+  AODVKMEANS_PROFILE (PROBE_RECV_REPLY);
   RrepHeader rrepHeader;
   p->RemoveHeader (rrepHeader);
   Ipv4Address dst = rrepHeader.GetDst ();
@@ -1651,14 +2532,18 @@ RoutingProtocol::RecvReply (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address sen
   uint8_t hop = rrepHeader.GetHopCount () + 1;
   rrepHeader.SetHopCount (hop);
 
-  if(m_lastKnownPosition.find(rrepHeader.GetDst()) != m_lastKnownPosition.end())
-  {
-    m_lastKnownPosition[rrepHeader.GetDst()] = rrepHeader.GetPosition();
-  }
-  else 
-  {
-    m_lastKnownPosition[rrepHeader.GetDst()] = rrepHeader.GetPosition();
-  }
+  bool located;
+  if (ResolvePosition (rrepHeader, located))
+    {
+      LocationCache::Location last;
+      if (dst == rrepHeader.GetOrigin () && m_locationCache.Lookup (dst, last))
+        {
+          // Movement of a neighbor since its previous hello
+          m_helloMovement = std::max (m_helloMovement, CalculateDistance (last.m_position,
+                                                                          Vector (rrepHeader.GetPosition ().first, rrepHeader.GetPosition ().second, 0)));
+        }
+      UpdateLastKnownPosition (rrepHeader);
+    }
 
 
   
@@ -1668,9 +2553,10 @@ RoutingProtocol::RecvReply (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address sen
   // If RREP is Hello message
   if (dst == rrepHeader.GetOrigin ())
     {
-      ProcessHello (rrepHeader, receiver);
+      ProcessHello (rrepHeader, receiver, located);
       return;
     }
+  m_rrepReceiveTrace (rrepHeader, sender);
 
   /*
    * If the route table entry to the destination is created or updated, then the following actions occur:
@@ -1686,10 +2572,24 @@ RoutingProtocol::RecvReply (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address sen
   RoutingTableEntry newEntry (/*device=*/ dev, /*dst=*/ dst, /*validSeqNo=*/ true, /*seqno=*/ rrepHeader.GetDstSeqno (),
                                           /*iface=*/ m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0),/*hop=*/ hop,
                                           /*nextHop=*/ sender, /*lifeTime=*/ rrepHeader.GetLifeTime (), 
-                                          /*txError=*/rrepHeader.GetTxErrorCount(), /*positionX=*/rrepHeader.GetPosition().first, /*positionY=*/rrepHeader.GetPosition().second);
+                                          /*txError=*/rrepHeader.GetTxErrorCount(), /*positionX=*/rrepHeader.GetPosition().first, /*positionY=*/rrepHeader.GetPosition().second,
+                                          /*freeSpace=*/rrepHeader.GetFreeSpace());
+  if (rrepHeader.HasVelocity ())
+    {
+      newEntry.SetVelocity (rrepHeader.GetVelocity (), rrepHeader.GetPositionTime ());
+    }
+  if (rrepHeader.HasChannelLoad ())
+    {
+      newEntry.SetChannelLoad (rrepHeader.GetMacQueueOccupancy (), rrepHeader.GetChannelBusy ());
+    }
+  if (!located)
+    {
+      newEntry.SetPositionUnknown ();
+    }
   RoutingTableEntry toDst;
   if (m_routingTable.LookupRoute (dst, toDst))
     {
+      newEntry.KeepMeasurements (toDst, located, rrepHeader.HasChannelLoad ());
       /*
        * The existing entry is updated only in the following circumstances:
        * (i) the sequence number in the routing table is marked as invalid in route table entry.
@@ -1735,14 +2635,24 @@ RoutingProtocol::RecvReply (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address sen
   NS_LOG_LOGIC ("receiver " << receiver << " origin " << rrepHeader.GetOrigin ());
   if (IsMyOwnAddress (rrepHeader.GetOrigin ()))
     {
+      std::map<Ipv4Address, DiscoveryTiming>::iterator timing = m_discoveries.find (dst);
+      if (timing != m_discoveries.end () && !timing->second.m_replied && timing->second.m_rreqs > 0)
+        {
+          timing->second.m_replied = true;
+          m_replyLatencyTrace (dst, Simulator::Now () - timing->second.m_requested,
+                               timing->second.m_clustered, timing->second.m_rreqs - 1);
+        }
       if (toDst.GetFlag () == IN_SEARCH)
         {
           m_routingTable.Update (newEntry);
-          m_addressReqTimer[dst].Cancel ();
-          m_addressReqTimer.erase (dst);
+          Timer * timer = m_addressReqTimer.Find (dst);
+          if (timer != 0)
+            {
+              CancelTimer (*timer, EventAccounting::EVENT_ROUTE_REQUEST_TIMER);
+              m_addressReqTimer.Erase (dst);
+            }
         }
       m_routingTable.LookupRoute (dst, toDst);
-      //std::cout << "SendPacketFromQueue: " << sender << "\n";
       SendPacketFromQueue (dst, toDst.GetRoute ());
       return;
     }
@@ -1793,6 +2703,7 @@ RoutingProtocol::RecvReply (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address sen
   Ptr<Socket> socket = FindSocketWithInterfaceAddress (toOrigin.GetInterface ());
   NS_ASSERT (socket);
   socket->SendTo (packet, 0, InetSocketAddress (toOrigin.GetNextHop (), aodvKmeans_PORT));
+  m_rrepSendTrace (rrepHeader, toOrigin.GetNextHop ());
 }
 
 void
@@ -1802,18 +2713,25 @@ RoutingProtocol::RecvReplyAck (Ipv4Address neighbor)
   RoutingTableEntry rt;
   if (m_routingTable.LookupRoute (neighbor, rt))
     {
-      rt.m_ackTimer.Cancel ();
+      CancelTimer (rt.m_ackTimer, EventAccounting::EVENT_ACK_TIMER);
       rt.SetFlag (VALID);
       m_routingTable.Update (rt);
     }
 }
 
 void
-RoutingProtocol::ProcessHello (RrepHeader const & rrepHeader, Ipv4Address receiver )
+RoutingProtocol::ProcessHello (RrepHeader const & rrepHeader, Ipv4Address receiver, bool located)
 {
   NS_LOG_FUNCTION (this << "from " << rrepHeader.GetDst ());
   
-  
+  std::vector<LocationGossip> const & gossip = rrepHeader.GetLocationGossip ();
+  for (std::vector<LocationGossip>::const_iterator g = gossip.begin (); g != gossip.end (); ++g)
+    {
+      if (m_ipv4->GetInterfaceForAddress (g->m_node) < 0)
+        {
+          LearnPosition (g->m_node, g->m_positionX, g->m_positionY, Simulator::Now () - g->m_age);
+        }
+    }
   
   /*
    *  Whenever a node receives a Hello message from a neighbor, the node
@@ -1831,11 +2749,24 @@ RoutingProtocol::ProcessHello (RrepHeader const & rrepHeader, Ipv4Address receiv
                                               /*hop=*/ 1, /*nextHop=*/ rrepHeader.GetDst (), /*lifeTime=*/ rrepHeader.GetLifeTime (), 
                                               /*txError=*/rrepHeader.GetTxErrorCount(), /*positionX=*/rrepHeader.GetPosition().first, 
                                               /*positiony=*/rrepHeader.GetPosition().second, /*freespace*/rrepHeader.GetFreeSpace());
+      if (rrepHeader.HasVelocity ())
+        {
+          newEntry.SetVelocity (rrepHeader.GetVelocity (), rrepHeader.GetPositionTime ());
+        }
+      if (rrepHeader.HasChannelLoad ())
+        {
+          newEntry.SetChannelLoad (rrepHeader.GetMacQueueOccupancy (), rrepHeader.GetChannelBusy ());
+        }
+      if (!located)
+        {
+          newEntry.SetPositionUnknown ();
+        }
+      UpdateLinkSnr (newEntry);
       m_routingTable.AddRoute (newEntry);
     }
   else
     {
-      toNeighbor.SetLifeTime (std::max (Time (m_allowedHelloLoss * m_helloInterval), toNeighbor.GetLifeTime ()));
+      toNeighbor.SetLifeTime (std::max (rrepHeader.GetLifeTime (), toNeighbor.GetLifeTime ()));
       toNeighbor.SetSeqNo (rrepHeader.GetDstSeqno ());
       toNeighbor.SetValidSeqNo (true);
       toNeighbor.SetFlag (VALID);
@@ -1845,13 +2776,28 @@ RoutingProtocol::ProcessHello (RrepHeader const & rrepHeader, Ipv4Address receiv
       toNeighbor.SetNextHop (rrepHeader.GetDst ());
       toNeighbor.SetTxErrorCount(rrepHeader.GetTxErrorCount());
       toNeighbor.SetFreeSpace(rrepHeader.GetFreeSpace());
-      toNeighbor.SetPositionX(rrepHeader.GetPosition().first);
-      toNeighbor.SetPositionY(rrepHeader.GetPosition().second);
+      if (located)
+        {
+          toNeighbor.SetPositionX(rrepHeader.GetPosition().first);
+          toNeighbor.SetPositionY(rrepHeader.GetPosition().second);
+          toNeighbor.SetVelocity (rrepHeader.GetVelocity (),
+                                  rrepHeader.HasVelocity () ? rrepHeader.GetPositionTime () : Simulator::Now ());
+        }
+      if (rrepHeader.HasChannelLoad ())
+        {
+          toNeighbor.SetChannelLoad (rrepHeader.GetMacQueueOccupancy (), rrepHeader.GetChannelBusy ());
+        }
+      UpdateLinkSnr (toNeighbor);
       m_routingTable.Update (toNeighbor);
     }
   if (m_enableHello)
     {
-      m_nb.Update (rrepHeader.GetDst (), Time (m_allowedHelloLoss * m_helloInterval));
+      if (!m_nb.IsNeighbor (rrepHeader.GetDst ()))
+        {
+          m_helloChurn++;
+        }
+      // The hello lifetime is AllowedHelloLoss times the hello interval of its sender
+      m_nb.Update (rrepHeader.GetDst (), rrepHeader.GetLifeTime ());
     }
 }
 
@@ -1917,19 +2863,18 @@ RoutingProtocol::RecvError (Ptr<Packet> p, Ipv4Address src )
 void
 RoutingProtocol::ClusterTimerExpire(Ipv4Address dst)
 {
-  //std::cout << "dst cleaned\n";
-  if(m_lastKnonwCluster.find(dst) != m_lastKnonwCluster.end())
-  {
-    m_lastKnonwCluster.erase(dst);
-  }
+  m_events.Executed (EventAccounting::EVENT_CLUSTER_TIMER);
+  m_lastKnonwCluster.Erase (dst);
 }
 void
 RoutingProtocol::RouteRequestTimerExpire (Ipv4Address dst)
 {
   NS_LOG_LOGIC (this);
+  m_events.Executed (EventAccounting::EVENT_ROUTE_REQUEST_TIMER);
   RoutingTableEntry toDst;
   if (m_routingTable.LookupValidRoute (dst, toDst))
     {
+      m_addressReqTimer.Erase (dst);
       SendPacketFromQueue (dst, toDst.GetRoute ());
       NS_LOG_LOGIC ("route to " << dst << " found");
       return;
@@ -1942,10 +2887,11 @@ RoutingProtocol::RouteRequestTimerExpire (Ipv4Address dst)
   if (toDst.GetRreqCnt () == m_rreqRetries)
     {
       NS_LOG_LOGIC ("route discovery to " << dst << " has been attempted RreqRetries (" << m_rreqRetries << ") times with ttl " << m_netDiameter);
-      m_addressReqTimer.erase (dst);
+      m_addressReqTimer.Erase (dst);
       m_routingTable.DeleteRoute (dst);
       NS_LOG_DEBUG ("Route not found. Drop all packets with dst " << dst);
       m_queue.DropPacketWithDst (dst);
+      m_discoveries.erase (dst);
       return;
     }
 
@@ -1957,9 +2903,10 @@ RoutingProtocol::RouteRequestTimerExpire (Ipv4Address dst)
   else
     {
       NS_LOG_DEBUG ("Route down. Stop search. Drop packet with destination " << dst);
-      m_addressReqTimer.erase (dst);
+      m_addressReqTimer.Erase (dst);
       m_routingTable.DeleteRoute (dst);
       m_queue.DropPacketWithDst (dst);
+      m_discoveries.erase (dst);
     }
 }
 
@@ -1967,42 +2914,105 @@ void
 RoutingProtocol::HelloTimerExpire ()
 {
   NS_LOG_FUNCTION (this);
+  m_events.Executed (EventAccounting::EVENT_HELLO_TIMER);
   Time offset = Time (Seconds (0));
-  if (m_lastBcastTime > Time (Seconds (0)))
+  // Neighbors expect an adaptive hello within the interval it advertised last,
+  // a broadcast in between does not tell them how long to wait
+  if (m_lastBcastTime > Time (Seconds (0)) && !m_adaptiveHello)
     {
       offset = Simulator::Now () - m_lastBcastTime;
       NS_LOG_DEBUG ("Hello deferred due to last bcast at:" << m_lastBcastTime);
     }
   else
     {
+      if (m_adaptiveHello)
+        {
+          UpdateHelloInterval ();
+        }
       SendHello ();
     }
-  m_htimer.Cancel ();
-  Time diff = m_helloInterval - offset;
-  m_htimer.Schedule (std::max (Time (Seconds (0)), diff));
+  CancelTimer (m_htimer, EventAccounting::EVENT_HELLO_TIMER);
+  Time diff = m_currentHelloInterval.Get () - offset;
+  ScheduleTimer (m_htimer, std::max (Time (Seconds (0)), diff), EventAccounting::EVENT_HELLO_TIMER);
   m_lastBcastTime = Time (Seconds (0));
 }
 
+void
+RoutingProtocol::UpdateHelloInterval ()
+{
+  NS_LOG_FUNCTION (this);
+  Vector position = m_ipv4->GetObject<Node> ()->GetObject<MobilityModel> ()->GetPosition ();
+  m_helloMovement = std::max (m_helloMovement, CalculateDistance (position, m_lastHelloPosition));
+  m_lastHelloPosition = position;
+  m_currentHelloInterval = AdaptHelloInterval (m_currentHelloInterval.Get (),
+                                               m_helloChurn > 0 || m_helloMovement > m_helloMovementThreshold,
+                                               m_minHelloInterval, m_maxHelloInterval);
+  NS_LOG_DEBUG ("Hello interval " << m_currentHelloInterval.Get ().As (Time::S) << " after " << m_helloChurn
+                                  << " neighbor changes and " << m_helloMovement << " m movement");
+  m_helloChurn = 0;
+  m_helloMovement = 0;
+}
+
+Time
+RoutingProtocol::AdaptHelloInterval (Time interval, bool changed, Time minInterval, Time maxInterval)
+{
+  if (changed)
+    {
+      interval = interval / 2;
+    }
+  else
+    {
+      interval = interval + interval / 4;
+    }
+  return std::min (std::max (interval, minInterval), maxInterval);
+}
+
+Time
+RoutingProtocol::GetHelloLifetime (Time interval, uint32_t allowedHelloLoss, Time maxInterval)
+{
+  // The hellos following this one may each come a quarter later than the
+  // previous one, the neighbors wait for the longest such sequence
+  Time lifetime = Seconds (0);
+  for (uint32_t i = 0; i < allowedHelloLoss; i++)
+    {
+      lifetime += interval;
+      interval = std::max (interval, std::min (interval + interval / 4, maxInterval));
+    }
+  return lifetime;
+}
+
 void
 RoutingProtocol::RreqRateLimitTimerExpire ()
 {
   NS_LOG_FUNCTION (this);
+  m_events.Executed (EventAccounting::EVENT_RATE_LIMIT_TIMER);
   m_rreqCount = 0;
-  m_rreqRateLimitTimer.Schedule (Seconds (1));
+  ScheduleTimer (m_rreqRateLimitTimer, Seconds (1), EventAccounting::EVENT_RATE_LIMIT_TIMER);
 }
 
 void
 RoutingProtocol::RerrRateLimitTimerExpire ()
 {
   NS_LOG_FUNCTION (this);
+  m_events.Executed (EventAccounting::EVENT_RATE_LIMIT_TIMER);
   m_rerrCount = 0;
-  m_rerrRateLimitTimer.Schedule (Seconds (1));
+  ScheduleTimer (m_rerrRateLimitTimer, Seconds (1), EventAccounting::EVENT_RATE_LIMIT_TIMER);
+}
+
+void
+RoutingProtocol::QueueSampleTimerExpire ()
+{
+  NS_LOG_FUNCTION (this);
+  m_events.Executed (EventAccounting::EVENT_QUEUE_SAMPLE_TIMER);
+  m_queueSampleTrace (m_queue.SampleOccupancy ());
+  ScheduleTimer (m_queueSampleTimer, m_queueSampleInterval, EventAccounting::EVENT_QUEUE_SAMPLE_TIMER);
 }
 
 void
 RoutingProtocol::AckTimerExpire (Ipv4Address neighbor, Time blacklistTimeout)
 {
   NS_LOG_FUNCTION (this);
+  m_events.Executed (EventAccounting::EVENT_ACK_TIMER);
   m_routingTable.MarkLinkAsUnidirectional (neighbor, blacklistTimeout);
 }
 
@@ -2014,10 +3024,14 @@ RoutingProtocol::SendHello ()
    *   Destination IP Address         The node's IP address.
    *   Destination Sequence Number    The node's latest sequence number.
    *   Hop Count                      0
-   *   Lifetime                       AllowedHelloLoss * HelloInterval
+   *   Lifetime                       AllowedHelloLoss * HelloInterval, or the time
+   *                                  AllowedHelloLoss adaptive intervals may grow to
    */
 
   m_position = m_ipv4->GetObject<Node>()->GetObject<MobilityModel> ()->GetPosition();
+  bool keyframe = NextHelloKeyframe ();
+  Time lifetime = GetHelloLifetime (m_currentHelloInterval.Get (), m_allowedHelloLoss,
+                                    m_adaptiveHello ? m_maxHelloInterval : Time (Seconds (0)));
     
   for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
     {
@@ -2025,8 +3039,23 @@ RoutingProtocol::SendHello ()
       Ipv4InterfaceAddress iface = j->second;
       
       RrepHeader helloHeader (/*prefix size=*/ 0, /*hops=*/ 0, /*dst=*/ iface.GetLocal (), /*dst seqno=*/ m_seqNo,
-                                               /*origin=*/ iface.GetLocal (),/*lifetime=*/ Time (m_allowedHelloLoss * m_helloInterval),
-                                               /*txError=*/ m_txerrorCount, /*freespace=*/ m_queue.GetFreeQueueLen(), /*positionx=*/ (uint32_t)m_position.x, /*positiony*/(uint32_t) m_position.y);
+                                               /*origin=*/ iface.GetLocal (),/*lifetime=*/ lifetime,
+                                               /*txError=*/ GetAdvertisedTxError (), /*freespace=*/ m_queue.GetFreeQueueLen(), /*positionx=*/ m_position.x, /*positiony*/ m_position.y);
+      helloHeader.SetKmeansExtension (m_kmeansExtension);
+      if (m_kmeansExtension == KMEANS_EXT_COMPACT)
+        {
+          if (keyframe)
+            {
+              helloHeader.SetPositionKeyframe (m_keyframe);
+            }
+          else
+            {
+              helloHeader.SetPositionDelta (m_keyframe, m_keyframePosition.x, m_keyframePosition.y);
+            }
+        }
+      AddVelocity (helloHeader);
+      AddChannelLoad (helloHeader);
+      AddLocationGossip (helloHeader);
       Ptr<Packet> packet = Create<Packet> ();
       SocketIpTtlTag tag;
       tag.SetTtl (1);
@@ -2045,7 +3074,7 @@ RoutingProtocol::SendHello ()
           destination = iface.GetBroadcast ();
         }
       Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
-      Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, destination);
+      ScheduleSendTo (jitter, socket, packet, destination, EventAccounting::EVENT_SEND_BROADCAST);
     }
 }
 
@@ -2056,14 +3085,11 @@ RoutingProtocol::SendPacketFromQueue (Ipv4Address dst, Ptr<Ipv4Route> route)
       // Ptr<Node> node = ;
       // Ptr<MobilityModel> mobility = ;
       // Vector position = mobility->GetPosition();
-      // std::cout << position.x << ' ' << position.y << "\n";
 
       //Vector position = m_ipv4->GetObject<Node>()->GetObject<MobilityModel> ()->GetPosition();
       
   // Ipv4Address bestForwarder = m_nb.Kmeans(dst);
   
-  // std::cout << "Best forwarder by aodvKmeans = " << bestForwarder << "\n";
-  // std::cout << "Selected next hop = " << route->GetGateway() << "\n";
 
   // RoutingTableEntry bestForwarderEntry;
   // m_routingTable.LookupRoute(bestForwarder, bestForwarderEntry);
@@ -2074,6 +3100,13 @@ RoutingProtocol::SendPacketFromQueue (Ipv4Address dst, Ptr<Ipv4Route> route)
 
 
   NS_LOG_FUNCTION (this);
+  std::map<Ipv4Address, DiscoveryTiming>::iterator timing = m_discoveries.find (dst);
+  if (timing != m_discoveries.end ())
+    {
+      m_discoveryLatencyTrace (dst, Simulator::Now () - timing->second.m_queued,
+                               timing->second.m_clustered, timing->second.m_rreqs > 0 ? timing->second.m_rreqs - 1 : 0);
+      m_discoveries.erase (timing);
+    }
   QueueEntry queueEntry;
   while (m_queue.Dequeue (dst, queueEntry))
     {
@@ -2100,6 +3133,9 @@ void
 RoutingProtocol::SendRerrWhenBreaksLinkToNextHop (Ipv4Address nextHop)
 {
   NS_LOG_FUNCTION (this << nextHop);
+  m_helloChurn++;
+  m_neighborKeyframes.erase (nextHop);
+  m_rxSnr.Erase (nextHop);
   RerrHeader rerrHeader;
   std::vector<Ipv4Address> precursors;
   std::map<Ipv4Address, uint32_t> unreachable;
@@ -2183,6 +3219,7 @@ RoutingProtocol::SendRerrWhenNoRouteToForward (Ipv4Address dst,
       NS_ASSERT (socket);
       NS_LOG_LOGIC ("Unicast RERR to the source of the data transmission");
       socket->SendTo (packet, 0, InetSocketAddress (toOrigin.GetNextHop (), aodvKmeans_PORT));
+      m_rerrSendTrace (rerrHeader, toOrigin.GetNextHop ());
     }
   else
     {
@@ -2204,6 +3241,7 @@ RoutingProtocol::SendRerrWhenNoRouteToForward (Ipv4Address dst,
               destination = iface.GetBroadcast ();
             }
           socket->SendTo (packet->Copy (), 0, InetSocketAddress (destination, aodvKmeans_PORT));
+          m_rerrSendTrace (rerrHeader, destination);
         }
     }
 }
@@ -2229,6 +3267,14 @@ RoutingProtocol::SendRerrMessage (Ptr<Packet> packet, std::vector<Ipv4Address> p
                                                 << "; suppressing RERR");
       return;
     }
+  RerrHeader rerrHeader;
+  if (!m_rerrSendTrace.IsEmpty ())
+    {
+      Ptr<Packet> copy = packet->Copy ();
+      TypeHeader typeHeader;
+      copy->RemoveHeader (typeHeader);
+      copy->RemoveHeader (rerrHeader);
+    }
   // If there is only one precursor, RERR SHOULD be unicast toward that precursor
   if (precursors.size () == 1)
     {
@@ -2238,8 +3284,9 @@ RoutingProtocol::SendRerrMessage (Ptr<Packet> packet, std::vector<Ipv4Address> p
           Ptr<Socket> socket = FindSocketWithInterfaceAddress (toPrecursor.GetInterface ());
           NS_ASSERT (socket);
           NS_LOG_LOGIC ("one precursor => unicast RERR to " << toPrecursor.GetDestination () << " from " << toPrecursor.GetInterface ().GetLocal ());
-          Simulator::Schedule (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), &RoutingProtocol::SendTo, this, socket, packet, precursors.front ());
+          ScheduleSendTo (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), socket, packet, precursors.front (), EventAccounting::EVENT_SEND_UNICAST);
           m_rerrCount++;
+          m_rerrSendTrace (rerrHeader, precursors.front ());
         }
       return;
     }
@@ -2261,7 +3308,6 @@ RoutingProtocol::SendRerrMessage (Ptr<Packet> packet, std::vector<Ipv4Address> p
       Ptr<Socket> socket = FindSocketWithInterfaceAddress (*i);
       NS_ASSERT (socket);
       NS_LOG_LOGIC ("Broadcast RERR message from interface " << i->GetLocal ());
-      // std::cout << "Broadcast RERR message from interface " << i->GetLocal () << std::endl;
       // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
       Ptr<Packet> p = packet->Copy ();
       Ipv4Address destination;
@@ -2273,7 +3319,8 @@ RoutingProtocol::SendRerrMessage (Ptr<Packet> packet, std::vector<Ipv4Address> p
         {
           destination = i->GetBroadcast ();
         }
-      Simulator::Schedule (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), &RoutingProtocol::SendTo, this, socket, p, destination);
+      ScheduleSendTo (Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10))), socket, p, destination, EventAccounting::EVENT_SEND_BROADCAST);
+      m_rerrSendTrace (rerrHeader, destination);
     }
 }
 
@@ -2317,13 +3364,21 @@ void
 RoutingProtocol::DoInitialize (void)
 {
   NS_LOG_FUNCTION (this);
+  // clustering draws from the stream assigned to the protocol
+  m_routingTable.SetRandomVariable (m_uniformRandomVariable);
   uint32_t startTime;
   if (m_enableHello)
     {
+      m_currentHelloInterval = m_helloInterval;
+      if (m_adaptiveHello)
+        {
+          m_currentHelloInterval = std::min (std::max (m_helloInterval, m_minHelloInterval), m_maxHelloInterval);
+          m_lastHelloPosition = m_ipv4->GetObject<Node> ()->GetObject<MobilityModel> ()->GetPosition ();
+        }
       m_htimer.SetFunction (&RoutingProtocol::HelloTimerExpire, this);
       startTime = m_uniformRandomVariable->GetInteger (0, 100);
       NS_LOG_DEBUG ("Starting at time " << startTime << "ms");
-      m_htimer.Schedule (MilliSeconds (startTime));
+      ScheduleTimer (m_htimer, MilliSeconds (startTime), EventAccounting::EVENT_HELLO_TIMER);
     }
   Ipv4RoutingProtocol::DoInitialize ();
 }
@@ -33,6 +33,12 @@
 #include "aodvKmeans-packet.h"
 #include "aodvKmeans-neighbor.h"
 #include "aodvKmeans-dpd.h"
+#include "aodvKmeans-link-quality.h"
+#include "aodvKmeans-channel-load.h"
+#include "aodvKmeans-event-accounting.h"
+#include "aodvKmeans-location-cache.h"
+#include "aodvKmeans-memory-usage.h"
+#include "aodvKmeans-lru-cache.h"
 #include "ns3/node.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/output-stream-wrapper.h"
@@ -40,14 +46,31 @@
 #include "ns3/ipv4-interface.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/mobility-module.h"
+#include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
 #include <map>
 
 namespace ns3 {
 
 class WifiMacQueueItem;
 enum WifiMacDropReason : uint8_t;  // opaque enum declaration
+class WifiTxVector;
+struct MpduInfo;
+struct SignalNoiseDbm;
 
 namespace aodvKmeans {
+/**
+ * \ingroup aodvKmeans
+ * \brief Reason a received RREQ is dropped
+ */
+enum RreqDropReason
+{
+  RREQ_DROP_BLACKLISTED = 0,  //!< received from a neighbor with a unidirectional link
+  RREQ_DROP_DUPLICATE = 1,    //!< same originator and RREQ ID already received
+  RREQ_DROP_LOOP = 2,         //!< the route to the destination goes through the sender
+  RREQ_DROP_TTL = 3,          //!< TTL exhausted
+};
+
 /**
  * \ingroup aodvKmeans
  *
@@ -63,6 +86,90 @@ public:
   static TypeId GetTypeId (void);
   static const uint32_t aodvKmeans_PORT;
 
+  /**
+   * TracedCallback signature for RREQ events.
+   *
+   * \param [in] header the RREQ
+   */
+  typedef void (* RreqTracedCallback)(const RreqHeader & header);
+  /**
+   * TracedCallback signature for dropped RREQs.
+   *
+   * \param [in] header the RREQ
+   * \param [in] reason the reason of the drop
+   */
+  typedef void (* RreqDropTracedCallback)(const RreqHeader & header, RreqDropReason reason);
+  /**
+   * TracedCallback signature for sent RREQs.
+   *
+   * \param [in] header the RREQ
+   * \param [in] forwarders the number of neighbors it is unicast to, 0 if broadcast
+   */
+  typedef void (* RreqSendTracedCallback)(const RreqHeader & header, uint32_t forwarders);
+  /**
+   * TracedCallback signature for forwarder selection by K-means.
+   *
+   * \param [in] dst the destination of the RREQ
+   * \param [in] candidates the number of forwarder candidates
+   * \param [in] selected the selected forwarders
+   */
+  typedef void (* KmeansTracedCallback)(Ipv4Address dst, uint32_t candidates,
+                                        const std::vector<Ipv4Address> & selected);
+  /**
+   * TracedCallback signature for the quality of forwarder selections by K-means.
+   *
+   * \param [in] dst the destination of the RREQ
+   * \param [in] quality the quality of the clusters
+   * \param [in] jaccard the Jaccard similarity of the selected forwarders to the
+   *        previous selection for the destination, -1 if none
+   */
+  typedef void (* ClusterQualityTracedCallback)(Ipv4Address dst, const KmeansQuality & quality, double jaccard);
+  /**
+   * TracedCallback signature for lookups in the cluster cache.
+   *
+   * \param [in] dst the destination of the RREQ
+   * \param [in] hit true if a cluster was cached for the destination
+   */
+  typedef void (* ClusterCacheTracedCallback)(Ipv4Address dst, bool hit);
+  /**
+   * TracedCallback signature for RREP events.
+   *
+   * \param [in] header the RREP
+   * \param [in] neighbor the next hop of a sent RREP, the sender of a received one
+   */
+  typedef void (* RrepTracedCallback)(const RrepHeader & header, Ipv4Address neighbor);
+  /**
+   * TracedCallback signature for sent RERRs.
+   *
+   * \param [in] header the RERR
+   * \param [in] destination the neighbor or broadcast address it is sent to
+   */
+  typedef void (* RerrTracedCallback)(const RerrHeader & header, Ipv4Address destination);
+  /**
+   * TracedCallback signature for started route discoveries.
+   *
+   * \param [in] dst the destination of the route discovery
+   * \param [in] clustered true if its first RREQ was sent to a cluster of neighbors
+   */
+  typedef void (* DiscoveryTracedCallback)(Ipv4Address dst, bool clustered);
+  /**
+   * TracedCallback signature for route discovery latencies.
+   *
+   * \param [in] dst the destination of the route discovery
+   * \param [in] latency the latency
+   * \param [in] clustered true if the last RREQ was sent to a cluster of neighbors
+   * \param [in] retries the number of RREQs sent before the last one
+   */
+  typedef void (* DiscoveryLatencyTracedCallback)(Ipv4Address dst, Time latency, bool clustered, uint32_t retries);
+  /**
+   * TracedCallback signature for route changes.
+   *
+   * \param [in] route the routing table entry after the change
+   * \param [in] valid true if the route became valid or changed its next hop,
+   * false if it was invalidated or deleted
+   */
+  typedef void (* RouteChangeTracedCallback)(const RoutingTableEntry & route, bool valid);
+
   /// constructor
   RoutingProtocol ();
   virtual ~RoutingProtocol ();
@@ -107,6 +214,411 @@ public:
    * \param len the maximum queue length
    */
   void SetMaxQueueLen (uint32_t len);
+  /**
+   * Get the request queue scheduling discipline
+   * \returns the scheduling discipline
+   */
+  QueueScheduling GetQueueScheduling () const
+  {
+    return m_queue.GetScheduling ();
+  }
+  /**
+   * Set the request queue scheduling discipline
+   * \param s the scheduling discipline
+   */
+  void SetQueueScheduling (QueueScheduling s)
+  {
+    m_queue.SetScheduling (s);
+  }
+  /**
+   * Get the request queue flow classification
+   * \returns the flow key
+   */
+  QueueFlowKey GetQueueFlowKey () const
+  {
+    return m_queue.GetFlowKey ();
+  }
+  /**
+   * Set the request queue flow classification
+   * \param k the flow key
+   */
+  void SetQueueFlowKey (QueueFlowKey k)
+  {
+    m_queue.SetFlowKey (k);
+  }
+  /**
+   * Get the request queue per-flow quota
+   * \returns the per-flow quota
+   */
+  uint32_t GetQueueFlowQuota () const
+  {
+    return m_queue.GetFlowQuota ();
+  }
+  /**
+   * Set the request queue per-flow quota
+   * \param quota the per-flow quota
+   */
+  void SetQueueFlowQuota (uint32_t quota)
+  {
+    m_queue.SetFlowQuota (quota);
+  }
+  /**
+   * Get the request queue deficit round robin quantum
+   * \returns the quantum in bytes
+   */
+  uint32_t GetQueueQuantum () const
+  {
+    return m_queue.GetQuantum ();
+  }
+  /**
+   * Set the request queue deficit round robin quantum
+   * \param quantum the quantum in bytes
+   */
+  void SetQueueQuantum (uint32_t quantum)
+  {
+    m_queue.SetQuantum (quantum);
+  }
+  /**
+   * Get the number of request queue occupancy samples kept
+   * \returns the number of samples
+   */
+  uint32_t GetQueueSampleCapacity () const
+  {
+    return m_queue.GetSamples ().GetCapacity ();
+  }
+  /**
+   * Set the number of request queue occupancy samples kept
+   * \param capacity the number of samples
+   */
+  void SetQueueSampleCapacity (uint32_t capacity)
+  {
+    m_queue.SetSampleCapacity (capacity);
+  }
+  /**
+   * \returns the route discovery buffer, with its occupancy samples
+   */
+  RequestQueue const & GetRequestQueue () const
+  {
+    return m_queue;
+  }
+  /**
+   * Get the duplicate packet detection mode
+   * \returns the detection mode
+   */
+  DpdMode GetDpdMode () const
+  {
+    return m_dpd.GetMode ();
+  }
+  /**
+   * Set the duplicate packet detection mode
+   * \param mode the detection mode
+   */
+  void SetDpdMode (DpdMode mode)
+  {
+    m_dpd.SetMode (mode);
+  }
+  /**
+   * Get the number of packets remembered per lifetime in Bloom duplicate detection
+   * \returns the Bloom filter capacity
+   */
+  uint32_t GetDpdBloomCapacity () const
+  {
+    return m_dpd.GetBloomCapacity ();
+  }
+  /**
+   * Set the number of packets remembered per lifetime in Bloom duplicate detection
+   * \param capacity the Bloom filter capacity
+   */
+  void SetDpdBloomCapacity (uint32_t capacity)
+  {
+    m_dpd.SetBloomParameters (capacity, m_dpd.GetBloomFpRate ());
+  }
+  /**
+   * Get the target false positive rate of Bloom duplicate detection
+   * \returns the false positive rate
+   */
+  double GetDpdBloomFpRate () const
+  {
+    return m_dpd.GetBloomFpRate ();
+  }
+  /**
+   * Set the target false positive rate of Bloom duplicate detection
+   * \param fpRate the false positive rate
+   */
+  void SetDpdBloomFpRate (double fpRate)
+  {
+    m_dpd.SetBloomParameters (m_dpd.GetBloomCapacity (), fpRate);
+  }
+  /**
+   * Get the half-life of the transmission error statistics
+   * \returns the half-life
+   */
+  Time GetTxErrorHalfLife () const
+  {
+    return m_linkQuality.GetHalfLife ();
+  }
+  /**
+   * Set the half-life of the transmission error statistics
+   * \param halfLife the half-life
+   */
+  void SetTxErrorHalfLife (Time halfLife)
+  {
+    m_linkQuality.SetHalfLife (halfLife);
+  }
+  /**
+   * Get the longest extrapolation of the positions used for clustering
+   * \returns the longest extrapolation
+   */
+  Time GetMaxPositionExtrapolation () const
+  {
+    return m_routingTable.GetMaxPositionExtrapolation ();
+  }
+  /**
+   * Set the longest extrapolation of the positions used for clustering
+   * \param t the longest extrapolation, 0 disables it
+   */
+  void SetMaxPositionExtrapolation (Time t)
+  {
+    m_routingTable.SetMaxPositionExtrapolation (t);
+    m_locationCache.SetMaxExtrapolation (t);
+  }
+  /**
+   * Get the maximum number of remembered positions of other nodes
+   * \returns the capacity of the location cache
+   */
+  uint32_t GetLocationCacheSize () const
+  {
+    return m_locationCache.GetCapacity ();
+  }
+  /**
+   * Set the maximum number of remembered positions of other nodes
+   * \param size the capacity of the location cache
+   */
+  void SetLocationCacheSize (uint32_t size)
+  {
+    m_locationCache.SetCapacity (size);
+  }
+  /**
+   * Get the maximum number of destinations whose last cluster is remembered
+   * \returns the capacity of the cluster cache
+   */
+  uint32_t GetClusterCacheSize () const
+  {
+    return m_lastKnonwCluster.GetCapacity ();
+  }
+  /**
+   * Set the maximum number of destinations whose last cluster is remembered
+   * \param size the capacity of the cluster cache
+   */
+  void SetClusterCacheSize (uint32_t size)
+  {
+    m_lastKnonwCluster.SetCapacity (size);
+  }
+  /**
+   * Get the maximum number of destinations whose last K-means selection is remembered
+   * \returns the capacity of the selection history
+   */
+  uint32_t GetSelectionHistorySize () const
+  {
+    return m_previousSelection.GetCapacity ();
+  }
+  /**
+   * Set the maximum number of destinations whose last K-means selection is remembered
+   * \param size the capacity of the selection history
+   */
+  void SetSelectionHistorySize (uint32_t size)
+  {
+    m_previousSelection.SetCapacity (size);
+  }
+  /**
+   * Get the maximum number of route request timers kept for idle destinations
+   * \returns the capacity of the route request timer cache
+   */
+  uint32_t GetRequestTimerCacheSize () const
+  {
+    return m_addressReqTimer.GetCapacity ();
+  }
+  /**
+   * Set the maximum number of route request timers kept for idle destinations
+   * \param size the capacity of the route request timer cache
+   */
+  void SetRequestTimerCacheSize (uint32_t size)
+  {
+    m_addressReqTimer.SetCapacity (size);
+  }
+  /**
+   * Get the maximum number of nodes whose last SNR awaits their next hello
+   * \returns the capacity of the SNR cache
+   */
+  uint32_t GetSnrCacheSize () const
+  {
+    return m_rxSnr.GetCapacity ();
+  }
+  /**
+   * Set the maximum number of nodes whose last SNR awaits their next hello
+   * \param size the capacity of the SNR cache
+   */
+  void SetSnrCacheSize (uint32_t size)
+  {
+    m_rxSnr.SetCapacity (size);
+  }
+  /**
+   * Get the age after which a remembered position is forgotten
+   * \returns the maximum age
+   */
+  Time GetLocationMaxAge () const
+  {
+    return m_locationCache.GetMaxAge ();
+  }
+  /**
+   * Set the age after which a remembered position is forgotten
+   * \param maxAge the maximum age
+   */
+  void SetLocationMaxAge (Time maxAge)
+  {
+    m_locationCache.SetMaxAge (maxAge);
+  }
+  /**
+   * Get the speed bounding the movement of nodes
+   * \returns the speed, m/s
+   */
+  double GetLocationMaxSpeed () const
+  {
+    return m_locationCache.GetMaxSpeed ();
+  }
+  /**
+   * Set the speed bounding the movement of nodes
+   * \param speed the speed, m/s
+   */
+  void SetLocationMaxSpeed (double speed)
+  {
+    m_locationCache.SetMaxSpeed (speed);
+  }
+  /**
+   * Get the largest error radius of a destination position used for clustering
+   * \returns the radius, meters
+   */
+  double GetLocationConfidenceRadius () const
+  {
+    return m_locationCache.GetConfidenceRadius ();
+  }
+  /**
+   * Set the largest error radius of a destination position used for clustering
+   * \param radius the radius, meters
+   */
+  void SetLocationConfidenceRadius (double radius)
+  {
+    m_locationCache.SetConfidenceRadius (radius);
+  }
+  /**
+   * Set the descriptor of the distance feature of forwarder selection
+   * \param spec the descriptor, see FeatureDescriptor
+   */
+  void SetDistanceFeature (std::string spec)
+  {
+    SetFeature (FeatureSpace::FEATURE_DISTANCE, spec);
+  }
+  /**
+   * Get the descriptor of the distance feature of forwarder selection
+   * \returns the descriptor
+   */
+  std::string GetDistanceFeature () const
+  {
+    return m_featureSpace.GetDescriptor (FeatureSpace::FEATURE_DISTANCE).ToString ();
+  }
+  /**
+   * Set the descriptor of the transmission error feature of forwarder selection
+   * \param spec the descriptor, see FeatureDescriptor
+   */
+  void SetTxErrorFeature (std::string spec)
+  {
+    SetFeature (FeatureSpace::FEATURE_TX_ERROR, spec);
+  }
+  /**
+   * Get the descriptor of the transmission error feature of forwarder selection
+   * \returns the descriptor
+   */
+  std::string GetTxErrorFeature () const
+  {
+    return m_featureSpace.GetDescriptor (FeatureSpace::FEATURE_TX_ERROR).ToString ();
+  }
+  /**
+   * Set the descriptor of the free space feature of forwarder selection
+   * \param spec the descriptor, see FeatureDescriptor
+   */
+  void SetFreeSpaceFeature (std::string spec);
+  /**
+   * Get the descriptor of the free space feature of forwarder selection
+   * \returns the descriptor
+   */
+  std::string GetFreeSpaceFeature () const
+  {
+    return m_featureSpace.GetDescriptor (FeatureSpace::FEATURE_FREE_SPACE).ToString ();
+  }
+  /**
+   * Set the descriptor of the MAC queue occupancy feature of forwarder selection
+   * \param spec the descriptor, see FeatureDescriptor
+   */
+  void SetMacQueueFeature (std::string spec)
+  {
+    SetFeature (FeatureSpace::FEATURE_MAC_QUEUE, spec);
+  }
+  /**
+   * Get the descriptor of the MAC queue occupancy feature of forwarder selection
+   * \returns the descriptor
+   */
+  std::string GetMacQueueFeature () const
+  {
+    return m_featureSpace.GetDescriptor (FeatureSpace::FEATURE_MAC_QUEUE).ToString ();
+  }
+  /**
+   * Set the descriptor of the channel busy feature of forwarder selection
+   * \param spec the descriptor, see FeatureDescriptor
+   */
+  void SetChannelBusyFeature (std::string spec)
+  {
+    SetFeature (FeatureSpace::FEATURE_CHANNEL_BUSY, spec);
+  }
+  /**
+   * Get the descriptor of the channel busy feature of forwarder selection
+   * \returns the descriptor
+   */
+  std::string GetChannelBusyFeature () const
+  {
+    return m_featureSpace.GetDescriptor (FeatureSpace::FEATURE_CHANNEL_BUSY).ToString ();
+  }
+  /**
+   * Set the descriptor of the link SNR feature of forwarder selection
+   * \param spec the descriptor, see FeatureDescriptor
+   */
+  void SetSnrFeature (std::string spec)
+  {
+    SetFeature (FeatureSpace::FEATURE_SNR, spec);
+  }
+  /**
+   * Get the descriptor of the link SNR feature of forwarder selection
+   * \returns the descriptor
+   */
+  std::string GetSnrFeature () const
+  {
+    return m_featureSpace.GetDescriptor (FeatureSpace::FEATURE_SNR).ToString ();
+  }
+  /**
+   * Set the length of the channel busy measurement windows
+   * \param window the length
+   */
+  void SetChannelLoadWindow (Time window)
+  {
+    m_channelLoad.SetWindow (window);
+  }
+  /**
+   * Get the length of the channel busy measurement windows
+   * \returns the length
+   */
+  Time GetChannelLoadWindow () const
+  {
+    return m_channelLoad.GetWindow ();
+  }
   /**
    * Get destination only flag
    * \returns the destination only flag
@@ -182,6 +694,51 @@ public:
    */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * \param a a set of addresses
+   * \param b another set of addresses
+   * \returns the size of their intersection over the size of their union, 1 if both are empty
+   */
+  static double Jaccard (std::vector<Ipv4Address> a, std::vector<Ipv4Address> b);
+  /**
+   * Adapt the hello interval to the topology changes seen since the last hello
+   * \param interval the current hello interval
+   * \param changed whether the topology changed since the last hello
+   * \param minInterval the shortest hello interval
+   * \param maxInterval the longest hello interval
+   * \returns the interval halved if the topology changed, lengthened by a quarter
+   * otherwise, within [minInterval, maxInterval]
+   */
+  static Time AdaptHelloInterval (Time interval, bool changed, Time minInterval, Time maxInterval);
+  /**
+   * Lifetime advertised by a hello, so that the neighbors wait for the hello
+   * following allowedHelloLoss - 1 lost ones, however long the intervals grow
+   * \param interval the hello interval until the next hello
+   * \param allowedHelloLoss the number of hellos a neighbor is expected to wait for
+   * \param maxInterval the longest hello interval, 0 if the interval does not grow
+   * \returns the lifetime of the hello
+   */
+  static Time GetHelloLifetime (Time interval, uint32_t allowedHelloLoss, Time maxInterval);
+  /**
+   * \returns the simulator events scheduled, cancelled and executed by the protocol
+   */
+  EventAccounting const & GetEventAccounting () const
+  {
+    return m_events;
+  }
+  /**
+   * \returns the estimated heap memory held by the data structures of the protocol
+   */
+  MemoryUsage GetMemoryUsage () const;
+  /**
+   * Get the smoothed SNR of the link to a neighbor, measured while the SNR
+   * feature is enabled
+   * \param neighbor the IP address of the neighbor
+   * \param snr the SNR, dB
+   * \returns false if the link was never measured
+   */
+  bool GetLinkSnr (Ipv4Address neighbor, double & snr);
+
 protected:
   virtual void DoInitialize (void);
 private:
@@ -192,6 +749,133 @@ private:
    * \param mpdu the dropped MPDU
    */
   void NotifyTxError (WifiMacDropReason reason, Ptr<const WifiMacQueueItem> mpdu);
+  /**
+   * Notify that the PHY received a frame, to measure the SNR of aodvKmeans packets.
+   *
+   * \param packet the received frame
+   * \param channelFreqMhz the frequency of the channel
+   * \param txVector the TXVECTOR of the frame
+   * \param aMpdu the A-MPDU information of the frame
+   * \param signalNoise the signal and noise power of the frame
+   * \param staId the STA-ID of the frame
+   */
+  void NotifySnifferRx (Ptr<const Packet> packet, uint16_t channelFreqMhz, WifiTxVector txVector,
+                        MpduInfo aMpdu, SignalNoiseDbm signalNoise, uint16_t staId);
+  /**
+   * Fold the SNR measured on the last packet from a neighbor into its entry
+   * \param neighbor the routing table entry of the neighbor
+   */
+  void UpdateLinkSnr (RoutingTableEntry & neighbor);
+  /**
+   * Start or stop measuring the SNR of the packets received by an interface
+   * \param wifi the interface
+   * \param enable true to start, false to stop
+   */
+  void MonitorSnr (Ptr<WifiNetDevice> wifi, bool enable);
+  /**
+   * Get the transmission error rate advertised in hellos and replies
+   * \returns the decayed error rate of the node, in units of 1/1000 errors per second
+   */
+  uint32_t GetAdvertisedTxError () const;
+  /**
+   * Get the transmission error rate of the link to a neighbor
+   * \param nextHop the IP address of the neighbor
+   * \returns the decayed error rate of the link, in units of 1/1000 errors per second
+   */
+  double GetLinkTxError (Ipv4Address nextHop);
+  /**
+   * Attach the current velocity of this node to a hello or reply, if enabled
+   * \param rrepHeader the reply
+   */
+  void AddVelocity (RrepHeader & rrepHeader);
+  /**
+   * Attach the current load of the interfaces of this node to a hello or reply, if enabled
+   * \param rrepHeader the reply
+   */
+  void AddChannelLoad (RrepHeader & rrepHeader);
+  /**
+   * Decide whether the next hello starts a new position keyframe
+   * \returns true if the hello carries an absolute position
+   */
+  bool NextHelloKeyframe ();
+  /**
+   * Turn the position of a received hello or reply into an absolute position,
+   * using the last keyframe of its originator for delta encoded positions
+   * \param rrepHeader the reply
+   * \param located set to true if the position filled in is usable, advertised or remembered
+   * \returns true if the reply carries a usable position; otherwise the last
+   * known position of the originator is filled in, if any
+   */
+  bool ResolvePosition (RrepHeader & rrepHeader, bool & located);
+  /**
+   * Remember the position and velocity advertised by a reply for its destination
+   * \param rrepHeader the reply
+   */
+  void UpdateLastKnownPosition (RrepHeader const & rrepHeader);
+  /**
+   * Remember the position of a node, unless a more recent one is known
+   * \param node the node
+   * \param positionX the X position
+   * \param positionY the Y position
+   * \param sampled the time the position was sampled at
+   * \returns true if the position was remembered
+   */
+  bool LearnPosition (Ipv4Address node, double positionX, double positionY, Time sampled);
+  /**
+   * Gossip the most recently learned positions of non-neighbors in a hello
+   * \param helloHeader the hello
+   */
+  void AddLocationGossip (RrepHeader & helloHeader);
+  /**
+   * \returns the parameters of forwarder selection, from the attributes
+   */
+  KmeansParameters GetKmeansParameters () const;
+  /**
+   * Select the neighbors a RREQ is unicast to, from the cluster cache or by K-means
+   * \param dst the destination of the RREQ
+   * \param posDst the estimated position of the destination
+   * \returns the selected neighbors, empty if the RREQ must be broadcast
+   */
+  std::vector<Ipv4Address> SelectForwarders (Ipv4Address dst, Vector const & posDst);
+  /**
+   * Update the descriptor of a feature of forwarder selection
+   * \param feature the feature
+   * \param spec the descriptor string, aborts if malformed
+   */
+  void SetFeature (FeatureSpace::Feature feature, std::string const & spec);
+  /**
+   * Estimate the current position of a destination from its last known
+   * position and velocity
+   * \param dst the destination
+   * \param position the estimated position
+   * \returns false if the position is unknown or too uncertain to steer route discovery
+   */
+  bool GetDestinationPosition (Ipv4Address dst, Vector & position);
+  /**
+   * Notify that a packet was dropped from the request queue.
+   *
+   * \param p the dropped packet
+   * \param header the IP header of the dropped packet
+   * \param reason the reason of the drop
+   * \param priorityClass the priority class of the dropped packet
+   */
+  void NotifyQueueDrop (Ptr<const Packet> p, const Ipv4Header & header, std::string reason, uint8_t priorityClass);
+  /**
+   * Notify that a packet left the request queue.
+   *
+   * \param p the packet
+   * \param header its IP header
+   * \param sojourn the time it spent in the queue
+   * \param dropped true if dropped, false if dequeued
+   */
+  void NotifyQueueSojourn (Ptr<const Packet> p, const Ipv4Header & header, Time sojourn, bool dropped);
+  /**
+   * Notify that a route became valid or was invalidated.
+   *
+   * \param route the routing table entry
+   * \param valid whether it became valid
+   */
+  void NotifyRouteChange (RoutingTableEntry const & route, bool valid);
 
   // Protocol parameters.
   uint32_t m_rreqRetries;             ///< Maximum number of retransmissions of RREQ with TTL = NetDiameter to discover a route
@@ -217,6 +901,11 @@ private:
    */
   Time m_helloInterval;
   uint32_t m_allowedHelloLoss;         ///< Number of hello messages which may be loss for valid link
+  bool m_adaptiveHello;                ///< Indicates whether the hello interval follows the topology changes
+  Time m_minHelloInterval;             ///< Shortest adaptive hello interval
+  Time m_maxHelloInterval;             ///< Longest adaptive hello interval
+  double m_helloMovementThreshold;     ///< Movement between two hellos of a node considered a topology change, m
+  TracedValue<Time> m_currentHelloInterval; ///< Hello interval in use
   /**
    * DeletePeriod is intended to provide an upper bound on the time for which an upstream node A
    * can have a neighbor B as an active next hop for destination D, while B has invalidated the route to D.
@@ -230,6 +919,22 @@ private:
   bool m_gratuitousReply;              ///< Indicates whether a gratuitous RREP should be unicast to the node originated route discovery.
   bool m_enableHello;                  ///< Indicates whether a hello messages enable
   bool m_enableBroadcast;              ///< Indicates whether a a broadcast data packets forwarding enable
+  bool m_enableVelocity;               ///< Indicates whether hellos and replies carry the velocity of the node
+  KmeansExtension m_kmeansExtension;   ///< Encoding of the K-means metrics in hellos and replies
+  uint32_t m_helloKeyframeInterval;    ///< Hellos between two absolute positions with the compact encoding
+  bool m_locationService;              ///< Indicates whether RREQs carry the position of their originator
+  uint32_t m_locationGossipSize;       ///< Number of positions of other nodes gossiped in each hello
+  KmeansClusterCount m_kmeansClusterCount; ///< How the number of clusters of forwarder candidates is chosen
+  uint32_t m_kmeansClusters;           ///< Number of clusters when m_kmeansClusterCount is KMEANS_K_FIXED
+  uint32_t m_kmeansMaxClusters;        ///< Largest number of clusters otherwise
+  uint32_t m_targetForwarders;         ///< Forwarders per cluster aimed at with KMEANS_K_TARGET
+  double m_kmeansMinInertiaDrop;       ///< Smallest relative inertia drop worth one more cluster with KMEANS_K_ELBOW
+  uint32_t m_maxForwarders;            ///< Largest number of neighbors a RREQ is unicast to, 0 for no limit
+  FeatureSpace m_featureSpace;         ///< Features of forwarder selection
+  bool m_freeSpaceMaxSet;              ///< Indicates whether Max of the free space feature was configured
+  bool m_freeSpaceIdealSet;            ///< Indicates whether Ideal of the free space feature was configured
+  bool m_advertiseChannelLoad;         ///< Indicates whether hellos and replies carry the load of the interfaces
+  double m_snrSmoothing;               ///< Weight of the SNR of a new hello in the moving average of its link
   //\}
 
   /// IP protocol
@@ -259,17 +964,81 @@ private:
   uint16_t m_rreqCount;
   /// Number of RERRs used for RERR rate control
   uint16_t m_rerrCount;
+  /// Trace of packets dropped from the request queue
+  TracedCallback<Ptr<const Packet>, const Ipv4Header &, std::string, uint8_t> m_queueDropTrace;
+  /// Trace of packets leaving the request queue
+  TracedCallback<Ptr<const Packet>, const Ipv4Header &, Time, bool> m_queueSojournTrace;
+  /// Trace of request queue occupancy samples
+  TracedCallback<const QueueSample &> m_queueSampleTrace;
 
-  /// interaction count with ip addresses
-  std::map<Ipv4Address, uint32_t> m_interactionCount;
-  /// successful delivery of messages
-  uint32_t m_txerrorCount;
+  /// Time decayed transmission errors of each link
+  LinkQualityTable m_linkQuality;
+  /// MAC queue occupancy and channel busy fraction of the interfaces
+  ChannelLoadMonitor m_channelLoad;
+  /// SNR of the last aodvKmeans packet received from each neighbor, dB, until its next hello
+  LruCache<Ipv4Address, double, Ipv4AddressHash> m_rxSnr;
   /// my position
   Vector m_position;
   /// last known position of nodes
-  std::map<Ipv4Address, std::pair<uint32_t, uint32_t> > m_lastKnownPosition;
-  /// last known cluster
-  std::map<Ipv4Address, std::vector<Ipv4Address>> m_lastKnonwCluster;
+  LocationCache m_locationCache;
+  /// RREQs sent to a cluster of neighbors
+  TracedValue<uint32_t> m_clusteredRreqs;
+  /// RREQs broadcast
+  TracedValue<uint32_t> m_floodedRreqs;
+  /// Number of routing table entries, sampled after every control packet
+  TracedValue<uint32_t> m_routingTableSize;
+  /// Trace of originated RREQs
+  TracedCallback<const RreqHeader &> m_rreqOriginateTrace;
+  /// Trace of forwarded RREQs
+  TracedCallback<const RreqHeader &> m_rreqForwardTrace;
+  /// Trace of dropped RREQs
+  TracedCallback<const RreqHeader &, RreqDropReason> m_rreqDropTrace;
+  /// Trace of RREQs sent to a cluster of neighbors or broadcast
+  TracedCallback<const RreqHeader &, uint32_t> m_rreqSendTrace;
+  /// Trace of forwarder selections by K-means
+  TracedCallback<Ipv4Address, uint32_t, const std::vector<Ipv4Address> &> m_kmeansTrace;
+  /// Trace of the quality of forwarder selections by K-means
+  TracedCallback<Ipv4Address, const KmeansQuality &, double> m_clusterQualityTrace;
+  /// Trace of cluster cache lookups
+  TracedCallback<Ipv4Address, bool> m_clusterCacheTrace;
+  /// Trace of sent RREPs
+  TracedCallback<const RrepHeader &, Ipv4Address> m_rrepSendTrace;
+  /// Trace of received RREPs, hellos excluded
+  TracedCallback<const RrepHeader &, Ipv4Address> m_rrepReceiveTrace;
+  /// Trace of sent RERRs
+  TracedCallback<const RerrHeader &, Ipv4Address> m_rerrSendTrace;
+  /// Trace of the times from the first RREQ of a route discovery to its first RREP
+  TracedCallback<Ipv4Address, Time, bool, uint32_t> m_replyLatencyTrace;
+  /// Trace of the times from buffering the first packet of a route discovery to sending it
+  TracedCallback<Ipv4Address, Time, bool, uint32_t> m_discoveryLatencyTrace;
+  /// Trace of the route discoveries started for buffered packets
+  TracedCallback<Ipv4Address, bool> m_discoveryStartTrace;
+  /// Trace of routes becoming valid or invalidated
+  TracedCallback<const RoutingTableEntry &, bool> m_routeChangeTrace;
+
+  /// Progress of a route discovery for buffered packets
+  struct DiscoveryTiming
+  {
+    Time m_queued;     ///< When the first packet was buffered
+    Time m_requested;  ///< When the first RREQ was sent
+    uint32_t m_rreqs;  ///< Number of RREQs sent
+    bool m_clustered;  ///< Whether the last RREQ was sent to a cluster of neighbors
+    bool m_replied;    ///< Whether a RREP was received
+  };
+  /// Route discoveries in progress, by destination
+  std::map<Ipv4Address, DiscoveryTiming> m_discoveries;
+  /// last position keyframe received from each neighbor, dropped with the neighbor
+  std::map<Ipv4Address, std::pair<uint8_t, Vector> > m_neighborKeyframes;
+  /// number of my last position keyframe
+  uint8_t m_keyframe;
+  /// position of my last keyframe
+  Vector m_keyframePosition;
+  /// hellos sent since my last keyframe
+  uint32_t m_hellosSinceKeyframe;
+  /// last known cluster, least recently used destinations evicted
+  LruCache<Ipv4Address, std::vector<Ipv4Address>, Ipv4AddressHash> m_lastKnonwCluster;
+  /// last forwarders selected by K-means, by destination, kept beyond the cluster cache
+  LruCache<Ipv4Address, std::vector<Ipv4Address>, Ipv4AddressHash> m_previousSelection;
   
 
 
@@ -342,8 +1111,9 @@ private:
    * 
    * \param rrepHeader RREP message header
    * \param receiverIfaceAddr receiver interface IP address
+   * \param located whether the position of the header is usable, the previous one is kept otherwise
    */
-  void ProcessHello (RrepHeader const & rrepHeader, Ipv4Address receiverIfaceAddr);
+  void ProcessHello (RrepHeader const & rrepHeader, Ipv4Address receiverIfaceAddr, bool located);
   /**
    * Create loopback route for given header
    *
@@ -441,6 +1211,43 @@ private:
    * \param destination - destination node IP address
    */
   void SendTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination);
+  /**
+   * Schedule SendTo and account for the event
+   * \param delay the delay of the transmission
+   * \param socket - destination node socket
+   * \param packet - packet to send
+   * \param destination - destination node IP address
+   * \param type the kind of event
+   */
+  void ScheduleSendTo (Time delay, Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination,
+                       EventAccounting::EventType type);
+  /**
+   * Send a packet scheduled by ScheduleSendTo
+   * \param socket - destination node socket
+   * \param packet - packet to send
+   * \param destination - destination node IP address
+   * \param type the kind of event
+   */
+  void ScheduledSendTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination,
+                        EventAccounting::EventType type);
+  /**
+   * Send a RREQ delayed by the RREQ rate limit
+   * \param dst the destination of the RREQ
+   */
+  void DeferredSendRequest (Ipv4Address dst);
+  /**
+   * Schedule a timer and account for the event
+   * \param timer the timer, not running
+   * \param delay the delay
+   * \param type the kind of event
+   */
+  void ScheduleTimer (Timer & timer, Time delay, EventAccounting::EventType type);
+  /**
+   * Cancel a timer if it is running, and account for the event
+   * \param timer the timer
+   * \param type the kind of event
+   */
+  void CancelTimer (Timer & timer, EventAccounting::EventType type);
 
   /**
    * Select next forwarder of message
@@ -455,6 +1262,18 @@ private:
   Timer m_htimer;
   /// Schedule next send of hello message
   void HelloTimerExpire ();
+  /**
+   * Adapt the hello interval to the topology changes seen since the last hello:
+   * halve it if a neighbor appeared, was lost or moved more than
+   * HelloMovementThreshold (or this node did), lengthen it by a quarter otherwise
+   */
+  void UpdateHelloInterval ();
+  /// Neighbors gained or lost since the last hello
+  uint32_t m_helloChurn;
+  /// Largest movement of a neighbor or of this node since the last hello, m
+  double m_helloMovement;
+  /// Position of this node at its last hello
+  Vector m_lastHelloPosition;
   /// RREQ rate limit timer
   Timer m_rreqRateLimitTimer;
   /// Reset RREQ count and schedule RREQ rate limit timer with delay 1 sec.
@@ -463,8 +1282,16 @@ private:
   Timer m_rerrRateLimitTimer;
   /// Reset RERR count and schedule RERR rate limit timer with delay 1 sec.
   void RerrRateLimitTimerExpire ();
-  /// Map IP address + RREQ timer.
-  std::map<Ipv4Address, Timer> m_addressReqTimer;
+  /// Request queue occupancy sampling timer
+  Timer m_queueSampleTimer;
+  /// Interval between request queue occupancy samples, 0 to disable sampling
+  Time m_queueSampleInterval;
+  /// Sample the request queue occupancy and schedule the next sample
+  void QueueSampleTimerExpire ();
+  /// Map IP address + RREQ timer, the timers of running discoveries are never evicted
+  LruCache<Ipv4Address, Timer, Ipv4AddressHash> m_addressReqTimer;
+  /// Simulator events of the protocol
+  EventAccounting m_events;
   /// clear cluster
   void ClusterTimerExpire(Ipv4Address dst);
   /**
@@ -26,10 +26,16 @@
  *          Pavel Boyko <boyko@iitp.ru>
  */
 #include "aodvKmeans-rqueue.h"
+#include "aodvKmeans-profiler.h"
+#include "aodvKmeans-memory-usage.h"
 #include <algorithm>
 #include <functional>
 #include "ns3/ipv4-route.h"
 #include "ns3/socket.h"
+#include "ns3/udp-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/tcp-l4-protocol.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -47,6 +53,7 @@ RequestQueue::GetSize ()
 bool
 RequestQueue::Enqueue (QueueEntry & entry)
 {
+  AODVKMEANS_PROFILE (PROBE_ENQUEUE);
   Purge ();
   for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
        != m_queue.end (); ++i)
@@ -59,16 +66,263 @@ RequestQueue::Enqueue (QueueEntry & entry)
         }
     }
   entry.SetExpireTime (m_queueTimeout);
-  if (m_queue.size () == m_maxLen)
+  entry.SetEnqueueTime (Simulator::Now ());
+  Classify (entry);
+  if (m_scheduling == QUEUE_FIFO)
     {
-      Drop (m_queue.front (), "Drop the most aged packet"); // Drop the most aged packet
-      m_queue.erase (m_queue.begin ());
+      if (m_queue.size () == m_maxLen)
+        {
+          Drop (m_queue.front (), "Drop the most aged packet"); // Drop the most aged packet
+          m_queue.erase (m_queue.begin ());
+        }
+      m_queue.push_back (entry);
+      return true;
+    }
+
+  QueueFlowId flow = entry.GetFlowId ();
+  if (m_flowQuota > 0 && GetFlowSize (flow) >= m_flowQuota)
+    {
+      DropFlowHead (flow, "Drop the most aged packet of flow over quota ");
+    }
+  if (m_queue.size () >= m_maxLen)
+    {
+      if (!MakeRoom (entry))
+        {
+          Drop (entry, "Drop arriving packet of lowest priority class ");
+          return true;
+        }
+      ForgetDrainedFlows ();
+    }
+  if (m_deficit.find (flow) == m_deficit.end ())
+    {
+      m_activeFlows.push_back (flow);
+      m_deficit[flow] = 0;
     }
   m_queue.push_back (entry);
-  
   return true;
 }
 
+uint8_t
+RequestQueue::GetPriorityClass (Ipv4Header::DscpType dscp)
+{
+  switch (dscp)
+    {
+    case Ipv4Header::DSCP_EF:
+    case Ipv4Header::DSCP_CS5:
+    case Ipv4Header::DSCP_CS6:
+    case Ipv4Header::DSCP_CS7:
+      return CLASS_HIGH;
+    case Ipv4Header::DSCP_CS1:
+      return CLASS_BACKGROUND;
+    default:
+      return CLASS_NORMAL;
+    }
+}
+
+void
+RequestQueue::Classify (QueueEntry & entry) const
+{
+  Ipv4Header const & header = entry.GetIpv4Header ();
+  entry.SetPriorityClass (GetPriorityClass (header.GetDscp ()));
+
+  QueueFlowId flow;
+  flow.m_dst = header.GetDestination ();
+  if (m_flowKey == FLOW_BY_FIVE_TUPLE)
+    {
+      flow.m_src = header.GetSource ();
+      flow.m_protocol = header.GetProtocol ();
+      Ptr<const Packet> p = entry.GetPacket ();
+      if (flow.m_protocol == UdpL4Protocol::PROT_NUMBER && p->GetSize () >= 8)
+        {
+          UdpHeader udpHeader;
+          p->PeekHeader (udpHeader);
+          flow.m_srcPort = udpHeader.GetSourcePort ();
+          flow.m_dstPort = udpHeader.GetDestinationPort ();
+        }
+      else if (flow.m_protocol == TcpL4Protocol::PROT_NUMBER && p->GetSize () >= 20)
+        {
+          TcpHeader tcpHeader;
+          p->PeekHeader (tcpHeader);
+          flow.m_srcPort = tcpHeader.GetSourcePort ();
+          flow.m_dstPort = tcpHeader.GetDestinationPort ();
+        }
+    }
+  entry.SetFlowId (flow);
+}
+
+uint32_t
+RequestQueue::GetFlowSize (QueueFlowId const & flow) const
+{
+  uint32_t n = 0;
+  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      if (i->GetFlowId () == flow)
+        {
+          n++;
+        }
+    }
+  return n;
+}
+
+void
+RequestQueue::DropFlowHead (QueueFlowId const & flow, std::string reason)
+{
+  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      if (i->GetFlowId () == flow)
+        {
+          Drop (*i, reason);
+          m_queue.erase (i);
+          return;
+        }
+    }
+}
+
+void
+RequestQueue::ForgetDrainedFlows ()
+{
+  std::list<QueueFlowId>::iterator f = m_activeFlows.begin ();
+  while (f != m_activeFlows.end ())
+    {
+      if (GetFlowSize (*f) == 0)
+        {
+          m_deficit.erase (*f);
+          f = m_activeFlows.erase (f);
+        }
+      else
+        {
+          ++f;
+        }
+    }
+}
+
+bool
+RequestQueue::MakeRoom (QueueEntry const & entry)
+{
+  // The victim is taken from the lowest priority class present, the arriving packet included
+  uint8_t victimClass = entry.GetPriorityClass ();
+  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      victimClass = std::max (victimClass, i->GetPriorityClass ());
+    }
+  // Within that class the longest flow pays, counting the arriving packet
+  std::map<QueueFlowId, uint32_t> backlog;
+  if (entry.GetPriorityClass () == victimClass)
+    {
+      backlog[entry.GetFlowId ()] = 1;
+    }
+  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      if (i->GetPriorityClass () == victimClass)
+        {
+          backlog[i->GetFlowId ()]++;
+        }
+    }
+  std::map<QueueFlowId, uint32_t>::const_iterator victim = backlog.end ();
+  for (std::map<QueueFlowId, uint32_t>::const_iterator i = backlog.begin (); i != backlog.end (); ++i)
+    {
+      if (victim == backlog.end () || i->second > victim->second)
+        {
+          victim = i;
+        }
+    }
+  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      if (i->GetPriorityClass () == victimClass && i->GetFlowId () == victim->first)
+        {
+          Drop (*i, "Drop the most aged packet of the longest flow ");
+          m_queue.erase (i);
+          return true;
+        }
+    }
+  // Only the arriving packet belongs to the victim flow
+  return false;
+}
+
+bool
+RequestQueue::DequeueFair (Ipv4Address dst, QueueEntry & entry)
+{
+  // Serve the highest priority class queued for dst
+  uint8_t best = CLASS_COUNT;
+  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      if (i->GetIpv4Header ().GetDestination () == dst)
+        {
+          best = std::min (best, i->GetPriorityClass ());
+        }
+    }
+  if (best == CLASS_COUNT)
+    {
+      return false;
+    }
+  // Deficit round robin among the flows of dst holding packets of that class
+  std::list<QueueFlowId>::iterator f = m_activeFlows.begin ();
+  while (f != m_activeFlows.end ())
+    {
+      if (!(f->m_dst == dst))
+        {
+          ++f;
+          continue;
+        }
+      std::vector<QueueEntry>::iterator head = m_queue.end ();
+      bool backlogged = false;
+      for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+        {
+          if (i->GetFlowId () == *f)
+            {
+              backlogged = true;
+              if (i->GetPriorityClass () == best)
+                {
+                  head = i;
+                  break;
+                }
+            }
+        }
+      if (!backlogged)
+        {
+          // Flow drained by purge or drop, forget it
+          m_deficit.erase (*f);
+          f = m_activeFlows.erase (f);
+          continue;
+        }
+      if (head == m_queue.end ())
+        {
+          ++f;
+          continue;
+        }
+      uint32_t size = head->GetPacket ()->GetSize ();
+      uint32_t & deficit = m_deficit[*f];
+      if (deficit < size)
+        {
+          deficit += m_quantum;
+          m_activeFlows.splice (m_activeFlows.end (), m_activeFlows, f);
+          f = m_activeFlows.begin ();
+          continue;
+        }
+      deficit -= size;
+      QueueFlowId flow = *f;
+      entry = *head;
+      m_queue.erase (head);
+      if (GetFlowSize (flow) == 0)
+        {
+          m_deficit.erase (flow);
+          m_activeFlows.erase (f);
+        }
+      return true;
+    }
+  // Entries queued before the fair mode was enabled are not tracked as flows
+  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      if (i->GetIpv4Header ().GetDestination () == dst && i->GetPriorityClass () == best)
+        {
+          entry = *i;
+          m_queue.erase (i);
+          return true;
+        }
+    }
+  return false;
+}
+
 void
 RequestQueue::DropPacketWithDst (Ipv4Address dst)
 {
@@ -85,22 +339,36 @@ RequestQueue::DropPacketWithDst (Ipv4Address dst)
   auto new_end = std::remove_if (m_queue.begin (), m_queue.end (),
                                  [&](const QueueEntry& en) { return en.GetIpv4Header ().GetDestination () == dst; });
   m_queue.erase (new_end, m_queue.end ());
+  ForgetDrainedFlows ();
 }
 
 bool
 RequestQueue::Dequeue (Ipv4Address dst, QueueEntry & entry)
 {
   Purge ();
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+  bool found = false;
+  if (m_scheduling == QUEUE_FAIR)
     {
-      if (i->GetIpv4Header ().GetDestination () == dst)
+      found = DequeueFair (dst, entry);
+    }
+  else
+    {
+      for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
         {
-          entry = *i;
-          m_queue.erase (i);
-          return true;
+          if (i->GetIpv4Header ().GetDestination () == dst)
+            {
+              entry = *i;
+              m_queue.erase (i);
+              found = true;
+              break;
+            }
         }
     }
-  return false;
+  if (found)
+    {
+      NotifyDeparture (entry, false);
+    }
+  return found;
 }
 
 bool
@@ -140,16 +408,22 @@ void
 RequestQueue::Purge ()
 {
   IsExpired pred;
+  bool expired = false;
   for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i
        != m_queue.end (); ++i)
     {
       if (pred (*i))
         {
           Drop (*i, "Drop outdated packet ");
+          expired = true;
         }
     }
-  m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (), pred),
-                 m_queue.end ());
+  if (expired)
+    {
+      m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (), pred),
+                     m_queue.end ());
+      ForgetDrainedFlows ();
+    }
 }
 
 void
@@ -158,8 +432,90 @@ RequestQueue::Drop (QueueEntry en, std::string reason)
   NS_LOG_LOGIC (reason << en.GetPacket ()->GetUid () << " " << en.GetIpv4Header ().GetDestination ());
   en.GetErrorCallback () (en.GetPacket (), en.GetIpv4Header (),
                           Socket::ERROR_NOROUTETOHOST);
+  if (!m_dropCallback.IsNull ())
+    {
+      m_dropCallback (en.GetPacket (), en.GetIpv4Header (), reason, en.GetPriorityClass ());
+    }
+  NotifyDeparture (en, true);
   return;
 }
 
+void
+RequestQueue::NotifyDeparture (QueueEntry const & en, bool dropped)
+{
+  Time sojourn = Simulator::Now () - en.GetEnqueueTime ();
+  if (dropped)
+    {
+      m_droppedSinceSample++;
+    }
+  else
+    {
+      m_dequeuedSinceSample++;
+    }
+  m_sojournSinceSample += sojourn;
+  if (!m_sojournCallback.IsNull ())
+    {
+      m_sojournCallback (en.GetPacket (), en.GetIpv4Header (), sojourn, dropped);
+    }
+}
+
+QueueSample
+RequestQueue::SampleOccupancy ()
+{
+  QueueSample sample;
+  sample.m_time = Simulator::Now ();
+  sample.m_length = GetSize ();
+  sample.m_dequeued = m_dequeuedSinceSample;
+  sample.m_dropped = m_droppedSinceSample;
+  uint32_t departures = m_dequeuedSinceSample + m_droppedSinceSample;
+  if (departures > 0)
+    {
+      sample.m_meanSojourn = m_sojournSinceSample / departures;
+    }
+  m_samples.Push (sample);
+  m_dequeuedSinceSample = 0;
+  m_droppedSinceSample = 0;
+  m_sojournSinceSample = Seconds (0);
+  return sample;
+}
+
+void
+RequestQueue::PrintSamplesHeader (std::ostream & os)
+{
+  os << "time,node,length,dequeued,dropped,meanSojourn" << std::endl;
+}
+
+void
+RequestQueue::PrintSamples (std::ostream & os, uint32_t node) const
+{
+  for (uint32_t i = 0; i < m_samples.GetSize (); i++)
+    {
+      QueueSample const & sample = m_samples.Get (i);
+      os << sample.m_time.GetSeconds () << "," << node << "," << sample.m_length << "," << sample.m_dequeued
+         << "," << sample.m_dropped << "," << sample.m_meanSojourn.GetSeconds () << std::endl;
+    }
+}
+
+uint64_t
+RequestQueue::GetMemoryBytes () const
+{
+  return MemoryBytes (m_queue) + MemoryBytes (m_activeFlows) + MemoryBytes (m_deficit)
+         + static_cast<uint64_t> (m_samples.GetCapacity ()) * sizeof (QueueSample);
+}
+
+uint64_t
+RequestQueue::GetPacketBytes () const
+{
+  uint64_t bytes = 0;
+  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      if (i->GetPacket () != 0)
+        {
+          bytes += sizeof (Packet) + i->GetPacket ()->GetSize ();
+        }
+    }
+  return bytes;
+}
+
 }  // namespace aodvKmeans
 }  // namespace ns3
@@ -29,13 +29,110 @@
 #define aodvKmeans_RQUEUE_H
 
 #include <vector>
+#include <list>
+#include <map>
+#include <ostream>
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/simulator.h"
+#include "ns3/assert.h"
+#include "aodvKmeans-ring-buffer.h"
 
 
 namespace ns3 {
 namespace aodvKmeans {
 
+/**
+ * \ingroup aodvKmeans
+ * \brief Scheduling discipline of the route request queue
+ */
+enum QueueScheduling
+{
+  QUEUE_FIFO = 0,     //!< single drop-front queue
+  QUEUE_FAIR = 1,     //!< per-flow quotas, priority classes and deficit round robin
+};
+
+/**
+ * \ingroup aodvKmeans
+ * \brief How queued packets are grouped into flows in QUEUE_FAIR mode
+ */
+enum QueueFlowKey
+{
+  FLOW_BY_DESTINATION = 0,  //!< one flow per destination address
+  FLOW_BY_FIVE_TUPLE = 1,   //!< one flow per (src, dst, protocol, src port, dst port)
+};
+
+/**
+ * \ingroup aodvKmeans
+ * \brief Priority classes derived from the DSCP of the queued packet
+ */
+enum QueueClass
+{
+  CLASS_HIGH = 0,         //!< EF, CS5 and above
+  CLASS_NORMAL = 1,       //!< default forwarding and AF classes
+  CLASS_BACKGROUND = 2,   //!< CS1 (lower effort)
+  CLASS_COUNT = 3,        //!< number of classes
+};
+
+/**
+ * \ingroup aodvKmeans
+ * \brief Flow identifier of a queued packet
+ */
+struct QueueFlowId
+{
+  /// Source address (unset when flows are keyed by destination)
+  Ipv4Address m_src;
+  /// Destination address
+  Ipv4Address m_dst;
+  /// IP protocol number
+  uint8_t m_protocol;
+  /// Transport source port
+  uint16_t m_srcPort;
+  /// Transport destination port
+  uint16_t m_dstPort;
+
+  QueueFlowId ()
+    : m_protocol (0),
+      m_srcPort (0),
+      m_dstPort (0)
+  {
+  }
+  /**
+   * \brief Compare flow identifiers
+   * \param o QueueFlowId to compare
+   * \return true if equal
+   */
+  bool operator== (QueueFlowId const & o) const
+  {
+    return (m_src == o.m_src && m_dst == o.m_dst && m_protocol == o.m_protocol
+            && m_srcPort == o.m_srcPort && m_dstPort == o.m_dstPort);
+  }
+  /**
+   * \brief Strict weak ordering, so that flow ids can be used as map keys
+   * \param o QueueFlowId to compare
+   * \return true if this flow id sorts before o
+   */
+  bool operator< (QueueFlowId const & o) const
+  {
+    if (m_dst != o.m_dst)
+      {
+        return m_dst < o.m_dst;
+      }
+    if (m_src != o.m_src)
+      {
+        return m_src < o.m_src;
+      }
+    if (m_protocol != o.m_protocol)
+      {
+        return m_protocol < o.m_protocol;
+      }
+    if (m_srcPort != o.m_srcPort)
+      {
+        return m_srcPort < o.m_srcPort;
+      }
+    return m_dstPort < o.m_dstPort;
+  }
+};
+
 /**
  * \ingroup aodvKmeans
  * \brief aodvKmeans Queue Entry
@@ -63,7 +160,9 @@ public:
       m_header (h),
       m_ucb (ucb),
       m_ecb (ecb),
-      m_expire (exp + Simulator::Now ())
+      m_expire (exp + Simulator::Now ()),
+      m_class (CLASS_NORMAL),
+      m_enqueueTime (Simulator::Now ())
   {
   }
 
@@ -158,6 +257,54 @@ public:
   {
     return m_expire - Simulator::Now ();
   }
+  /**
+   * Get the flow this entry was classified into
+   * \returns the flow id
+   */
+  QueueFlowId GetFlowId () const
+  {
+    return m_flow;
+  }
+  /**
+   * Set the flow of this entry
+   * \param flow the flow id
+   */
+  void SetFlowId (QueueFlowId flow)
+  {
+    m_flow = flow;
+  }
+  /**
+   * Get the priority class of this entry
+   * \returns the priority class
+   */
+  uint8_t GetPriorityClass () const
+  {
+    return m_class;
+  }
+  /**
+   * Set the priority class of this entry
+   * \param c the priority class
+   */
+  void SetPriorityClass (uint8_t c)
+  {
+    m_class = c;
+  }
+  /**
+   * Get the time this entry was queued
+   * \returns the enqueue time
+   */
+  Time GetEnqueueTime () const
+  {
+    return m_enqueueTime;
+  }
+  /**
+   * Set the time this entry was queued
+   * \param t the enqueue time
+   */
+  void SetEnqueueTime (Time t)
+  {
+    m_enqueueTime = t;
+  }
 
 private:
   /// Data packet
@@ -170,16 +317,88 @@ private:
   ErrorCallback m_ecb;
   /// Expire time for queue entry
   Time m_expire;
+  /// Flow this entry belongs to
+  QueueFlowId m_flow;
+  /// Priority class (see QueueClass)
+  uint8_t m_class;
+  /// Time the entry was queued
+  Time m_enqueueTime;
+};
+
+/**
+ * \ingroup aodvKmeans
+ * \brief Occupancy of the route request queue at a point in time
+ */
+struct QueueSample
+{
+  /// When the sample was taken
+  Time m_time;
+  /// Number of packets queued
+  uint32_t m_length;
+  /// Packets dequeued since the previous sample
+  uint32_t m_dequeued;
+  /// Packets dropped since the previous sample
+  uint32_t m_dropped;
+  /// Mean sojourn time of the packets that left the queue since the previous sample
+  Time m_meanSojourn;
+  QueueSample ()
+    : m_length (0),
+      m_dequeued (0),
+      m_dropped (0)
+  {
+  }
 };
 /**
  * \ingroup aodvKmeans
  * \brief aodvKmeans route request queue
  *
  * Since aodvKmeans is an on demand routing we queue requests while looking for route.
+ *
+ * By default the queue is a single "drop-front" queue.  In QUEUE_FAIR mode packets
+ * are grouped into flows (by destination or by 5-tuple) and into priority classes
+ * (by DSCP).  When the queue is full the oldest packet of the longest flow in the
+ * lowest priority class is dropped, so one chatty flow can not evict the packets of
+ * short flows, and packets of a destination are drained by priority class and then
+ * deficit round robin among its flows.
+ *
+ * The sojourn time of every packet leaving the queue, dequeued or dropped, is
+ * reported to an optional callback, and SampleOccupancy () records the queue
+ * length and the departures since the previous sample in a ring buffer.
  */
 class RequestQueue
 {
 public:
+  /**
+   * TracedCallback signature for queue drops.
+   *
+   * \param [in] packet the dropped packet
+   * \param [in] header the IPv4 header of the dropped packet
+   * \param [in] reason the reason of the drop
+   * \param [in] priorityClass the priority class of the dropped packet
+   */
+  typedef void (* DropTracedCallback)(Ptr<const Packet> packet, const Ipv4Header & header,
+                                      std::string reason, uint8_t priorityClass);
+  /// Drop notification callback typedef
+  typedef Callback<void, Ptr<const Packet>, const Ipv4Header &, std::string, uint8_t> DropCallback;
+  /**
+   * TracedCallback signature for packets leaving the queue.
+   *
+   * \param [in] packet the packet
+   * \param [in] header its IPv4 header
+   * \param [in] sojourn the time it spent in the queue
+   * \param [in] dropped true if dropped, false if dequeued
+   */
+  typedef void (* SojournTracedCallback)(Ptr<const Packet> packet, const Ipv4Header & header,
+                                         Time sojourn, bool dropped);
+  /// Departure notification callback typedef
+  typedef Callback<void, Ptr<const Packet>, const Ipv4Header &, Time, bool> SojournCallback;
+  /**
+   * TracedCallback signature for occupancy samples.
+   *
+   * \param [in] sample the sample
+   */
+  typedef void (* SampleTracedCallback)(const QueueSample & sample);
+
   /**
    * constructor
    *
@@ -188,7 +407,13 @@ public:
    */
   RequestQueue (uint32_t maxLen, Time routeToQueueTimeout)
     : m_maxLen (maxLen),
-      m_queueTimeout (routeToQueueTimeout)
+      m_queueTimeout (routeToQueueTimeout),
+      m_scheduling (QUEUE_FIFO),
+      m_flowKey (FLOW_BY_DESTINATION),
+      m_flowQuota (0),
+      m_quantum (1500),
+      m_dequeuedSinceSample (0),
+      m_droppedSinceSample (0)
   {
   }
   /**
@@ -260,22 +485,210 @@ public:
   {
     m_queueTimeout = t;
   }
+  /**
+   * Get the scheduling discipline
+   * \returns the scheduling discipline
+   */
+  QueueScheduling GetScheduling () const
+  {
+    return m_scheduling;
+  }
+  /**
+   * Set the scheduling discipline
+   * \param s the scheduling discipline
+   */
+  void SetScheduling (QueueScheduling s)
+  {
+    m_scheduling = s;
+  }
+  /**
+   * Get the flow classification used in QUEUE_FAIR mode
+   * \returns the flow key
+   */
+  QueueFlowKey GetFlowKey () const
+  {
+    return m_flowKey;
+  }
+  /**
+   * Set the flow classification used in QUEUE_FAIR mode
+   * \param k the flow key
+   */
+  void SetFlowKey (QueueFlowKey k)
+  {
+    m_flowKey = k;
+  }
+  /**
+   * Get the maximum number of packets a single flow may hold (0 means no quota)
+   * \returns the per-flow quota
+   */
+  uint32_t GetFlowQuota () const
+  {
+    return m_flowQuota;
+  }
+  /**
+   * Set the maximum number of packets a single flow may hold (0 means no quota)
+   * \param quota the per-flow quota
+   */
+  void SetFlowQuota (uint32_t quota)
+  {
+    m_flowQuota = quota;
+  }
+  /**
+   * Get the deficit round robin quantum
+   * \returns the quantum in bytes
+   */
+  uint32_t GetQuantum () const
+  {
+    return m_quantum;
+  }
+  /**
+   * Set the deficit round robin quantum
+   * \param quantum the quantum in bytes, positive
+   */
+  void SetQuantum (uint32_t quantum)
+  {
+    NS_ASSERT_MSG (quantum > 0, "A null quantum never lets a flow dequeue");
+    m_quantum = quantum;
+  }
+  /**
+   * Set the callback notified of every dropped packet
+   * \param cb the drop callback
+   */
+  void SetDropCallback (DropCallback cb)
+  {
+    m_dropCallback = cb;
+  }
+  /**
+   * Set the callback notified of every packet leaving the queue
+   * \param cb the departure callback
+   */
+  void SetSojournCallback (SojournCallback cb)
+  {
+    m_sojournCallback = cb;
+  }
+  /**
+   * Record the queue length and the departures since the previous sample
+   * \returns the sample
+   */
+  QueueSample SampleOccupancy ();
+  /**
+   * \returns the most recent occupancy samples
+   */
+  RingBuffer<QueueSample> const & GetSamples () const
+  {
+    return m_samples;
+  }
+  /**
+   * Set the number of occupancy samples kept, removing all samples
+   * \param capacity the number of samples
+   */
+  void SetSampleCapacity (uint32_t capacity)
+  {
+    m_samples.SetCapacity (capacity);
+  }
+  /**
+   * Print the header line of CSV occupancy reports
+   * \param os the output stream
+   */
+  static void PrintSamplesHeader (std::ostream & os);
+  /**
+   * Print the occupancy samples as CSV lines, oldest first
+   * \param os the output stream
+   * \param node the id of the node
+   */
+  void PrintSamples (std::ostream & os, uint32_t node) const;
+  /**
+   * \returns the estimated memory held by the queue, its flows and samples, bytes
+   */
+  uint64_t GetMemoryBytes () const;
+  /**
+   * \returns the size of the queued packets, bytes
+   */
+  uint64_t GetPacketBytes () const;
+  /**
+   * Map a DSCP value to a priority class
+   * \param dscp the DSCP of the packet
+   * \returns the priority class
+   */
+  static uint8_t GetPriorityClass (Ipv4Header::DscpType dscp);
 
 private:
   /// The queue
   std::vector<QueueEntry> m_queue;
   /// Remove all expired entries
   void Purge ();
+  /**
+   * Classify entry into its flow and priority class
+   * \param entry the queue entry
+   */
+  void Classify (QueueEntry & entry) const;
+  /**
+   * Count queued packets of a flow
+   * \param flow the flow id
+   * \returns the number of packets queued for the flow
+   */
+  uint32_t GetFlowSize (QueueFlowId const & flow) const;
+  /**
+   * Drop the oldest packet of a flow
+   * \param flow the flow id
+   * \param reason the reason to drop the entry
+   */
+  void DropFlowHead (QueueFlowId const & flow, std::string reason);
+  /// Forget the active flows whose last packet left the queue (QUEUE_FAIR mode)
+  void ForgetDrainedFlows ();
+  /**
+   * Make room for entry in a full queue (QUEUE_FAIR mode)
+   * \param entry the queue entry to be added
+   * \returns false if entry itself must be dropped
+   */
+  bool MakeRoom (QueueEntry const & entry);
+  /**
+   * Deficit round robin dequeue for given destination (QUEUE_FAIR mode)
+   * \param dst the destination IP address
+   * \param entry the queue entry
+   * \returns true if the entry is dequeued
+   */
+  bool DequeueFair (Ipv4Address dst, QueueEntry & entry);
   /**
    * Notify that packet is dropped from queue by timeout
    * \param en the queue entry to drop
    * \param reason the reason to drop the entry
    */
   void Drop (QueueEntry en, std::string reason);
+  /**
+   * Account for a packet leaving the queue
+   * \param en the queue entry
+   * \param dropped true if dropped, false if dequeued
+   */
+  void NotifyDeparture (QueueEntry const & en, bool dropped);
   /// The maximum number of packets that we allow a routing protocol to buffer.
   uint32_t m_maxLen;
   /// The maximum period of time that a routing protocol is allowed to buffer a packet for, seconds.
   Time m_queueTimeout;
+  /// Scheduling discipline
+  QueueScheduling m_scheduling;
+  /// Flow classification in QUEUE_FAIR mode
+  QueueFlowKey m_flowKey;
+  /// Maximum number of packets per flow in QUEUE_FAIR mode, 0 for none
+  uint32_t m_flowQuota;
+  /// Deficit round robin quantum, bytes
+  uint32_t m_quantum;
+  /// Flows with queued packets, in round robin order
+  std::list<QueueFlowId> m_activeFlows;
+  /// Deficit counter of each active flow
+  std::map<QueueFlowId, uint32_t> m_deficit;
+  /// Drop notification
+  DropCallback m_dropCallback;
+  /// Departure notification
+  SojournCallback m_sojournCallback;
+  /// Most recent occupancy samples
+  RingBuffer<QueueSample> m_samples;
+  /// Packets dequeued since the previous sample
+  uint32_t m_dequeuedSinceSample;
+  /// Packets dropped since the previous sample
+  uint32_t m_droppedSinceSample;
+  /// Total sojourn time of the packets that left since the previous sample
+  Time m_sojournSinceSample;
 };
 
 
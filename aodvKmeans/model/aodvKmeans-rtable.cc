@@ -27,8 +27,11 @@
  */
 
 #include "aodvKmeans-rtable.h"
+#include "aodvKmeans-profiler.h"
+#include "aodvKmeans-memory-usage.h"
 #include <algorithm>
 #include <iomanip>
+#include <cmath>
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 
@@ -44,7 +47,7 @@ namespace aodvKmeans {
 
 RoutingTableEntry::RoutingTableEntry (Ptr<NetDevice> dev, Ipv4Address dst, bool vSeqNo, uint32_t seqNo,
                                       Ipv4InterfaceAddress iface, uint16_t hops, Ipv4Address nextHop, Time lifetime,
-                                      uint32_t txError, uint32_t positionX, uint32_t positionY, uint32_t freeSpace)
+                                      uint32_t txError, double positionX, double positionY, uint32_t freeSpace)
   : m_ackTimer (Timer::CANCEL_ON_DESTROY),
     m_validSeqNo (vSeqNo),
     m_seqNo (seqNo),
@@ -58,7 +61,15 @@ RoutingTableEntry::RoutingTableEntry (Ptr<NetDevice> dev, Ipv4Address dst, bool
     m_txerrorCount(txError),
     m_positionX(positionX),
     m_positionY(positionY),
-    m_freeSpace(freeSpace)
+    m_hasPosition (true),
+    m_velocity (),
+    m_positionTime (Simulator::Now ()),
+    m_freeSpace(freeSpace),
+    m_macQueue (0),
+    m_channelBusy (0),
+    m_hasChannelLoad (false),
+    m_snr (0),
+    m_hasSnr (false)
 {
   m_ipv4Route = Create<Ipv4Route> ();
   m_ipv4Route->SetDestination (dst);
@@ -71,6 +82,14 @@ RoutingTableEntry::~RoutingTableEntry ()
 {
 }
 
+Vector
+RoutingTableEntry::GetExtrapolatedPosition (Time maxAge) const
+{
+  Time age = std::min (std::max (Simulator::Now () - m_positionTime, Seconds (0)), maxAge);
+  double t = age.GetSeconds ();
+  return Vector (m_positionX + m_velocity.x * t, m_positionY + m_velocity.y * t, 0);
+}
+
 bool
 RoutingTableEntry::InsertPrecursor (Ipv4Address id)
 {
@@ -135,6 +154,12 @@ RoutingTableEntry::IsPrecursorListEmpty () const
   return m_precursorList.empty ();
 }
 
+uint64_t
+RoutingTableEntry::GetPrecursorMemoryBytes () const
+{
+  return MemoryBytes (m_precursorList);
+}
+
 void
 RoutingTableEntry::GetPrecursors (std::vector<Ipv4Address> & prec) const
 {
@@ -224,10 +249,22 @@ RoutingTableEntry::Print (Ptr<OutputStreamWrapper> stream, Time::Unit unit /* =
  */
 
 RoutingTable::RoutingTable (Time t)
-  : m_badLinkLifetime (t)
+  : m_badLinkLifetime (t),
+    m_maxExtrapolation (Seconds (0)),
+    m_random (CreateObject<UniformRandomVariable> ()),
+    m_events (0)
 {
 }
 
+void
+RoutingTable::NotifyChange (RoutingTableEntry const & rt, bool valid)
+{
+  if (!m_changeCallback.IsNull ())
+    {
+      m_changeCallback (rt, valid);
+    }
+}
+
 bool
 RoutingTable::LookupRoute (Ipv4Address id, RoutingTableEntry & rt)
 {
@@ -263,14 +300,44 @@ RoutingTable::LookupValidRoute (Ipv4Address id, RoutingTableEntry & rt)
   return (rt.GetFlag () == VALID);
 }
 
+void
+RoutingTable::CancelAckTimer (RoutingTableEntry & rt)
+{
+  if (rt.m_ackTimer.IsRunning ())
+    {
+      rt.m_ackTimer.Cancel ();
+      if (m_events != 0)
+        {
+          m_events->Cancelled (EventAccounting::EVENT_ACK_TIMER);
+        }
+    }
+}
+
+void
+RoutingTable::Clear ()
+{
+  for (std::map<Ipv4Address, RoutingTableEntry>::iterator i = m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); ++i)
+    {
+      CancelAckTimer (i->second);
+    }
+  m_ipv4AddressEntry.clear ();
+}
+
 bool
 RoutingTable::DeleteRoute (Ipv4Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
   Purge ();
-  if (m_ipv4AddressEntry.erase (dst) != 0)
+  std::map<Ipv4Address, RoutingTableEntry>::iterator i = m_ipv4AddressEntry.find (dst);
+  if (i != m_ipv4AddressEntry.end ())
     {
       NS_LOG_LOGIC ("Route deletion to " << dst << " successful");
+      if (i->second.GetFlag () == VALID)
+        {
+          NotifyChange (i->second, false);
+        }
+      CancelAckTimer (i->second);
+      m_ipv4AddressEntry.erase (i);
       return true;
     }
   NS_LOG_LOGIC ("Route deletion to " << dst << " not successful");
@@ -288,6 +355,10 @@ RoutingTable::AddRoute (RoutingTableEntry & rt)
     }
   std::pair<std::map<Ipv4Address, RoutingTableEntry>::iterator, bool> result =
     m_ipv4AddressEntry.insert (std::make_pair (rt.GetDestination (), rt));
+  if (result.second && rt.GetFlag () == VALID)
+    {
+      NotifyChange (rt, true);
+    }
   return result.second;
 }
 
@@ -302,7 +373,17 @@ RoutingTable::Update (RoutingTableEntry & rt)
       NS_LOG_LOGIC ("Route update to " << rt.GetDestination () << " fails; not found");
       return false;
     }
+  bool wasValid = (i->second.GetFlag () == VALID);
+  Ipv4Address oldNextHop = i->second.GetNextHop ();
   i->second = rt;
+  if (rt.GetFlag () == VALID && (!wasValid || oldNextHop != rt.GetNextHop ()))
+    {
+      NotifyChange (rt, true);
+    }
+  else if (wasValid && rt.GetFlag () != VALID)
+    {
+      NotifyChange (rt, false);
+    }
   if (i->second.GetFlag () != IN_SEARCH)
     {
       NS_LOG_LOGIC ("Route update to " << rt.GetDestination () << " set RreqCnt to 0");
@@ -322,8 +403,13 @@ RoutingTable::SetEntryState (Ipv4Address id, RouteFlags state)
       NS_LOG_LOGIC ("Route set entry state to " << id << " fails; not found");
       return false;
     }
+  bool wasValid = (i->second.GetFlag () == VALID);
   i->second.SetFlag (state);
   i->second.SetRreqCnt (0);
+  if (wasValid != (state == VALID))
+    {
+      NotifyChange (i->second, state == VALID);
+    }
   NS_LOG_LOGIC ("Route set entry state to " << id << ": new state is " << state);
   return true;
 }
@@ -360,6 +446,7 @@ RoutingTable::InvalidateRoutesWithDst (const std::map<Ipv4Address, uint32_t> & u
             {
               NS_LOG_LOGIC ("Invalidate route with destination address " << i->first);
               i->second.Invalidate (m_badLinkLifetime);
+              NotifyChange (i->second, false);
             }
         }
     }
@@ -378,6 +465,11 @@ RoutingTable::DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface)
     {
       if (i->second.GetInterface () == iface)
         {
+          if (i->second.GetFlag () == VALID)
+            {
+              NotifyChange (i->second, false);
+            }
+          CancelAckTimer (i->second);
           std::map<Ipv4Address, RoutingTableEntry>::iterator tmp = i;
           ++i;
           m_ipv4AddressEntry.erase (tmp);
@@ -388,213 +480,284 @@ RoutingTable::DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface)
         }
     }
 }
-std::vector<Ipv4Address> 
-RoutingTable::Kmeans (Ipv4Address dst, uint32_t positionX, uint32_t positionY)
+/**
+ * Squared euclidean distance between two points of the feature space
+ * \param a the first point
+ * \param b the second point
+ * \returns the squared distance
+ */
+static double
+SquaredDistance (std::vector<double> const & a, std::vector<double> const & b)
 {
-    Purge();
-  
-    /// features list
-    int n = m_ipv4AddressEntry.size();
-    double features[n][3];
-    int k = 2;
-    double cluster_center[k][3];
-    int cluster_assignments[n];
-
-  
-    int i = 0;
-    
-    for (std::map<Ipv4Address, RoutingTableEntry>::iterator it = m_ipv4AddressEntry.begin (); it != m_ipv4AddressEntry.end (); ++it)
+  double dist = 0.0;
+  for (uint32_t d = 0; d < a.size (); d++)
     {
-      if(it->first.IsBroadcast() || it->first.IsLocalhost() || it->first.IsMulticast() || 
-      it->first.IsSubnetDirectedBroadcast(Ipv4Mask((char *)"255.255.255.0")) || it->second.GetFlag() == INVALID || it->second.GetHop() > 2)
-      {
-        continue;
-      }
-      features[i][0] = 1.0 * (positionX - it->second.GetPositionX()) * (positionX - it->second.GetPositionX()) + 
-                      1.0 * (positionY - it->second.GetPositionY()) * (positionY - it->second.GetPositionY());
-                    
-      features[i][1] = 1.0 * it->second.GetTxErrorCount();
-      features[i][2] = 1.0 * it->second.GetFreeSpace();
-      i++;
+      dist += (a[d] - b[d]) * (a[d] - b[d]);
     }
-    
-    n = i;
-
-    double mini[3], maxi[3];
-
-    // normalize the features
-    for(int j=0;j<3;j++)
-    {
-      mini[j] = features[0][j];
-      maxi[j] = features[0][j];
-      for(int i=1;i<n;i++)
-      {
-        mini[j] = std::min(mini[j], features[i][j]);
-        maxi[j]= std::max(maxi[j], features[i][j]);
-      }
-
-      for(int i=0;i<n;i++)
-      {
-        features[i][j] = (features[i][j] - mini[j]);
-        if(mini[j] != maxi[j]) features[i][j]/= (maxi[j] - mini[j]);
-      }
-
-    }
-    
-
-    // define an idea feature list
-    double ideal[3];
-    ideal[0] = 0.0; // minimum possible distance
-    ideal[1] = 0.0; // minimum possible error
-    ideal[2] = maxi[2]; // buffer empty
-    
+  return dist;
+}
 
-    // randomly pick k cluster heads
-    srand(time(0));
-    for(int i=0;i<k;i++)
+double
+RoutingTable::Cluster (std::vector<std::vector<double> > const & features, uint32_t k,
+                       std::vector<std::vector<double> > & centers, std::vector<uint32_t> & assignments,
+                       uint32_t & iterations)
+{
+  uint32_t n = features.size ();
+  uint32_t dimension = features[0].size ();
+  // randomly pick k cluster heads
+  centers.resize (k);
+  for (uint32_t j = 0; j < k; j++)
     {
-      int p = rand() % n;
-      for(int j=0;j<3;j++)
-      {
-        cluster_center[i][j] = features[p][j];
-      }
+      centers[j] = features[m_random->GetInteger (0, n - 1)];
     }
+  assignments.assign (n, 0);
 
-    int num_iterations = 3;
-    // run iterations
-    for(int iteration=0;iteration<=num_iterations;iteration++)
+  double inertia = 0;
+  int num_iterations = 3;
+  iterations = 0;
+  for (int iteration = 0; iteration <= num_iterations; iteration++)
     {
-      
       // assign clusters
-
-      for(int i=0;i<n;i++)
-      {
+      inertia = 0;
+      bool changed = false;
+      for (uint32_t i = 0; i < n; i++)
+        {
           double mini_dist = -1.0;
-          for(int j=0;j<k;j++)
-          {
-            double dist = 0.0;
-            for(int d=0; d<3; d++)
-            {
-              dist += (features[i][d] - cluster_center[j][d]) * (features[i][d] - cluster_center[j][d]);
-               
-            }
-            if(mini_dist == -1.0 || dist < mini_dist)
+          uint32_t previous = assignments[i];
+          for (uint32_t j = 0; j < k; j++)
             {
-              mini_dist = dist;
-              cluster_assignments[i] = j;
+              double dist = SquaredDistance (features[i], centers[j]);
+              if (mini_dist == -1.0 || dist < mini_dist)
+                {
+                  mini_dist = dist;
+                  assignments[i] = j;
+                }
             }
-          }
-          
-      }
-
-      if(iteration == num_iterations) 
-      {
-        break;
-      }
+          changed = changed || assignments[i] != previous;
+          inertia += mini_dist;
+        }
+      if (iteration > 0 && !changed && iterations == 0)
+        {
+          iterations = iteration;
+        }
+      if (iteration == num_iterations)
+        {
+          break;
+        }
 
       // re-position cluster centers
-      
-      for(int j=0;j<k;j++)
-      {
-        int cnt = 0;
-        for(int d=0;d<3;d++)
+      for (uint32_t j = 0; j < k; j++)
         {
-          cluster_center[j][d] = 0.0;
+          std::vector<double> sum (dimension, 0.0);
+          uint32_t cnt = 0;
+          for (uint32_t i = 0; i < n; i++)
+            {
+              if (assignments[i] == j)
+                {
+                  for (uint32_t d = 0; d < dimension; d++)
+                    {
+                      sum[d] += features[i][d];
+                    }
+                  cnt++;
+                }
+            }
+          if (cnt)
+            {
+              for (uint32_t d = 0; d < dimension; d++)
+                {
+                  sum[d] /= cnt;
+                }
+              centers[j] = sum;
+            }
+          else
+            {
+              centers[j] = features[m_random->GetInteger (0, n - 1)];
+            }
         }
+    }
+  return inertia;
+}
 
+std::vector<Ipv4Address>
+RoutingTable::Kmeans (Ipv4Address dst, double positionX, double positionY,
+                      KmeansParameters const & parameters,
+                      Callback<double, Ipv4Address> linkTxError, KmeansQuality * quality)
+{
+  AODVKMEANS_PROFILE (PROBE_KMEANS);
+  Purge ();
 
-        for(int i=0;i<n;i++)
+  std::vector<Ipv4Address> candidates;
+  std::vector<std::vector<double> > raw;
+  std::vector<uint32_t> unknownSnr;
+  double snrSum = 0;
+  std::vector<uint32_t> unknownPosition;
+  double distanceSum = 0;
+  std::vector<uint32_t> unknownLoad;
+  double macQueueSum = 0;
+  double channelBusySum = 0;
+  for (std::map<Ipv4Address, RoutingTableEntry>::iterator it = m_ipv4AddressEntry.begin (); it != m_ipv4AddressEntry.end (); ++it)
+    {
+      if (it->first.IsBroadcast () || it->first.IsLocalhost () || it->first.IsMulticast ()
+          || it->first.IsSubnetDirectedBroadcast (Ipv4Mask ((char *)"255.255.255.0")) || it->second.GetFlag () == INVALID || it->second.GetHop () > 2)
         {
-          if(cluster_assignments[i] == j)
-          {
-            for(int d=0;d<3;d++)
-            {
-              cluster_center[j][d] += features[i][d];
-              
-            }
-            
-            cnt++;
-          }
-          
+          continue;
         }
-        if(cnt)
+      std::vector<double> feature (FeatureSpace::FEATURE_COUNT);
+      if (it->second.HasPosition ())
         {
-          for(int d=0;d<3;d++)
-          {
-            cluster_center[j][d] /= cnt;
-          }
+          Vector position = it->second.GetExtrapolatedPosition (m_maxExtrapolation);
+          feature[FeatureSpace::FEATURE_DISTANCE] = (positionX - position.x) * (positionX - position.x)
+            + (positionY - position.y) * (positionY - position.y);
+          distanceSum += feature[FeatureSpace::FEATURE_DISTANCE];
         }
-        else 
+      else
         {
-          int p = rand() % n;
-          for(int d=0;d<3;d++)
-          {
-            cluster_center[j][d] = features[p][d];
-          }
+          unknownPosition.push_back (raw.size ());
         }
-
-        
-      }
-      
-
+      feature[FeatureSpace::FEATURE_TX_ERROR] = 1.0 * it->second.GetTxErrorCount ();
+      if (!linkTxError.IsNull ())
+        {
+          feature[FeatureSpace::FEATURE_TX_ERROR] += linkTxError (it->second.GetNextHop ());
+        }
+      feature[FeatureSpace::FEATURE_FREE_SPACE] = 1.0 * it->second.GetFreeSpace ();
+      if (it->second.HasChannelLoad ())
+        {
+          feature[FeatureSpace::FEATURE_MAC_QUEUE] = it->second.GetMacQueueOccupancy ();
+          feature[FeatureSpace::FEATURE_CHANNEL_BUSY] = it->second.GetChannelBusy ();
+          macQueueSum += it->second.GetMacQueueOccupancy ();
+          channelBusySum += it->second.GetChannelBusy ();
+        }
+      else
+        {
+          unknownLoad.push_back (raw.size ());
+        }
+      // the SNR is measured on the link to the neighbor the candidate is reached through
+      std::map<Ipv4Address, RoutingTableEntry>::const_iterator nextHop = m_ipv4AddressEntry.find (it->second.GetNextHop ());
+      if (nextHop != m_ipv4AddressEntry.end () && nextHop->second.HasSnr ())
+        {
+          feature[FeatureSpace::FEATURE_SNR] = nextHop->second.GetSnr ();
+          snrSum += nextHop->second.GetSnr ();
+        }
+      else
+        {
+          unknownSnr.push_back (raw.size ());
+        }
+      candidates.push_back (it->first);
+      raw.push_back (feature);
     }
-
-
-    // de-normalize cluster centers
-    
-    for(int j=0;j<k;j++)
+  // links never measured count as average ones
+  for (std::vector<uint32_t>::const_iterator i = unknownSnr.begin (); i != unknownSnr.end (); ++i)
     {
-      for(int d=0;d<3;d++)
-      {
-        cluster_center[j][d] *= (maxi[d] - mini[d]);
-        cluster_center[j][d] += mini[d];
-      }
+      raw[*i][FeatureSpace::FEATURE_SNR] = unknownSnr.size () < raw.size () ? snrSum / (raw.size () - unknownSnr.size ()) : 0;
     }
-    for(int i=0;i<n;i++)
+  // as do candidates at unknown positions
+  for (std::vector<uint32_t>::const_iterator i = unknownPosition.begin (); i != unknownPosition.end (); ++i)
     {
-      for(int d=0;d<3;d++)
-      {
-        features[i][d] *= (maxi[d] - mini[d]);
-        features[i][d] += mini[d];
-      }
+      raw[*i][FeatureSpace::FEATURE_DISTANCE] = unknownPosition.size () < raw.size () ? distanceSum / (raw.size () - unknownPosition.size ()) : 0;
+    }
+  // and candidates that never advertised their channel load
+  for (std::vector<uint32_t>::const_iterator i = unknownLoad.begin (); i != unknownLoad.end (); ++i)
+    {
+      uint32_t known = raw.size () - unknownLoad.size ();
+      raw[*i][FeatureSpace::FEATURE_MAC_QUEUE] = known > 0 ? macQueueSum / known : 0;
+      raw[*i][FeatureSpace::FEATURE_CHANNEL_BUSY] = known > 0 ? channelBusySum / known : 0;
     }
 
-    // select optimal cluster
-    int optimal_cluster = -1;
-    double mini_dist = -1.0;
-    for(int j=0;j<k;j++)
+  std::vector<Ipv4Address> selectedCluster;
+  uint32_t n = raw.size ();
+  if (quality != 0)
     {
-      double dist = 0;
-      for(int d=0; d<3; d++)
-      {
-          dist += (cluster_center[j][d] - ideal[d]) * (cluster_center[j][d] - ideal[d]); 
-      }
-      if(mini_dist == -1.0 || dist < mini_dist)
-      {
-        mini_dist = dist;
-        optimal_cluster = j;
-      }
+      *quality = KmeansQuality ();
+      quality->m_candidates = n;
+    }
+  if (n == 0)
+    {
+      return selectedCluster;
+    }
 
+  // normalize and weigh the features, and place the ideal forwarder in the same space
+  std::vector<std::vector<double> > features;
+  std::vector<double> ideal;
+  parameters.m_featureSpace.Project (raw, features, ideal);
+
+  std::vector<std::vector<double> > centers;
+  std::vector<uint32_t> assignments;
+  uint32_t k = 1;
+  double inertia = 0;
+  uint32_t iterations = 0;
+  switch (parameters.m_clusterCount)
+    {
+    case KMEANS_K_FIXED:
+      k = std::max<uint32_t> (1, std::min (parameters.m_clusters, n));
+      inertia = Cluster (features, k, centers, assignments, iterations);
+      break;
+    case KMEANS_K_TARGET:
+      k = (n + std::max<uint32_t> (1, parameters.m_targetForwarders) - 1) / std::max<uint32_t> (1, parameters.m_targetForwarders);
+      k = std::max<uint32_t> (1, std::min (std::min (k, parameters.m_maxClusters), n));
+      inertia = Cluster (features, k, centers, assignments, iterations);
+      break;
+    case KMEANS_K_ELBOW:
+      // stop adding clusters once one more no longer reduces the inertia enough
+      inertia = Cluster (features, 1, centers, assignments, iterations);
+      while (k < std::min (parameters.m_maxClusters, n) && inertia > 0)
+        {
+          std::vector<std::vector<double> > nextCenters;
+          std::vector<uint32_t> nextAssignments;
+          uint32_t nextIterations = 0;
+          double next = Cluster (features, k + 1, nextCenters, nextAssignments, nextIterations);
+          if ((inertia - next) / inertia < parameters.m_minInertiaDrop)
+            {
+              break;
+            }
+          k++;
+          inertia = next;
+          iterations = nextIterations;
+          centers.swap (nextCenters);
+          assignments.swap (nextAssignments);
+        }
+      break;
     }
 
-    std::vector<Ipv4Address>selectedCluster;
-    i=0;
-    for (std::map<Ipv4Address, RoutingTableEntry>::iterator it = m_ipv4AddressEntry.begin (); it != m_ipv4AddressEntry.end (); ++it)
+  // select the cluster whose center is closest to the ideal forwarder
+  uint32_t optimal_cluster = 0;
+  double mini_dist = -1.0;
+  for (uint32_t j = 0; j < k; j++)
     {
-      if(it->first.IsBroadcast() || it->first.IsLocalhost() || it->first.IsMulticast() || 
-      it->first.IsSubnetDirectedBroadcast(Ipv4Mask((char *)"255.255.255.0")) || it->second.GetFlag() == INVALID || it->second.GetHop() > 2)
-      {
-        continue;
-      }
-      if(cluster_assignments[i] == optimal_cluster)
-      {
-        selectedCluster.push_back(it->first);
-      }
-      i++;
+      double dist = SquaredDistance (centers[j], ideal);
+      if (mini_dist == -1.0 || dist < mini_dist)
+        {
+          mini_dist = dist;
+          optimal_cluster = j;
+        }
+    }
+  if (quality != 0)
+    {
+      quality->m_clusters = k;
+      quality->m_inertia = inertia;
+      quality->m_idealDistance = std::sqrt (mini_dist);
+      quality->m_iterations = iterations;
     }
-    
-    return selectedCluster;
 
+  std::vector<std::pair<double, Ipv4Address> > members;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (assignments[i] == optimal_cluster)
+        {
+          members.push_back (std::make_pair (SquaredDistance (features[i], ideal), candidates[i]));
+        }
+    }
+  // keep the airtime of the unicast RREQs within budget, best candidates first
+  if (parameters.m_maxForwarders > 0 && members.size () > parameters.m_maxForwarders)
+    {
+      std::partial_sort (members.begin (), members.begin () + parameters.m_maxForwarders, members.end ());
+      members.resize (parameters.m_maxForwarders);
+    }
+  for (uint32_t i = 0; i < members.size (); i++)
+    {
+      selectedCluster.push_back (members[i].second);
+    }
+  NS_LOG_LOGIC ("Selected " << selectedCluster.size () << " of " << n << " candidates in " << k << " clusters");
+  return selectedCluster;
 }
 
 
@@ -602,6 +765,7 @@ void
 RoutingTable::Purge ()
 {
   NS_LOG_FUNCTION (this);
+  AODVKMEANS_PROFILE (PROBE_PURGE);
   if (m_ipv4AddressEntry.empty ())
     {
       return;
@@ -613,6 +777,7 @@ RoutingTable::Purge ()
         {
           if (i->second.GetFlag () == INVALID)
             {
+              CancelAckTimer (i->second);
               std::map<Ipv4Address, RoutingTableEntry>::iterator tmp = i;
               ++i;
               m_ipv4AddressEntry.erase (tmp);
@@ -621,6 +786,7 @@ RoutingTable::Purge ()
             {
               NS_LOG_LOGIC ("Invalidate route with destination address " << i->first);
               i->second.Invalidate (m_badLinkLifetime);
+              NotifyChange (i->second, false);
               ++i;
             }
           else
@@ -716,5 +882,32 @@ RoutingTable::Print (Ptr<OutputStreamWrapper> stream, Time::Unit unit /* = Time:
   *stream->GetStream () << "\n";
 }
 
+uint64_t
+RoutingTable::GetMemoryBytes () const
+{
+  uint64_t bytes = MemoryBytes (m_ipv4AddressEntry);
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = m_ipv4AddressEntry.begin ();
+       i != m_ipv4AddressEntry.end (); ++i)
+    {
+      if (i->second.GetRoute () != 0)
+        {
+          bytes += sizeof (Ipv4Route);
+        }
+    }
+  return bytes;
+}
+
+uint64_t
+RoutingTable::GetPrecursorMemoryBytes () const
+{
+  uint64_t bytes = 0;
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = m_ipv4AddressEntry.begin ();
+       i != m_ipv4AddressEntry.end (); ++i)
+    {
+      bytes += i->second.GetPrecursorMemoryBytes ();
+    }
+  return bytes;
+}
+
 }
 }
@@ -31,12 +31,18 @@
 #include <stdint.h>
 #include <cassert>
 #include <map>
+#include <vector>
 #include <sys/types.h>
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/timer.h"
+#include "ns3/callback.h"
 #include "ns3/net-device.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/vector.h"
+#include "ns3/random-variable-stream.h"
+#include "aodvKmeans-feature-space.h"
+#include "aodvKmeans-event-accounting.h"
 
 namespace ns3 {
 namespace aodvKmeans {
@@ -52,6 +58,74 @@ enum RouteFlags
   IN_SEARCH = 2,      //!< IN_SEARCH
 };
 
+/**
+ * \ingroup aodvKmeans
+ * \brief How the number of clusters of forwarder selection is chosen
+ */
+enum KmeansClusterCount
+{
+  KMEANS_K_FIXED = 0,   //!< always the configured number of clusters
+  KMEANS_K_TARGET = 1,  //!< enough clusters for the target number of forwarders per cluster
+  KMEANS_K_ELBOW = 2,   //!< add clusters while they reduce the inertia enough
+};
+
+/**
+ * \ingroup aodvKmeans
+ * \brief Parameters of the clustering of forwarder candidates
+ */
+struct KmeansParameters
+{
+  /// How the number of clusters is chosen
+  KmeansClusterCount m_clusterCount;
+  /// Number of clusters with KMEANS_K_FIXED
+  uint32_t m_clusters;
+  /// Largest number of clusters with KMEANS_K_TARGET and KMEANS_K_ELBOW
+  uint32_t m_maxClusters;
+  /// Forwarders per cluster aimed at with KMEANS_K_TARGET
+  uint32_t m_targetForwarders;
+  /// Smallest relative inertia reduction worth one more cluster with KMEANS_K_ELBOW
+  double m_minInertiaDrop;
+  /// Largest number of selected forwarders, 0 for no limit
+  uint32_t m_maxForwarders;
+  /// Features the candidates are clustered on, and the ideal forwarder
+  FeatureSpace m_featureSpace;
+  KmeansParameters ()
+    : m_clusterCount (KMEANS_K_FIXED),
+      m_clusters (2),
+      m_maxClusters (8),
+      m_targetForwarders (4),
+      m_minInertiaDrop (0.3),
+      m_maxForwarders (0)
+  {
+  }
+};
+
+/**
+ * \ingroup aodvKmeans
+ * \brief Quality of a forwarder selection by K-means
+ */
+struct KmeansQuality
+{
+  /// Number of forwarder candidates
+  uint32_t m_candidates;
+  /// Number of clusters
+  uint32_t m_clusters;
+  /// Sum of the squared distances of the candidates to their cluster center, in the feature space
+  double m_inertia;
+  /// Distance of the center of the selected cluster to the ideal forwarder, in the feature space
+  double m_idealDistance;
+  /// Iterations after which the clusters no longer changed, 0 if they still changed at the last one
+  uint32_t m_iterations;
+  KmeansQuality ()
+    : m_candidates (0),
+      m_clusters (0),
+      m_inertia (0),
+      m_idealDistance (0),
+      m_iterations (0)
+  {
+  }
+};
+
 /**
  * \ingroup aodvKmeans
  * \brief Routing table entry
@@ -75,7 +149,7 @@ public:
   RoutingTableEntry (Ptr<NetDevice> dev = 0,Ipv4Address dst = Ipv4Address (), bool vSeqNo = false, uint32_t seqNo = 0,
                      Ipv4InterfaceAddress iface = Ipv4InterfaceAddress (), uint16_t  hops = 0,
                      Ipv4Address nextHop = Ipv4Address (), Time lifetime = Simulator::Now (), 
-                     uint32_t txError = 0, uint32_t positionX = 0, uint32_t positionY = 0, uint32_t freeSpace=0);
+                     uint32_t txError = 0, double positionX = 0, double positionY = 0, uint32_t freeSpace=0);
 
   ~RoutingTableEntry ();
 
@@ -111,6 +185,10 @@ public:
    * \param prec vector of precursor addresses
    */
   void GetPrecursors (std::vector<Ipv4Address> & prec) const;
+  /**
+   * \returns the memory held by the precursor list, bytes
+   */
+  uint64_t GetPrecursorMemoryBytes () const;
   //\}
 
   /**
@@ -328,35 +406,119 @@ public:
     return m_blackListTimeout;
   }
   /**
-   * Set the positionx
+   * Set the positionx, the position is then known
    * \param positionX the positionX
    */
-  void SetPositionX (uint32_t positionX)
+  void SetPositionX (double positionX)
   {
     m_positionX = positionX;
+    m_hasPosition = true;
   }
   /**
    * Get the position x
    */
-  uint32_t GetPositionX () const
+  double GetPositionX () const
   {
     return m_positionX;
   }
   /**
-   * Set the positionx
+   * Set the positionx, the position is then known
    * \param positionY the positionX
    */
-  void SetPositionY (uint32_t positionY)
+  void SetPositionY (double positionY)
   {
     m_positionY = positionY;
+    m_hasPosition = true;
   }
   /**
    * Get the position y
    */
-  uint32_t GetPositionY () const
+  double GetPositionY () const
   {
     return m_positionY;
   }
+  /**
+   * Mark the position of the node as unknown, until it is set again
+   */
+  void SetPositionUnknown ()
+  {
+    m_hasPosition = false;
+  }
+  /**
+   * \return true if the position of the node is known
+   */
+  bool HasPosition () const
+  {
+    return m_hasPosition;
+  }
+  /**
+   * Take the position, velocity and sampling time of the position of another entry
+   * \param other the entry
+   */
+  void CopyPosition (RoutingTableEntry const & other)
+  {
+    m_positionX = other.m_positionX;
+    m_positionY = other.m_positionY;
+    m_velocity = other.m_velocity;
+    m_positionTime = other.m_positionTime;
+    m_hasPosition = other.m_hasPosition;
+  }
+  /**
+   * Keep the measurements of the previous entry of the same destination that
+   * a route reply does not carry: the SNR of the link, and the position and
+   * the channel load if the reply gave none
+   * \param previous the previous entry
+   * \param located whether the reply gave a position
+   * \param loaded whether the reply carried a channel load
+   */
+  void KeepMeasurements (RoutingTableEntry const & previous, bool located, bool loaded)
+  {
+    if (!located)
+      {
+        CopyPosition (previous);
+      }
+    if (!loaded)
+      {
+        m_macQueue = previous.m_macQueue;
+        m_channelBusy = previous.m_channelBusy;
+        m_hasChannelLoad = previous.m_hasChannelLoad;
+      }
+    m_snr = previous.m_snr;
+    m_hasSnr = previous.m_hasSnr;
+  }
+  /**
+   * Set the velocity of the node and the time its position was sampled at
+   * \param velocity the velocity, m/s
+   * \param positionTime the sampling time of the position
+   */
+  void SetVelocity (Vector velocity, Time positionTime)
+  {
+    m_velocity = velocity;
+    m_positionTime = positionTime;
+  }
+  /**
+   * Get the velocity of the node
+   * \returns the velocity, m/s
+   */
+  Vector GetVelocity () const
+  {
+    return m_velocity;
+  }
+  /**
+   * Get the time the position was sampled at
+   * \returns the sampling time of the position
+   */
+  Time GetPositionTime () const
+  {
+    return m_positionTime;
+  }
+  /**
+   * Extrapolate the position of the node to the current time from its last
+   * sampled position and velocity
+   * \param maxAge the longest extrapolation, 0 returns the sampled position
+   * \returns the extrapolated position
+   */
+  Vector GetExtrapolatedPosition (Time maxAge) const;
   
   /**
    * Get the error count of this node
@@ -402,6 +564,70 @@ public:
   {
     m_freeSpace = count;
   }
+  /**
+   * Set the channel load advertised by this node
+   *
+   * \param macQueue the occupancy of its MAC queues, in [0, 1]
+   * \param channelBusy the fraction of time its channel was busy, in [0, 1]
+   */
+  void SetChannelLoad (double macQueue, double channelBusy)
+  {
+    m_macQueue = macQueue;
+    m_channelBusy = channelBusy;
+    m_hasChannelLoad = true;
+  }
+  /**
+   * \return true if this node advertised its channel load
+   */
+  bool HasChannelLoad () const
+  {
+    return m_hasChannelLoad;
+  }
+  /**
+   * Get the occupancy of the MAC queues of this node
+   *
+   * \return the occupancy, 0 if never advertised
+   */
+  double GetMacQueueOccupancy () const
+  {
+    return m_macQueue;
+  }
+  /**
+   * Get the fraction of time the channel of this node was busy
+   *
+   * \return the busy fraction, 0 if never advertised
+   */
+  double GetChannelBusy () const
+  {
+    return m_channelBusy;
+  }
+  /**
+   * Add a sample to the moving average of the SNR of the link to this node
+   *
+   * \param snr the SNR of a packet received from this node, dB
+   * \param weight the weight of the sample, in [0, 1]; the first sample is taken as is
+   */
+  void UpdateSnr (double snr, double weight)
+  {
+    m_snr = m_hasSnr ? weight * snr + (1 - weight) * m_snr : snr;
+    m_hasSnr = true;
+  }
+  /**
+   * \return true if the SNR of the link to this node was measured
+   */
+  bool HasSnr () const
+  {
+    return m_hasSnr;
+  }
+  /**
+   * Get the smoothed SNR of the link to this node
+   *
+   * \return the SNR, dB
+   */
+  double GetSnr () const
+  {
+    return m_snr;
+  }
   
 
 
@@ -460,13 +686,28 @@ private:
   bool m_blackListState;
   /// Time for which the node is put into the blacklist
   Time m_blackListTimeout;
-  // number of errors by this node
+  // decayed tx error rate advertised by this node, 1/1000 errors per second
   uint32_t m_txerrorCount;
   // position of this node
-  uint32_t m_positionX;
-  uint32_t m_positionY;
+  double m_positionX;
+  double m_positionY;
+  /// indicates whether the position is known
+  bool m_hasPosition;
+  // velocity of this node and sampling time of its position
+  Vector m_velocity;
+  Time m_positionTime;
   // empty space of this node
   uint32_t m_freeSpace;
+  /// MAC queue occupancy of this node
+  double m_macQueue;
+  /// channel busy fraction of this node
+  double m_channelBusy;
+  /// indicates whether the channel load was advertised
+  bool m_hasChannelLoad;
+  /// smoothed SNR of the link to this node, dB
+  double m_snr;
+  /// indicates whether m_snr was measured
+  bool m_hasSnr;
 };
 
 /**
@@ -481,6 +722,36 @@ public:
    * \param t the routing table entry lifetime
    */
   RoutingTable (Time t);
+  /**
+   * Callback notified when a route becomes valid, or its next hop changes (true),
+   * and when a valid route is invalidated or deleted (false)
+   */
+  typedef Callback<void, RoutingTableEntry const &, bool> ChangeCallback;
+  /**
+   * Set the callback notified of route changes
+   * \param cb the change callback
+   */
+  void SetChangeCallback (ChangeCallback cb)
+  {
+    m_changeCallback = cb;
+  }
+  /**
+   * Set the random variable drawing the initial cluster centers, so that
+   * clustering is reproducible through the stream assigned to it
+   * \param random the random variable
+   */
+  void SetRandomVariable (Ptr<UniformRandomVariable> random)
+  {
+    m_random = random;
+  }
+  /**
+   * Report the RREP-ACK timers cancelled along with their entries
+   * \param events the event accounting of the routing protocol, or 0
+   */
+  void SetEventAccounting (EventAccounting * events)
+  {
+    m_events = events;
+  }
   ///\name Handle lifetime of invalid route
   //\{
   /**
@@ -501,7 +772,25 @@ public:
   {
     m_badLinkLifetime = t;
   }
-  
+  /**
+   * Get the longest extrapolation of the positions used for clustering
+   *
+   * \return the longest extrapolation
+   */
+  Time GetMaxPositionExtrapolation () const
+  {
+    return m_maxExtrapolation;
+  }
+  /**
+   * Set the longest extrapolation of the positions used for clustering
+   *
+   * \param t the longest extrapolation, 0 disables it
+   */
+  void SetMaxPositionExtrapolation (Time t)
+  {
+    m_maxExtrapolation = t;
+  }
+
   
   //\}
   /**
@@ -565,10 +854,7 @@ public:
    */
   void DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface);
   /// Delete all entries from routing table
-  void Clear ()
-  {
-    m_ipv4AddressEntry.clear ();
-  }
+  void Clear ();
   /// Delete all outdated entries and invalidate valid entry if Lifetime is expired
   void Purge ();
   /** Mark entry as unidirectional (e.g. add this neighbor to "blacklist" for blacklistTimeout period)
@@ -583,8 +869,42 @@ public:
    * \param unit The time unit to use (default Time::S)
    */
   void Print (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
-  std::vector<Ipv4Address> Kmeans (Ipv4Address dst, uint32_t positionX, uint32_t positionY);
+  /**
+   * Select the forwarders of a route request by clustering the known nodes within
+   * two hops in the feature space of the parameters, by default on their distance
+   * to the destination, transmission errors and free buffer space.  The positions of the nodes are extrapolated from their
+   * advertised velocity, up to GetMaxPositionExtrapolation ().
+   * \param dst the destination of the route request
+   * \param positionX the estimated X position of the destination
+   * \param positionY the estimated Y position of the destination
+   * \param parameters the number of clusters and forwarders
+   * \param linkTxError optional per-link transmission error of a next hop, added
+   * to the error advertised by each node
+   * \param quality if not null, set to the number of forwarder candidates and
+   * the quality of the clusters
+   * \returns the nodes of the cluster closest to the ideal forwarder, at most
+   * parameters.m_maxForwarders of them
+   */
+  std::vector<Ipv4Address> Kmeans (Ipv4Address dst, double positionX, double positionY,
+                                   KmeansParameters const & parameters = KmeansParameters (),
+                                   Callback<double, Ipv4Address> linkTxError = Callback<double, Ipv4Address> (),
+                                   KmeansQuality * quality = 0);
 
+  /**
+   * \returns the number of entries, including expired ones not purged yet
+   */
+  uint32_t GetSize () const
+  {
+    return m_ipv4AddressEntry.size ();
+  }
+  /**
+   * \returns the estimated memory held by the entries and their routes, bytes
+   */
+  uint64_t GetMemoryBytes () const;
+  /**
+   * \returns the memory held by the precursor lists of the entries, bytes
+   */
+  uint64_t GetPrecursorMemoryBytes () const;
   bool isEmpty()
   {
     return m_ipv4AddressEntry.empty();
@@ -594,7 +914,39 @@ private:
   std::map<Ipv4Address, RoutingTableEntry> m_ipv4AddressEntry;
   /// Deletion time for invalid routes
   Time m_badLinkLifetime;
-  
+  /// Longest extrapolation of the positions used for clustering
+  Time m_maxExtrapolation;
+  /// Route change notification
+  ChangeCallback m_changeCallback;
+  /// Draws the initial cluster centers
+  Ptr<UniformRandomVariable> m_random;
+  /// Event accounting of the routing protocol, or 0
+  EventAccounting * m_events;
+
+  /**
+   * Notify the change callback, if set
+   * \param rt the entry after the change
+   * \param valid whether the route became valid or was invalidated
+   */
+  void NotifyChange (RoutingTableEntry const & rt, bool valid);
+  /**
+   * Cancel the RREP-ACK timer of an entry about to be deleted, if running
+   * \param rt the entry
+   */
+  void CancelAckTimer (RoutingTableEntry & rt);
+  /**
+   * Run Lloyd's algorithm on normalized features
+   * \param features the candidates in the feature space
+   * \param k the number of clusters, at most the number of candidates
+   * \param centers the cluster centers
+   * \param assignments the cluster of each candidate
+   * \param iterations set to the number of iterations after which the assignments
+   * no longer changed, 0 if they still changed at the last one
+   * \returns the inertia, the sum of squared distances of the candidates to their center
+   */
+  double Cluster (std::vector<std::vector<double> > const & features, uint32_t k,
+                  std::vector<std::vector<double> > & centers, std::vector<uint32_t> & assignments,
+                  uint32_t & iterations);
   /**
    * const version of Purge, for use by Print() method
    * \param table the routing table entry to purge
@@ -0,0 +1,342 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodvKmeans-stats.h"
+#include "aodvKmeans-routing-protocol.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/udp-header.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("aodvKmeansStats");
+
+namespace aodvKmeans {
+
+NS_OBJECT_ENSURE_REGISTERED (Stats);
+
+const uint32_t Stats::LATENCY_MAX_RETRIES;
+
+TypeId
+Stats::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::aodvKmeans::Stats")
+    .SetParent<Object> ()
+    .SetGroupName ("aodvKmeans")
+    .AddConstructor<Stats> ()
+  ;
+  return tid;
+}
+
+Stats::Stats ()
+{
+  Reset ();
+}
+
+void
+Stats::Attach (Ptr<RoutingProtocol> routing, Ptr<Ipv4L3Protocol> ipv4)
+{
+  NS_LOG_FUNCTION (this << routing << ipv4);
+  if (ipv4 != 0)
+    {
+      ipv4->TraceConnectWithoutContext ("Tx", MakeCallback (&Stats::NotifyTx, this));
+      ipv4->TraceConnectWithoutContext ("Rx", MakeCallback (&Stats::NotifyRx, this));
+    }
+  routing->TraceConnectWithoutContext ("RouteDiscoveryStarted", MakeCallback (&Stats::NotifyDiscoveryStarted, this));
+  routing->TraceConnectWithoutContext ("KmeansClustering", MakeCallback (&Stats::NotifyKmeans, this));
+  routing->TraceConnectWithoutContext ("ClusterCache", MakeCallback (&Stats::NotifyClusterCache, this));
+  routing->TraceConnectWithoutContext ("RequestQueueDrop", MakeCallback (&Stats::NotifyQueueDrop, this));
+  routing->TraceConnectWithoutContext ("RoutingTableSize", MakeCallback (&Stats::NotifyRoutingTableSize, this));
+  routing->TraceConnectWithoutContext ("RouteReplyLatency", MakeCallback (&Stats::NotifyReplyLatency, this));
+  routing->TraceConnectWithoutContext ("RouteDiscoveryLatency", MakeCallback (&Stats::NotifyDiscoveryLatency, this));
+}
+
+bool
+Stats::Classify (Ptr<const Packet> ipPacket, ControlType & type)
+{
+  Ptr<Packet> p = ipPacket->Copy ();
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  if (ipHeader.GetProtocol () != UdpL4Protocol::PROT_NUMBER || ipHeader.GetFragmentOffset () != 0)
+    {
+      return false;
+    }
+  UdpHeader udpHeader;
+  p->RemoveHeader (udpHeader);
+  if (udpHeader.GetDestinationPort () != RoutingProtocol::aodvKmeans_PORT)
+    {
+      return false;
+    }
+  TypeHeader tHeader;
+  p->RemoveHeader (tHeader);
+  if (!tHeader.IsValid ())
+    {
+      return false;
+    }
+  switch (tHeader.Get ())
+    {
+    case aodvKmeansTYPE_RREQ:
+      type = CONTROL_RREQ;
+      break;
+    case aodvKmeansTYPE_RREP:
+      {
+        RrepHeader rrepHeader;
+        p->RemoveHeader (rrepHeader);
+        type = (rrepHeader.GetDst () == rrepHeader.GetOrigin ()) ? CONTROL_HELLO : CONTROL_RREP;
+        break;
+      }
+    case aodvKmeansTYPE_RERR:
+      type = CONTROL_RERR;
+      break;
+    case aodvKmeansTYPE_RREP_ACK:
+      type = CONTROL_RREP_ACK;
+      break;
+    }
+  return true;
+}
+
+std::string
+Stats::GetControlTypeName (ControlType type)
+{
+  switch (type)
+    {
+    case CONTROL_RREQ:
+      return "rreq";
+    case CONTROL_RREP:
+      return "rrep";
+    case CONTROL_HELLO:
+      return "hello";
+    case CONTROL_RERR:
+      return "rerr";
+    case CONTROL_RREP_ACK:
+      return "rrepAck";
+    default:
+      return "unknown";
+    }
+}
+
+void
+Stats::RecordControl (ControlType type, uint32_t bytes, bool tx)
+{
+  if (tx)
+    {
+      m_txPackets[type]++;
+      m_txBytes[type] += bytes;
+    }
+  else
+    {
+      m_rxPackets[type]++;
+      m_rxBytes[type] += bytes;
+    }
+}
+
+uint64_t
+Stats::GetQueueDrops () const
+{
+  uint64_t drops = 0;
+  for (std::map<std::string, uint64_t>::const_iterator i = m_queueDrops.begin (); i != m_queueDrops.end (); ++i)
+    {
+      drops += i->second;
+    }
+  return drops;
+}
+
+void
+Stats::Reset ()
+{
+  for (uint32_t t = 0; t < CONTROL_TYPE_COUNT; t++)
+    {
+      m_txPackets[t] = 0;
+      m_txBytes[t] = 0;
+      m_rxPackets[t] = 0;
+      m_rxBytes[t] = 0;
+    }
+  m_clusteredDiscoveries = 0;
+  m_floodedDiscoveries = 0;
+  m_kmeansCalls = 0;
+  m_clusterCacheHits = 0;
+  m_queueDrops.clear ();
+  m_routingTableHighWater = 0;
+  for (uint32_t k = 0; k < LATENCY_KIND_COUNT; k++)
+    {
+      for (uint32_t c = 0; c < 2; c++)
+        {
+          for (uint32_t r = 0; r <= LATENCY_MAX_RETRIES; r++)
+            {
+              m_latency[k][c][r].Clear ();
+            }
+        }
+    }
+}
+
+std::string
+Stats::GetLatencyKindName (LatencyKind kind)
+{
+  switch (kind)
+    {
+    case LATENCY_REPLY:
+      return "reply";
+    case LATENCY_DISCOVERY:
+      return "discovery";
+    default:
+      return "unknown";
+    }
+}
+
+void
+Stats::PrintLatencyHeader (std::ostream & os)
+{
+  os << "time,node,metric,rreq,retries,count,p50,p95,p99" << std::endl;
+}
+
+void
+Stats::PrintLatencyRow (std::ostream & os, std::string node, LatencyKind kind, bool clustered,
+                        uint32_t retries, LatencyHistogram const & histogram)
+{
+  os << Simulator::Now ().GetSeconds () << "," << node << "," << GetLatencyKindName (kind)
+     << "," << (clustered ? "clustered" : "broadcast") << ","
+     << retries << (retries == LATENCY_MAX_RETRIES ? "+" : "") << "," << histogram.GetCount ()
+     << "," << histogram.GetPercentile (0.5).GetSeconds () << "," << histogram.GetPercentile (0.95).GetSeconds ()
+     << "," << histogram.GetPercentile (0.99).GetSeconds () << std::endl;
+}
+
+void
+Stats::PrintCsvHeader (std::ostream & os)
+{
+  os << "time,node";
+  for (uint32_t t = 0; t < CONTROL_TYPE_COUNT; t++)
+    {
+      std::string name = GetControlTypeName (ControlType (t));
+      os << "," << name << "TxPackets," << name << "TxBytes," << name << "RxPackets," << name << "RxBytes";
+    }
+  os << ",clusteredDiscoveries,floodedDiscoveries,kmeansCalls,clusterCacheHits,queueDrops,routingTableHighWater" << std::endl;
+}
+
+void
+Stats::PrintCsv (std::ostream & os, uint32_t node) const
+{
+  os << Simulator::Now ().GetSeconds () << "," << node;
+  for (uint32_t t = 0; t < CONTROL_TYPE_COUNT; t++)
+    {
+      os << "," << m_txPackets[t] << "," << m_txBytes[t] << "," << m_rxPackets[t] << "," << m_rxBytes[t];
+    }
+  os << "," << m_clusteredDiscoveries << "," << m_floodedDiscoveries << "," << m_kmeansCalls << "," << m_clusterCacheHits
+     << "," << GetQueueDrops () << "," << m_routingTableHighWater << std::endl;
+}
+
+void
+Stats::PrintJson (std::ostream & os, uint32_t node) const
+{
+  os << "{\"time\":" << Simulator::Now ().GetSeconds () << ",\"node\":" << node;
+  for (uint32_t t = 0; t < CONTROL_TYPE_COUNT; t++)
+    {
+      os << ",\"" << GetControlTypeName (ControlType (t)) << "\":{\"txPackets\":" << m_txPackets[t]
+         << ",\"txBytes\":" << m_txBytes[t] << ",\"rxPackets\":" << m_rxPackets[t] << ",\"rxBytes\":" << m_rxBytes[t] << "}";
+    }
+  os << ",\"clusteredDiscoveries\":" << m_clusteredDiscoveries << ",\"floodedDiscoveries\":" << m_floodedDiscoveries
+     << ",\"kmeansCalls\":" << m_kmeansCalls << ",\"clusterCacheHits\":" << m_clusterCacheHits << ",\"queueDrops\":{";
+  for (std::map<std::string, uint64_t>::const_iterator i = m_queueDrops.begin (); i != m_queueDrops.end (); ++i)
+    {
+      // drop reasons are plain text, without quotes or backslashes
+      os << (i == m_queueDrops.begin () ? "" : ",") << "\"" << i->first << "\":" << i->second;
+    }
+  os << "},\"routingTableHighWater\":" << m_routingTableHighWater << "}" << std::endl;
+}
+
+void
+Stats::NotifyTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  ControlType type;
+  if (Classify (packet, type))
+    {
+      RecordControl (type, packet->GetSize (), true);
+    }
+}
+
+void
+Stats::NotifyRx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  ControlType type;
+  if (Classify (packet, type))
+    {
+      RecordControl (type, packet->GetSize (), false);
+    }
+}
+
+void
+Stats::NotifyDiscoveryStarted (Ipv4Address dst, bool clustered)
+{
+  if (clustered)
+    {
+      m_clusteredDiscoveries++;
+    }
+  else
+    {
+      m_floodedDiscoveries++;
+    }
+}
+
+void
+Stats::NotifyKmeans (Ipv4Address dst, uint32_t candidates, const std::vector<Ipv4Address> & selected)
+{
+  m_kmeansCalls++;
+}
+
+void
+Stats::NotifyClusterCache (Ipv4Address dst, bool hit)
+{
+  if (hit)
+    {
+      m_clusterCacheHits++;
+    }
+}
+
+void
+Stats::NotifyQueueDrop (Ptr<const Packet> packet, const Ipv4Header & header, std::string reason, uint8_t priorityClass)
+{
+  std::string::size_type end = reason.find_last_not_of (' ');
+  m_queueDrops[reason.substr (0, end == std::string::npos ? 0 : end + 1)]++;
+}
+
+void
+Stats::NotifyRoutingTableSize (uint32_t oldValue, uint32_t newValue)
+{
+  m_routingTableHighWater = std::max (m_routingTableHighWater, newValue);
+}
+
+void
+Stats::NotifyReplyLatency (Ipv4Address dst, Time latency, bool clustered, uint32_t retries)
+{
+  RecordLatency (LATENCY_REPLY, latency, clustered, retries);
+}
+
+void
+Stats::NotifyDiscoveryLatency (Ipv4Address dst, Time latency, bool clustered, uint32_t retries)
+{
+  RecordLatency (LATENCY_DISCOVERY, latency, clustered, retries);
+}
+
+void
+Stats::RecordLatency (LatencyKind kind, Time latency, bool clustered, uint32_t retries)
+{
+  m_latency[kind][clustered][std::min (retries, LATENCY_MAX_RETRIES)].Add (latency);
+}
+
+}  // namespace aodvKmeans
+}  // namespace ns3
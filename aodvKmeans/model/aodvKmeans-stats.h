@@ -0,0 +1,342 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef aodvKmeans_STATS_H
+#define aodvKmeans_STATS_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-header.h"
+#include "aodvKmeans-packet.h"
+#include "aodvKmeans-latency-histogram.h"
+
+namespace ns3 {
+
+class Ipv4;
+class Ipv4L3Protocol;
+
+namespace aodvKmeans {
+
+class RoutingProtocol;
+
+/**
+ * \ingroup aodvKmeans
+ *
+ * \brief Protocol statistics of a node.
+ *
+ * Counts the aodvKmeans control packets sent and received by the IP layer of the
+ * node, and their size including the IP and UDP headers, by message type, and
+ * follows the trace sources of its routing protocol for the route discoveries
+ * whose first RREQ was sent to a cluster or broadcast, the forwarder selections, the route discovery buffer
+ * drops and the size of the routing table.  It also keeps histograms of the
+ * route discovery latencies, by kind of RREQ and number of retries.  All
+ * counters are cumulative.
+ * aodvKmeansHelper::EnableStats aggregates a Stats object to the nodes
+ * running aodvKmeans.
+ */
+class Stats : public Object
+{
+public:
+  /// Types of control messages
+  enum ControlType
+  {
+    CONTROL_RREQ = 0,      //!< route request
+    CONTROL_RREP = 1,      //!< route reply other than a hello
+    CONTROL_HELLO = 2,     //!< hello
+    CONTROL_RERR = 3,      //!< route error
+    CONTROL_RREP_ACK = 4,  //!< route reply acknowledgment
+    CONTROL_TYPE_COUNT = 5, //!< number of control message types
+  };
+
+  /// Kinds of route discovery latencies
+  enum LatencyKind
+  {
+    LATENCY_REPLY = 0,      //!< from the first RREQ to the first RREP
+    LATENCY_DISCOVERY = 1,  //!< from buffering the first packet to sending it
+    LATENCY_KIND_COUNT = 2, //!< number of kinds of latencies
+  };
+
+  /// Route discoveries with more retries are counted with this number of retries
+  static const uint32_t LATENCY_MAX_RETRIES = 3;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /// constructor
+  Stats ();
+  /**
+   * Start counting the control packets of a node and the events of its routing protocol
+   * \param routing the routing protocol of the node
+   * \param ipv4 the IP layer of the node, 0 to only follow the routing protocol
+   */
+  void Attach (Ptr<RoutingProtocol> routing, Ptr<Ipv4L3Protocol> ipv4);
+  /**
+   * Identify an aodvKmeans control packet
+   * \param ipPacket a packet starting with its IP header
+   * \param type the type of the control message, if any
+   * \returns true if the packet is an aodvKmeans control packet
+   */
+  static bool Classify (Ptr<const Packet> ipPacket, ControlType & type);
+  /**
+   * \param type the type of control message
+   * \returns the name of the type, as used in snapshots
+   */
+  static std::string GetControlTypeName (ControlType type);
+  /**
+   * Count a control packet
+   * \param type the type of the control message
+   * \param bytes the size of the packet
+   * \param tx true if the packet was sent, false if received
+   */
+  void RecordControl (ControlType type, uint32_t bytes, bool tx);
+  /**
+   * \param type the type of control message
+   * \returns the number of packets sent
+   */
+  uint64_t GetTxPackets (ControlType type) const
+  {
+    return m_txPackets[type];
+  }
+  /**
+   * \param type the type of control message
+   * \returns the number of bytes sent
+   */
+  uint64_t GetTxBytes (ControlType type) const
+  {
+    return m_txBytes[type];
+  }
+  /**
+   * \param type the type of control message
+   * \returns the number of packets received
+   */
+  uint64_t GetRxPackets (ControlType type) const
+  {
+    return m_rxPackets[type];
+  }
+  /**
+   * \param type the type of control message
+   * \returns the number of bytes received
+   */
+  uint64_t GetRxBytes (ControlType type) const
+  {
+    return m_rxBytes[type];
+  }
+  /**
+   * \returns the number of route discoveries whose first RREQ was sent to a cluster of neighbors
+   */
+  uint64_t GetClusteredDiscoveries () const
+  {
+    return m_clusteredDiscoveries;
+  }
+  /**
+   * \returns the number of route discoveries whose first RREQ was broadcast
+   */
+  uint64_t GetFloodedDiscoveries () const
+  {
+    return m_floodedDiscoveries;
+  }
+  /**
+   * \returns the number of forwarder selections by K-means
+   */
+  uint64_t GetKmeansCalls () const
+  {
+    return m_kmeansCalls;
+  }
+  /**
+   * \returns the number of forwarder selections served by the cluster cache
+   */
+  uint64_t GetClusterCacheHits () const
+  {
+    return m_clusterCacheHits;
+  }
+  /**
+   * \returns the number of packets dropped from the route discovery buffer
+   */
+  uint64_t GetQueueDrops () const;
+  /**
+   * \returns the number of packets dropped from the route discovery buffer, by reason
+   */
+  std::map<std::string, uint64_t> const & GetQueueDropsByReason () const
+  {
+    return m_queueDrops;
+  }
+  /**
+   * \returns the largest number of routing table entries
+   */
+  uint32_t GetRoutingTableHighWater () const
+  {
+    return m_routingTableHighWater;
+  }
+  /**
+   * Get a histogram of route discovery latencies
+   * \param kind the kind of latency
+   * \param clustered true for the discoveries whose last RREQ was sent to a cluster, false if broadcast
+   * \param retries the number of retries, at most LATENCY_MAX_RETRIES
+   * \returns the histogram
+   */
+  LatencyHistogram const & GetLatency (LatencyKind kind, bool clustered, uint32_t retries) const
+  {
+    return m_latency[kind][clustered][retries];
+  }
+  /**
+   * \param kind the kind of latency
+   * \returns the name of the kind, as used in reports
+   */
+  static std::string GetLatencyKindName (LatencyKind kind);
+  /// Reset all counters
+  void Reset ();
+  /**
+   * Print the header line of CSV snapshots
+   * \param os the output stream
+   */
+  static void PrintCsvHeader (std::ostream & os);
+  /**
+   * Print the counters as a CSV line
+   * \param os the output stream
+   * \param node the id of the node
+   */
+  void PrintCsv (std::ostream & os, uint32_t node) const;
+  /**
+   * Print the counters as a JSON object on one line
+   * \param os the output stream
+   * \param node the id of the node
+   */
+  void PrintJson (std::ostream & os, uint32_t node) const;
+  /**
+   * Print the header line of CSV latency reports
+   * \param os the output stream
+   */
+  static void PrintLatencyHeader (std::ostream & os);
+  /**
+   * Print the percentiles of a latency histogram as a CSV line
+   * \param os the output stream
+   * \param node the id of the node, or any name for aggregates
+   * \param kind the kind of latency
+   * \param clustered true if the RREQs were sent to a cluster
+   * \param retries the number of retries
+   * \param histogram the histogram
+   */
+  static void PrintLatencyRow (std::ostream & os, std::string node, LatencyKind kind, bool clustered,
+                               uint32_t retries, LatencyHistogram const & histogram);
+
+private:
+  /**
+   * Count a packet sent by the IP layer
+   * \param packet the packet, with its IP header
+   * \param ipv4 the IP layer
+   * \param interface the interface index
+   */
+  void NotifyTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * Count a packet received by the IP layer
+   * \param packet the packet, with its IP header
+   * \param ipv4 the IP layer
+   * \param interface the interface index
+   */
+  void NotifyRx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * Count a started route discovery
+   * \param dst the destination of the route discovery
+   * \param clustered true if its first RREQ was sent to a cluster of neighbors
+   */
+  void NotifyDiscoveryStarted (Ipv4Address dst, bool clustered);
+  /**
+   * Count a forwarder selection by K-means
+   * \param dst the destination of the RREQ
+   * \param candidates the number of forwarder candidates
+   * \param selected the selected forwarders
+   */
+  void NotifyKmeans (Ipv4Address dst, uint32_t candidates, const std::vector<Ipv4Address> & selected);
+  /**
+   * Count a cluster cache lookup
+   * \param dst the destination of the RREQ
+   * \param hit true if a cluster was cached
+   */
+  void NotifyClusterCache (Ipv4Address dst, bool hit);
+  /**
+   * Count a packet dropped from the route discovery buffer
+   * \param packet the packet
+   * \param header its IP header
+   * \param reason the reason of the drop
+   * \param priorityClass its priority class
+   */
+  void NotifyQueueDrop (Ptr<const Packet> packet, const Ipv4Header & header, std::string reason, uint8_t priorityClass);
+  /**
+   * Follow the size of the routing table
+   * \param oldValue the previous size
+   * \param newValue the current size
+   */
+  void NotifyRoutingTableSize (uint32_t oldValue, uint32_t newValue);
+  /**
+   * Record a latency from the first RREQ to the first RREP
+   * \param dst the destination of the route discovery
+   * \param latency the latency
+   * \param clustered true if the last RREQ was sent to a cluster
+   * \param retries the number of retries
+   */
+  void NotifyReplyLatency (Ipv4Address dst, Time latency, bool clustered, uint32_t retries);
+  /**
+   * Record a latency from buffering the first packet to sending it
+   * \param dst the destination of the route discovery
+   * \param latency the latency
+   * \param clustered true if the last RREQ was sent to a cluster
+   * \param retries the number of retries
+   */
+  void NotifyDiscoveryLatency (Ipv4Address dst, Time latency, bool clustered, uint32_t retries);
+  /**
+   * Record a route discovery latency
+   * \param kind the kind of latency
+   * \param latency the latency
+   * \param clustered true if the last RREQ was sent to a cluster
+   * \param retries the number of retries
+   */
+  void RecordLatency (LatencyKind kind, Time latency, bool clustered, uint32_t retries);
+
+  /// Control packets sent, by type
+  uint64_t m_txPackets[CONTROL_TYPE_COUNT];
+  /// Control bytes sent, by type
+  uint64_t m_txBytes[CONTROL_TYPE_COUNT];
+  /// Control packets received, by type
+  uint64_t m_rxPackets[CONTROL_TYPE_COUNT];
+  /// Control bytes received, by type
+  uint64_t m_rxBytes[CONTROL_TYPE_COUNT];
+  /// Route discoveries whose first RREQ was sent to a cluster of neighbors
+  uint64_t m_clusteredDiscoveries;
+  /// Route discoveries whose first RREQ was broadcast
+  uint64_t m_floodedDiscoveries;
+  /// Forwarder selections by K-means
+  uint64_t m_kmeansCalls;
+  /// Forwarder selections served by the cluster cache
+  uint64_t m_clusterCacheHits;
+  /// Route discovery buffer drops, by reason
+  std::map<std::string, uint64_t> m_queueDrops;
+  /// Largest number of routing table entries
+  uint32_t m_routingTableHighWater;
+  /// Route discovery latencies, by kind, kind of RREQ and number of retries
+  LatencyHistogram m_latency[LATENCY_KIND_COUNT][2][LATENCY_MAX_RETRIES + 1];
+};
+
+}  // namespace aodvKmeans
+}  // namespace ns3
+
+#endif /* aodvKmeans_STATS_H */
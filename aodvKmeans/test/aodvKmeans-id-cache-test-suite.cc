@@ -105,6 +105,90 @@ IdCacheTest::CheckTimeout3 ()
   NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 0, "All records expire");
 }
 
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Scaling test for id cache
+ *
+ * A flood-sized population of entries is inserted every second; the cache must
+ * keep exactly the entries of the last lifetime and a bounded number of expiry
+ * buckets, whatever the number of entries.
+ */
+class IdCacheScalingTest : public TestCase
+{
+public:
+  IdCacheScalingTest () : TestCase ("Id Cache scaling"),
+                          cache (Seconds (5)),
+                          batch (0)
+  {
+  }
+  virtual void DoRun ();
+
+private:
+  /// Insert a batch of entries
+  void Insert ();
+  /// Check the content of the cache
+  void Check ();
+
+  /// Number of entries inserted per second
+  static const uint32_t BATCH_SIZE = 4000;
+  /// Number of batches
+  static const uint32_t BATCHES = 20;
+  /// ID cache
+  IdCache cache;
+  /// Index of the next batch
+  uint32_t batch;
+};
+
+void
+IdCacheScalingTest::DoRun ()
+{
+  for (uint32_t i = 0; i < BATCHES; ++i)
+    {
+      Simulator::Schedule (Seconds (i), &IdCacheScalingTest::Insert, this);
+      Simulator::Schedule (Seconds (i + 0.5), &IdCacheScalingTest::Check, this);
+    }
+  Simulator::Schedule (Seconds (BATCHES + 10), &IdCacheScalingTest::Check, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+IdCacheScalingTest::Insert ()
+{
+  for (uint32_t i = 0; i < BATCH_SIZE; ++i)
+    {
+      Ipv4Address origin (0x0a000000 + i % 256);
+      NS_TEST_EXPECT_MSG_EQ (cache.IsDuplicate (origin, batch * BATCH_SIZE + i), false, "Unknown ID");
+    }
+  Ipv4Address origin (0x0a000000);
+  NS_TEST_EXPECT_MSG_EQ (cache.IsDuplicate (origin, batch * BATCH_SIZE), true, "Known ID");
+  batch++;
+}
+
+void
+IdCacheScalingTest::Check ()
+{
+  // Batches inserted within the last 5 seconds are alive
+  double now = Simulator::Now ().GetSeconds ();
+  uint32_t alive = 0;
+  for (uint32_t i = 0; i < batch; ++i)
+    {
+      if (i + 5 >= now)
+        {
+          alive += BATCH_SIZE;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), alive, "Exact expiration");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (cache.GetBucketCount (), 17, "Bounded number of buckets");
+  if (batch > 0 && alive > 0)
+    {
+      Ipv4Address origin (0x0a000000 + (BATCH_SIZE - 1) % 256);
+      NS_TEST_EXPECT_MSG_EQ (cache.IsDuplicate (origin, batch * BATCH_SIZE - 1), true, "Newest ID is known");
+    }
+}
+
 /**
  * \ingroup aodvKmeans-test
  * \ingroup tests
@@ -117,6 +201,7 @@ public:
   IdCacheTestSuite () : TestSuite ("aodvKmeans-routing-id-cache", UNIT)
   {
     AddTestCase (new IdCacheTest, TestCase::QUICK);
+    AddTestCase (new IdCacheScalingTest, TestCase::QUICK);
   }
 } g_idCacheTestSuite; ///< the test suite
 
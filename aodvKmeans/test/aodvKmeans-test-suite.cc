@@ -22,7 +22,37 @@
 #include "ns3/aodvKmeans-packet.h"
 #include "ns3/aodvKmeans-rqueue.h"
 #include "ns3/aodvKmeans-rtable.h"
+#include "ns3/aodvKmeans-dpd.h"
+#include "ns3/aodvKmeans-link-quality.h"
+#include "ns3/aodvKmeans-location-cache.h"
+#include "ns3/aodvKmeans-stats.h"
+#include "ns3/aodvKmeans-latency-histogram.h"
+#include "ns3/aodvKmeans-event-accounting.h"
+#include "ns3/aodvKmeans-ring-buffer.h"
+#include "ns3/aodvKmeans-event-log.h"
+#include "ns3/aodvKmeans-memory-usage.h"
+#include "ns3/aodvKmeans-lru-cache.h"
+#include "ns3/aodvKmeans-routing-protocol.h"
+#include "ns3/aodvKmeans-channel-load.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/udp-header.h"
 #include "ns3/ipv4-route.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/wifi-mac-helper.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/arp-cache.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/aodvKmeans-helper.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/udp-socket-factory.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
 
 namespace ns3 {
 namespace aodvKmeans {
@@ -67,6 +97,7 @@ NeighborTest::CheckTimeout1 ()
   NS_TEST_EXPECT_MSG_EQ (neighbor->IsNeighbor (Ipv4Address ("1.1.1.1")), true, "Neighbor exists");
   NS_TEST_EXPECT_MSG_EQ (neighbor->IsNeighbor (Ipv4Address ("2.2.2.2")), true, "Neighbor exists");
   NS_TEST_EXPECT_MSG_EQ (neighbor->IsNeighbor (Ipv4Address ("3.3.3.3")), true, "Neighbor exists");
+  NS_TEST_EXPECT_MSG_EQ (neighbor->GetSize (), 4, "trivial");
 }
 void
 NeighborTest::CheckTimeout2 ()
@@ -75,6 +106,8 @@ NeighborTest::CheckTimeout2 ()
   NS_TEST_EXPECT_MSG_EQ (neighbor->IsNeighbor (Ipv4Address ("1.1.1.1")), false, "Neighbor doesn't exist");
   NS_TEST_EXPECT_MSG_EQ (neighbor->IsNeighbor (Ipv4Address ("2.2.2.2")), false, "Neighbor doesn't exist");
   NS_TEST_EXPECT_MSG_EQ (neighbor->IsNeighbor (Ipv4Address ("3.3.3.3")), true, "Neighbor exists");
+  NS_TEST_EXPECT_MSG_EQ (neighbor->GetSize (), 1, "Expired neighbors removed");
+  NS_TEST_EXPECT_MSG_EQ (neighbor->GetExpireTime (Ipv4Address ("3.3.3.3")), Seconds (5), "Known expire time");
 }
 void
 NeighborTest::CheckTimeout3 ()
@@ -88,7 +121,7 @@ NeighborTest::CheckTimeout3 ()
 void
 NeighborTest::DoRun ()
 {
-  Neighbors nb (Seconds (1));
+  Neighbors nb;
   neighbor = &nb;
   neighbor->SetCallback (MakeCallback (&NeighborTest::Handler, this));
   neighbor->Update (Ipv4Address ("1.2.3.4"), Seconds (1));
@@ -101,6 +134,8 @@ NeighborTest::DoRun ()
   neighbor->Update (Ipv4Address ("1.1.1.1"), Seconds (5));
   neighbor->Update (Ipv4Address ("2.2.2.2"), Seconds (10));
   neighbor->Update (Ipv4Address ("3.3.3.3"), Seconds (20));
+  NS_TEST_EXPECT_MSG_EQ (neighbor->GetTimerScheduledCount (), 1, "Timer armed once for the earliest expiry");
+  NS_TEST_EXPECT_MSG_EQ (neighbor->GetTimerCancelledCount (), 0, "Later expiries do not re-arm the timer");
 
   Simulator::Schedule (Seconds (2), &NeighborTest::CheckTimeout1, this);
   Simulator::Schedule (Seconds (15), &NeighborTest::CheckTimeout2, this);
@@ -109,6 +144,90 @@ NeighborTest::DoRun ()
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for the IP and MAC indexes of the neighbors
+ */
+struct NeighborIndexTest : public TestCase
+{
+  NeighborIndexTest () : TestCase ("NeighborIndex")
+  {
+  }
+  virtual void DoRun ();
+  /**
+   * Record a closed link
+   * \param addr the IPv4 address of the neighbor
+   */
+  void Handler (Ipv4Address addr)
+  {
+    closed.push_back (addr);
+  }
+  /**
+   * Report a failed transmission to a neighbor
+   * \param neighbors the neighbors
+   * \param mac the MAC address of the receiver
+   */
+  void TxError (Neighbors & neighbors, Mac48Address mac)
+  {
+    WifiMacHeader hdr;
+    hdr.SetAddr1 (mac);
+    neighbors.GetTxErrorCallback () (hdr);
+  }
+
+  /// Neighbors whose link was closed
+  std::vector<Ipv4Address> closed;
+};
+
+void
+NeighborIndexTest::DoRun ()
+{
+  Neighbors nb;
+  nb.SetCallback (MakeCallback (&NeighborIndexTest::Handler, this));
+  Ptr<ArpCache> arp = CreateObject<ArpCache> ();
+  std::vector<Ipv4Address> addresses;
+  std::vector<Mac48Address> macs;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      addresses.push_back (Ipv4Address (0x0a000001 + i));
+      std::ostringstream mac;
+      mac << "00:00:00:00:00:0" << i + 1;
+      macs.push_back (Mac48Address (mac.str ().c_str ()));
+      arp->Add (addresses.back ())->SetMacAddress (macs.back ());
+    }
+  nb.AddArpCache (arp);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      nb.Update (addresses[i], Seconds (10 + i));
+    }
+  NS_TEST_EXPECT_MSG_EQ (nb.GetMacAddress (addresses[2]), macs[2], "Resolved by the ARP cache");
+
+  // the last neighbor takes the place of the second one
+  TxError (nb, macs[1]);
+  NS_TEST_EXPECT_MSG_EQ (closed.size (), 1, "Only the neighbor behind the MAC address");
+  NS_TEST_EXPECT_MSG_EQ (closed.back (), addresses[1], "trivial");
+  NS_TEST_EXPECT_MSG_EQ (nb.GetSize (), 3, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (nb.IsNeighbor (addresses[1]), false, "Closed");
+  NS_TEST_EXPECT_MSG_EQ (nb.IsNeighbor (addresses[3]), true, "Moved neighbor found by IP address");
+  NS_TEST_EXPECT_MSG_EQ (nb.GetExpireTime (addresses[3]), Seconds (13), "With its own entry");
+  NS_TEST_EXPECT_MSG_EQ (nb.GetMacAddress (addresses[3]), macs[3], "trivial");
+
+  TxError (nb, macs[3]);
+  NS_TEST_EXPECT_MSG_EQ (closed.size (), 2, "Moved neighbor found by MAC address");
+  NS_TEST_EXPECT_MSG_EQ (closed.back (), addresses[3], "trivial");
+  NS_TEST_EXPECT_MSG_EQ (nb.IsNeighbor (addresses[3]), false, "Closed");
+  NS_TEST_EXPECT_MSG_EQ (nb.IsNeighbor (addresses[0]), true, "Other neighbors kept");
+  NS_TEST_EXPECT_MSG_EQ (nb.IsNeighbor (addresses[2]), true, "Other neighbors kept");
+
+  TxError (nb, macs[1]);
+  TxError (nb, Mac48Address ("00:00:00:00:00:09"));
+  NS_TEST_EXPECT_MSG_EQ (closed.size (), 2, "Unknown MAC addresses close nothing");
+  NS_TEST_EXPECT_MSG_EQ (nb.GetSize (), 2, "trivial");
+  nb.Clear ();
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup aodvKmeans-test
  * \ingroup tests
@@ -185,6 +304,17 @@ struct RreqHeaderTest : public TestCase
     NS_TEST_EXPECT_MSG_EQ (bytes, 23, "RREP is 23 bytes long");
     NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
 
+    NS_TEST_EXPECT_MSG_EQ (h.HasOriginPosition (), false, "trivial");
+    h.SetOriginPosition (-120.5, 3000.25);
+    NS_TEST_EXPECT_MSG_EQ (h.HasOriginPosition (), true, "trivial");
+    p = Create<Packet> ();
+    p->AddHeader (h);
+    RreqHeader h3;
+    bytes = p->RemoveHeader (h3);
+    NS_TEST_EXPECT_MSG_EQ (bytes, 29, "RREQ with the originator position is 29 bytes long");
+    NS_TEST_EXPECT_MSG_EQ (h, h3, "Round trip serialization works");
+    NS_TEST_EXPECT_MSG_EQ (h3.GetOriginPosition ().first, -120.5, "Originator position");
+    NS_TEST_EXPECT_MSG_EQ (h3.GetOriginPosition ().second, 3000.25, "Originator position");
   }
 };
 
@@ -237,6 +367,115 @@ struct RrepHeaderTest : public TestCase
     uint32_t bytes = p->RemoveHeader (h2);
     NS_TEST_EXPECT_MSG_EQ (bytes, 19, "RREP is 19 bytes long");
     NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
+
+    h.SetVelocity (Vector (1.5, -2.25, 0), MilliSeconds (4200));
+    NS_TEST_EXPECT_MSG_EQ (h.HasVelocity (), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (h.GetAckRequired (), false, "Velocity flag is distinct");
+    NS_TEST_EXPECT_MSG_EQ (h.GetPositionTime (), MilliSeconds (4200), "trivial");
+    p = Create<Packet> ();
+    p->AddHeader (h);
+    RrepHeader h3;
+    NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (h3), h.GetSerializedSize (), "Velocity extension is serialized");
+    NS_TEST_EXPECT_MSG_EQ (h, h3, "Round trip serialization with velocity works");
+    NS_TEST_EXPECT_MSG_EQ_TOL (h3.GetVelocity ().x, 1.5, 0.001, "Velocity x");
+    NS_TEST_EXPECT_MSG_EQ_TOL (h3.GetVelocity ().y, -2.25, 0.001, "Velocity y");
+    h.SetHello (Ipv4Address ("10.0.0.2"), 9, Seconds (15));
+    NS_TEST_EXPECT_MSG_EQ (h.HasVelocity (), false, "Hello starts without velocity");
+  }
+};
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for the compact K-means extension of RREP
+ */
+struct RrepCompactHeaderTest : public TestCase
+{
+  RrepCompactHeaderTest () : TestCase ("aodvKmeans RREP compact K-means extension")
+  {
+  }
+  /**
+   * Serialize and deserialize a RREP
+   * \param h the RREP
+   * \param size the expected size, in bytes
+   * \returns the deserialized RREP
+   */
+  RrepHeader RoundTrip (RrepHeader const & h, uint32_t size)
+  {
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (h);
+    RrepHeader h2;
+    NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (h2), size, "Serialized size");
+    return h2;
+  }
+  virtual void DoRun ()
+  {
+    RrepHeader h (/*prefixSize*/ 0, /*hopCount*/ 0, /*dst*/ Ipv4Address ("1.2.3.4"), /*dstSeqNo*/ 2,
+                  /*origin*/ Ipv4Address ("1.2.3.4"), /*lifetime*/ Seconds (2),
+                  /*txErrorCount*/ 1000, /*freeSpace*/ 24, /*positionX*/ 100.5, /*positionY*/ -20.25);
+    NS_TEST_EXPECT_MSG_EQ (h.GetKmeansExtension (), KMEANS_EXT_LEGACY, "Legacy by default");
+    NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 19 + 16, "Legacy metrics are 16 bytes");
+
+    h.SetKmeansExtension (KMEANS_EXT_NONE);
+    RrepHeader none = RoundTrip (h, 19);
+    NS_TEST_EXPECT_MSG_EQ (none.GetKmeansExtension (), KMEANS_EXT_NONE, "No metrics");
+
+    h.SetKmeansExtension (KMEANS_EXT_COMPACT);
+    RrepHeader absolute = RoundTrip (h, 19 + 11);
+    NS_TEST_EXPECT_MSG_EQ (absolute.GetKmeansExtension (), KMEANS_EXT_COMPACT, "Compact metrics");
+    NS_TEST_EXPECT_MSG_EQ (absolute.GetPosition ().first, 100.5, "Positions have 1/16 m resolution");
+    NS_TEST_EXPECT_MSG_EQ (absolute.GetPosition ().second, -20.25, "Negative positions are kept");
+    NS_TEST_EXPECT_MSG_EQ (absolute.GetFreeSpace (), 24, "Small metrics are exact");
+    NS_TEST_EXPECT_MSG_EQ_TOL (double (absolute.GetTxErrorCount ()), 1000.0, 32.0, "Large metrics are quantized");
+
+    h.SetPositionKeyframe (7);
+    RrepHeader keyframe = RoundTrip (h, 19 + 12);
+    NS_TEST_EXPECT_MSG_EQ (keyframe.IsPositionKeyframe (), true, "Keyframe");
+    NS_TEST_EXPECT_MSG_EQ (keyframe.GetPositionKeyframe (), 7, "Keyframe number");
+
+    h.SetPositionDelta (7, 98, -21);
+    RrepHeader delta = RoundTrip (h, 19 + 8);
+    NS_TEST_EXPECT_MSG_EQ (delta.IsPositionDelta (), true, "Small offsets use 8 bits");
+    delta.ResolvePositionDelta (98, -21);
+    NS_TEST_EXPECT_MSG_EQ (delta.GetPosition ().first, 100.5, "Offset resolved against the keyframe");
+    NS_TEST_EXPECT_MSG_EQ (delta.GetPosition ().second, -20.25, "Offset resolved against the keyframe");
+
+    h.SetPositionDelta (7, 0, 0);
+    delta = RoundTrip (h, 19 + 10);
+    NS_TEST_EXPECT_MSG_EQ (delta.GetPosition ().first, 100.5, "Larger offsets use 16 bits");
+    NS_TEST_EXPECT_MSG_EQ (RrepHeader::FitsPositionDelta (3000, 0), false, "Far moves need a keyframe");
+
+    for (uint32_t v = 0; v < 500000; v += 1 + v / 64)
+      {
+        uint32_t decoded = RrepHeader::DecodeMetric (RrepHeader::EncodeMetric (v));
+        NS_TEST_EXPECT_MSG_EQ_TOL (double (decoded), double (v), v / 32.0 + 1, "Metric relative error");
+      }
+    NS_TEST_EXPECT_MSG_EQ (RrepHeader::EncodeMetric (4000000), 0xff, "Metrics saturate");
+
+    LocationGossip gossip;
+    gossip.m_node = Ipv4Address ("10.0.0.9");
+    gossip.m_positionX = -5.5;
+    gossip.m_positionY = 250;
+    gossip.m_age = MilliSeconds (1200);
+    h.AddLocationGossip (gossip);
+    RrepHeader gossiped = RoundTrip (h, 19 + 10 + 1 + 12);
+    NS_TEST_EXPECT_MSG_EQ (gossiped.GetLocationGossip ().size (), 1, "Gossiped position");
+    NS_TEST_EXPECT_MSG_EQ (gossiped.GetLocationGossip ()[0].m_node, Ipv4Address ("10.0.0.9"), "Gossiped node");
+    NS_TEST_EXPECT_MSG_EQ (gossiped.GetLocationGossip ()[0].m_positionX, -5.5, "Gossiped position");
+    NS_TEST_EXPECT_MSG_EQ (gossiped.GetLocationGossip ()[0].m_age, MilliSeconds (1200), "Ages have 100 ms resolution");
+    NS_TEST_EXPECT_MSG_EQ ((gossiped.GetLocationGossip ()[0] == gossip), true, "Gossiped entry intact");
+    RrepHeader moved = gossiped;
+    gossiped.AddLocationGossip (gossip);
+    gossip.m_positionY = 251;
+    moved.AddLocationGossip (gossip);
+    NS_TEST_EXPECT_MSG_EQ ((moved == gossiped), false, "Gossiped entries compared one by one");
+
+    h.SetChannelLoad (0.5, 1.7);
+    RrepHeader loaded = RoundTrip (h, 19 + 10 + 1 + 12 + 2);
+    NS_TEST_EXPECT_MSG_EQ (loaded.HasChannelLoad (), true, "Channel load flag");
+    NS_TEST_EXPECT_MSG_EQ_TOL (loaded.GetMacQueueOccupancy (), 0.5, 1.0 / 255, "MAC queue occupancy");
+    NS_TEST_EXPECT_MSG_EQ (loaded.GetChannelBusy (), 1, "Channel busy fraction is clamped");
   }
 };
 
@@ -296,6 +535,526 @@ struct RerrHeaderTest : public TestCase
   }
 };
 
+//-----------------------------------------------------------------------------
+/// Unit test for duplicate packet detection in Bloom filter mode
+struct DpdBloomTest : public TestCase
+{
+  DpdBloomTest () : TestCase ("DpdBloom"),
+                    dpd (Seconds (10))
+  {
+  }
+  virtual void DoRun ();
+  /// Check that old packets are forgotten
+  void CheckForgotten ();
+  /// Check that a duplicate from the previous generation is not remembered again
+  void CheckPrevious ();
+  /// Check that the packet seen at CheckForgotten is forgotten despite its duplicate
+  void CheckNotRefreshed ();
+
+  /// Duplicate packet detection
+  DuplicatePacketDetection dpd;
+  /// Remembered packets
+  std::vector<Ptr<Packet> > packets;
+};
+
+void
+DpdBloomTest::DoRun ()
+{
+  dpd.SetBloomParameters (1000, 0.01);
+  dpd.SetMode (DPD_BLOOM);
+  NS_TEST_EXPECT_MSG_EQ (dpd.GetMode (), DPD_BLOOM, "trivial");
+  uint32_t memory = dpd.GetBloomMemoryBytes ();
+  NS_TEST_EXPECT_MSG_GT (memory, 0, "Filter allocated");
+
+  Ipv4Header h;
+  h.SetSource (Ipv4Address ("10.0.0.1"));
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      packets.push_back (Create<Packet> ());
+      dpd.IsDuplicate (packets.back (), h);
+    }
+  uint32_t falseNegatives = 0;
+  for (uint32_t i = 0; i < packets.size (); ++i)
+    {
+      if (!dpd.IsDuplicate (packets[i], h))
+        {
+          falseNegatives++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (falseNegatives, 0, "Bloom filters have no false negatives");
+
+  uint32_t falsePositives = 0;
+  for (uint32_t i = 0; i < 500; ++i)
+    {
+      if (dpd.IsDuplicate (Create<Packet> (), h))
+        {
+          falsePositives++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_LT (falsePositives, 25, "False positive rate close to the target");
+
+  // Memory does not depend on the number of packets seen
+  for (uint32_t i = 0; i < 20000; ++i)
+    {
+      dpd.IsDuplicate (Create<Packet> (), h);
+    }
+  NS_TEST_EXPECT_MSG_EQ (dpd.GetBloomMemoryBytes (), memory, "Constant memory");
+
+  Simulator::Schedule (Seconds (25), &DpdBloomTest::CheckForgotten, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+DpdBloomTest::CheckForgotten ()
+{
+  Ipv4Header h;
+  h.SetSource (Ipv4Address ("10.0.0.1"));
+  NS_TEST_EXPECT_MSG_EQ (dpd.IsDuplicate (packets.front (), h), false, "Forgotten after two periods");
+  NS_TEST_EXPECT_MSG_EQ (dpd.IsDuplicate (packets.front (), h), true, "Remembered again");
+  Simulator::Schedule (Seconds (12), &DpdBloomTest::CheckPrevious, this);
+}
+
+void
+DpdBloomTest::CheckPrevious ()
+{
+  Ipv4Header h;
+  h.SetSource (Ipv4Address ("10.0.0.1"));
+  NS_TEST_EXPECT_MSG_EQ (dpd.IsDuplicate (packets.front (), h), true, "Remembered by the previous generation");
+  Simulator::Schedule (Seconds (13), &DpdBloomTest::CheckNotRefreshed, this);
+}
+
+void
+DpdBloomTest::CheckNotRefreshed ()
+{
+  Ipv4Header h;
+  h.SetSource (Ipv4Address ("10.0.0.1"));
+  NS_TEST_EXPECT_MSG_EQ (dpd.IsDuplicate (packets.front (), h), false, "Duplicates do not extend the lifetime");
+}
+
+//-----------------------------------------------------------------------------
+/// Unit test for the link quality table
+struct LinkQualityTest : public TestCase
+{
+  LinkQualityTest () : TestCase ("LinkQuality"),
+                       table (Seconds (10))
+  {
+  }
+  virtual void DoRun ();
+  /// Check the decay after one half-life
+  void CheckDecay ();
+
+  /// Link quality table
+  LinkQualityTable table;
+  /// A receiver with errors
+  Mac48Address bad;
+  /// A receiver without errors
+  Mac48Address good;
+};
+
+void
+LinkQualityTest::DoRun ()
+{
+  bad = Mac48Address ("00:00:00:00:00:01");
+  good = Mac48Address ("00:00:00:00:00:02");
+  table.RecordTxError (bad);
+  table.RecordTxError (bad);
+  NS_TEST_EXPECT_MSG_EQ (table.GetSize (), 1, "trivial");
+  NS_TEST_EXPECT_MSG_EQ_TOL (table.GetErrorRate (bad), 2 * std::log (2.0) / 10, 1e-9, "Fresh errors");
+  NS_TEST_EXPECT_MSG_EQ (table.GetErrorRate (good), 0, "No error on this link");
+  Simulator::Schedule (Seconds (10), &LinkQualityTest::CheckDecay, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+LinkQualityTest::CheckDecay ()
+{
+  NS_TEST_EXPECT_MSG_EQ_TOL (table.GetErrorRate (bad), std::log (2.0) / 10, 1e-9, "Halved after one half-life");
+  NS_TEST_EXPECT_MSG_EQ_TOL (table.GetNodeErrorRate (), std::log (2.0) / 10, 1e-9, "Node rate decays too");
+  table.RecordTxError (good);
+  NS_TEST_EXPECT_MSG_GT (table.GetErrorRate (good), table.GetErrorRate (bad), "Recent errors weigh more");
+}
+
+//-----------------------------------------------------------------------------
+/// Unit test for the location cache
+struct LocationCacheTest : public TestCase
+{
+  LocationCacheTest () : TestCase ("LocationCache"),
+                         cache (2, Seconds (30))
+  {
+  }
+  virtual void DoRun ();
+  /// Check the confidence of aging positions
+  void CheckAging ();
+  /// Check positions older than the maximum age are forgotten
+  void CheckExpired ();
+
+  /// Location cache
+  LocationCache cache;
+};
+
+void
+LocationCacheTest::DoRun ()
+{
+  LocationCache::Location location;
+  NS_TEST_EXPECT_MSG_EQ (cache.Update (Ipv4Address ("10.0.0.1"), Vector (1, 0, 0), Seconds (0)), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (cache.Update (Ipv4Address ("10.0.0.2"), Vector (2, 0, 0), Seconds (0)), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (cache.Lookup (Ipv4Address ("10.0.0.1"), location), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (cache.Update (Ipv4Address ("10.0.0.3"), Vector (3, 0, 0), Seconds (0)), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 2, "Bounded");
+  NS_TEST_EXPECT_MSG_EQ (cache.Lookup (Ipv4Address ("10.0.0.2"), location), false, "Least recently used evicted");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetEvictions (), 1, "Eviction counted");
+  NS_TEST_EXPECT_MSG_EQ (cache.Lookup (Ipv4Address ("10.0.0.1"), location), true, "Recently used kept");
+  NS_TEST_EXPECT_MSG_EQ (cache.Update (Ipv4Address ("10.0.0.3"), Vector (9, 0, 0), Seconds (-1)), false, "Older sample ignored");
+  cache.SetVelocity (Ipv4Address ("10.0.0.3"), Vector (1, 0, 0));
+  cache.SetMaxExtrapolation (Seconds (5));
+  Simulator::Schedule (Seconds (10), &LocationCacheTest::CheckAging, this);
+  Simulator::Schedule (Seconds (31), &LocationCacheTest::CheckExpired, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+LocationCacheTest::CheckAging ()
+{
+  LocationCache::Location location;
+  NS_TEST_EXPECT_MSG_EQ (cache.Lookup (Ipv4Address ("10.0.0.3"), location), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (location.m_position.x, 3, "Cached position");
+  NS_TEST_EXPECT_MSG_EQ (cache.GetEstimate (location).x, 8, "Extrapolated by at most MaxExtrapolation");
+  NS_TEST_EXPECT_MSG_EQ_TOL (cache.GetErrorRadius (location), 200, 1e-9, "Radius grows with the age");
+  NS_TEST_EXPECT_MSG_EQ (cache.IsConfident (location), true, "Within the confidence radius");
+  cache.SetConfidenceRadius (100);
+  NS_TEST_EXPECT_MSG_EQ (cache.IsConfident (location), false, "Too uncertain");
+}
+
+void
+LocationCacheTest::CheckExpired ()
+{
+  LocationCache::Location location;
+  NS_TEST_EXPECT_MSG_EQ (cache.Lookup (Ipv4Address ("10.0.0.3"), location), false, "Expired");
+  cache.Purge ();
+  NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 0, "Purged");
+}
+
+//-----------------------------------------------------------------------------
+/// Unit test for the channel load monitor
+struct ChannelLoadTest : public TestCase
+{
+  ChannelLoadTest () : TestCase ("ChannelLoad"),
+                       monitor (Seconds (1))
+  {
+  }
+  virtual void DoRun ();
+  /// Report PHY state periods within the first window
+  void FirstWindow ();
+  /// Check the first window once it is over, report a period straddling the windows
+  void SecondWindow ();
+  /// Check the second window
+  void CheckSecondWindow ();
+  /// Check an idle gap longer than a window
+  void CheckIdleGap ();
+  /// Check a period longer than a window
+  void CheckLongPeriod ();
+
+  /// Channel load monitor
+  ChannelLoadMonitor monitor;
+};
+
+void
+ChannelLoadTest::DoRun ()
+{
+  ChannelLoadMonitor idle (Seconds (1));
+  NS_TEST_EXPECT_MSG_EQ (idle.GetChannelBusy (), 0, "No interface");
+
+  NodeContainer nodes;
+  nodes.Create (1);
+  YansWifiPhyHelper phy;
+  phy.SetChannel (YansWifiChannelHelper::Default ().Create ());
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  WifiHelper wifi;
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  monitor.AddDevice (DynamicCast<WifiNetDevice> (devices.Get (0)));
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetMacQueueOccupancy (), 0, "Empty MAC queues");
+
+  Simulator::Schedule (Seconds (0.5), &ChannelLoadTest::FirstWindow, this);
+  Simulator::Schedule (Seconds (1.2), &ChannelLoadTest::SecondWindow, this);
+  Simulator::Schedule (Seconds (2.5), &ChannelLoadTest::CheckSecondWindow, this);
+  Simulator::Schedule (Seconds (4.5), &ChannelLoadTest::CheckIdleGap, this);
+  Simulator::Schedule (Seconds (7), &ChannelLoadTest::CheckLongPeriod, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+ChannelLoadTest::FirstWindow ()
+{
+  monitor.NotifyPhyState (Seconds (0.2), Seconds (0.25), WifiPhyState::RX);
+  monitor.NotifyPhyState (Seconds (0.45), Seconds (0.05), WifiPhyState::IDLE);
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetChannelBusy (), 0, "No complete window yet");
+}
+
+void
+ChannelLoadTest::SecondWindow ()
+{
+  monitor.NotifyPhyState (Seconds (0.9), Seconds (0.3), WifiPhyState::TX);
+  NS_TEST_EXPECT_MSG_EQ_TOL (monitor.GetChannelBusy (), 0.35, 1e-9, "The part before the roll counts in the first window");
+}
+
+void
+ChannelLoadTest::CheckSecondWindow ()
+{
+  NS_TEST_EXPECT_MSG_EQ_TOL (monitor.GetChannelBusy (), 0.2, 1e-9, "Only the part within the second window counts");
+}
+
+void
+ChannelLoadTest::CheckIdleGap ()
+{
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetChannelBusy (), 0, "Idle windows in between");
+}
+
+void
+ChannelLoadTest::CheckLongPeriod ()
+{
+  // Windows start at 4.5 s, the period covers half of the first one and all of the second
+  monitor.NotifyPhyState (Seconds (5), Seconds (2), WifiPhyState::RX);
+  NS_TEST_EXPECT_MSG_EQ_TOL (monitor.GetChannelBusy (), 1, 1e-9, "Window covered by the period");
+}
+
+//-----------------------------------------------------------------------------
+/// Test of the SNR measured on the hellos received over Wi-Fi
+struct LinkSnrTest : public TestCase
+{
+  LinkSnrTest () : TestCase ("LinkSnr")
+  {
+  }
+  virtual void DoRun ();
+  /// Check the links measured with the SNR feature enabled on the first node only
+  void CheckMeasured ();
+  /// Check that the first node no longer measures the link once the feature is disabled
+  void CheckDisabled ();
+
+  /// The two nodes
+  NodeContainer nodes;
+  /// Routing protocols of the two nodes
+  Ptr<RoutingProtocol> protocols[2];
+  /// Addresses of the two nodes
+  Ipv4InterfaceContainer interfaces;
+  /// SNR of the link measured by the first node at the first check
+  double snr;
+};
+
+void
+LinkSnrTest::DoRun ()
+{
+  nodes.Create (2);
+  MobilityHelper mobility;
+  mobility.Install (nodes);
+  nodes.Get (1)->GetObject<MobilityModel> ()->SetPosition (Vector (50, 0, 0));
+  YansWifiPhyHelper phy;
+  phy.SetChannel (YansWifiChannelHelper::Default ().Create ());
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  WifiHelper wifi;
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  aodvKmeansHelper aodvKmeans;
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (aodvKmeans);
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  interfaces = address.Assign (devices);
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      protocols[i] = DynamicCast<RoutingProtocol> (nodes.Get (i)->GetObject<Ipv4> ()->GetRoutingProtocol ());
+    }
+  protocols[0]->SetAttribute ("SnrFeature", StringValue ("Enabled=true"));
+
+  Simulator::Schedule (Seconds (5), &LinkSnrTest::CheckMeasured, this);
+  Simulator::Schedule (Seconds (10), &LinkSnrTest::CheckDisabled, this);
+  Simulator::Stop (Seconds (11));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+LinkSnrTest::CheckMeasured ()
+{
+  NS_TEST_EXPECT_MSG_EQ (protocols[0]->GetLinkSnr (interfaces.GetAddress (1), snr), true, "Hellos measured");
+  NS_TEST_EXPECT_MSG_GT (snr, 0, "Neighbor well within range");
+  double other;
+  NS_TEST_EXPECT_MSG_EQ (protocols[1]->GetLinkSnr (interfaces.GetAddress (0), other), false,
+                         "Not measured with the SNR feature disabled");
+  protocols[0]->SetAttribute ("SnrFeature", StringValue ("Enabled=false"));
+  // moving the neighbor away would change the SNR of the next hellos
+  nodes.Get (1)->GetObject<MobilityModel> ()->SetPosition (Vector (70, 0, 0));
+}
+
+void
+LinkSnrTest::CheckDisabled ()
+{
+  double last;
+  NS_TEST_EXPECT_MSG_EQ (protocols[0]->GetLinkSnr (interfaces.GetAddress (1), last), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (last, snr, "No longer measured");
+}
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for the route discovery trace sources, on a chain of three nodes
+ */
+struct DiscoveryTraceTest : public TestCase
+{
+  DiscoveryTraceTest () : TestCase ("DiscoveryTrace")
+  {
+    for (uint32_t i = 0; i < 3; i++)
+      {
+        originated[i] = 0;
+        forwarded[i] = 0;
+        rrepSent[i] = 0;
+        rrepReceived[i] = 0;
+        for (uint32_t r = 0; r < 4; r++)
+          {
+            dropped[i][r] = 0;
+          }
+      }
+  }
+  virtual void DoRun ();
+  /// Send a packet from the first node to the last one
+  void Send ();
+  /**
+   * Count an originated RREQ
+   * \param context the index of the node
+   * \param header the RREQ
+   */
+  void RreqOriginated (std::string context, const RreqHeader & header)
+  {
+    originated[std::stoi (context)]++;
+  }
+  /**
+   * Count a forwarded RREQ
+   * \param context the index of the node
+   * \param header the RREQ
+   */
+  void RreqForwarded (std::string context, const RreqHeader & header)
+  {
+    forwarded[std::stoi (context)]++;
+  }
+  /**
+   * Count a dropped RREQ
+   * \param context the index of the node
+   * \param header the RREQ
+   * \param reason the reason of the drop
+   */
+  void RreqDropped (std::string context, const RreqHeader & header, RreqDropReason reason)
+  {
+    dropped[std::stoi (context)][reason]++;
+  }
+  /**
+   * Count an originated or forwarded RREP
+   * \param context the index of the node
+   * \param header the RREP
+   * \param neighbor the next hop
+   */
+  void RrepSent (std::string context, const RrepHeader & header, Ipv4Address neighbor)
+  {
+    rrepSent[std::stoi (context)]++;
+  }
+  /**
+   * Count a received RREP
+   * \param context the index of the node
+   * \param header the RREP
+   * \param neighbor the sender
+   */
+  void RrepReceived (std::string context, const RrepHeader & header, Ipv4Address neighbor)
+  {
+    rrepReceived[std::stoi (context)]++;
+  }
+
+  /// The three nodes, 120 m apart
+  NodeContainer nodes;
+  /// Addresses of the nodes
+  Ipv4InterfaceContainer interfaces;
+  /// RREQs originated by each node
+  uint32_t originated[3];
+  /// RREQs forwarded by each node
+  uint32_t forwarded[3];
+  /// RREQs dropped by each node, per reason
+  uint32_t dropped[3][4];
+  /// RREPs sent by each node
+  uint32_t rrepSent[3];
+  /// RREPs received by each node
+  uint32_t rrepReceived[3];
+};
+
+void
+DiscoveryTraceTest::DoRun ()
+{
+  nodes.Create (3);
+  MobilityHelper mobility;
+  mobility.Install (nodes);
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      nodes.Get (i)->GetObject<MobilityModel> ()->SetPosition (Vector (120.0 * i, 0, 0));
+    }
+  // the radio settings of the chain regression test, under which only neighbors hear each other
+  YansWifiPhyHelper phy;
+  phy.DisablePreambleDetectionModel ();
+  phy.SetErrorRateModel ("ns3::YansErrorRateModel");
+  phy.SetChannel (YansWifiChannelHelper::Default ().Create ());
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  WifiHelper wifi;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager", "DataMode", StringValue ("OfdmRate6Mbps"));
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  // without hellos the middle node has no route to answer the RREQ with
+  aodvKmeansHelper aodvKmeans;
+  aodvKmeans.Set ("EnableHello", BooleanValue (false));
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (aodvKmeans);
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  interfaces = address.Assign (devices);
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<RoutingProtocol> protocol = DynamicCast<RoutingProtocol> (nodes.Get (i)->GetObject<Ipv4> ()->GetRoutingProtocol ());
+      std::ostringstream context;
+      context << i;
+      protocol->TraceConnect ("RreqOriginated", context.str (), MakeCallback (&DiscoveryTraceTest::RreqOriginated, this));
+      protocol->TraceConnect ("RreqForwarded", context.str (), MakeCallback (&DiscoveryTraceTest::RreqForwarded, this));
+      protocol->TraceConnect ("RreqDropped", context.str (), MakeCallback (&DiscoveryTraceTest::RreqDropped, this));
+      protocol->TraceConnect ("RrepSent", context.str (), MakeCallback (&DiscoveryTraceTest::RrepSent, this));
+      protocol->TraceConnect ("RrepReceived", context.str (), MakeCallback (&DiscoveryTraceTest::RrepReceived, this));
+    }
+
+  Simulator::Schedule (Seconds (1), &DiscoveryTraceTest::Send, this);
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // the first RREQ, with TTL 1, dies at the middle node, the second one reaches the last node
+  NS_TEST_EXPECT_MSG_EQ (originated[0], 2, "Expanding ring search");
+  NS_TEST_EXPECT_MSG_EQ (dropped[1][RREQ_DROP_TTL], 1, "TTL exhausted at the middle node");
+  NS_TEST_EXPECT_MSG_EQ (forwarded[1], 1, "Second RREQ forwarded by the middle node");
+  NS_TEST_EXPECT_MSG_EQ (dropped[0][RREQ_DROP_DUPLICATE], 1, "Own RREQ heard back");
+  NS_TEST_EXPECT_MSG_EQ (dropped[0][RREQ_DROP_BLACKLISTED] + dropped[0][RREQ_DROP_LOOP], 0, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (forwarded[2], 0, "The destination replies");
+  NS_TEST_EXPECT_MSG_EQ (rrepSent[2], 1, "RREP originated by the destination");
+  NS_TEST_EXPECT_MSG_EQ (rrepSent[1], 1, "RREP forwarded by the middle node");
+  NS_TEST_EXPECT_MSG_EQ (rrepReceived[0], 1, "RREP back at the origin");
+}
+
+void
+DiscoveryTraceTest::Send ()
+{
+  Ptr<Socket> socket = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  socket->Bind ();
+  socket->SendTo (Create<Packet> (64), 0, InetSocketAddress (interfaces.GetAddress (2), 9));
+}
+
 /**
  * \ingroup aodvKmeans-test
  * \ingroup tests
@@ -494,6 +1253,158 @@ aodvKmeansRqueueTest::CheckTimeout ()
 {
   NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 0, "Must be empty now");
 }
+//-----------------------------------------------------------------------------
+/// Unit test for RequestQueue in fair queuing mode
+struct aodvKmeansRqueueFairTest : public TestCase
+{
+  aodvKmeansRqueueFairTest () : TestCase ("RqueueFair"),
+                          q (8, Seconds (30)),
+                          drops (0),
+                          flowBytes (0)
+  {
+  }
+  virtual void DoRun ();
+  /// Check that expired packets take their flow along
+  void CheckPurge ();
+  /**
+   * Unicast test function
+   * \param route the IPv4 route
+   * \param packet the packet
+   * \param header the IPv4 header
+   */
+  void Unicast (Ptr<Ipv4Route> route, Ptr<const Packet> packet, const Ipv4Header & header)
+  {
+  }
+  /**
+   * Error test function
+   * \param p The packet
+   * \param h The header
+   * \param e the socket error
+   */
+  void Error (Ptr<const Packet> p, const Ipv4Header & h, Socket::SocketErrno e)
+  {
+  }
+  /**
+   * Drop test function
+   * \param p The packet
+   * \param h The header
+   * \param reason the reason of the drop
+   * \param c the priority class
+   */
+  void Drop (Ptr<const Packet> p, const Ipv4Header & h, std::string reason, uint8_t c)
+  {
+    drops++;
+  }
+  /**
+   * Enqueue a fresh packet
+   * \param src the source address
+   * \param dst the destination address
+   * \param dscp the DSCP of the packet
+   */
+  void Add (Ipv4Address src, Ipv4Address dst, Ipv4Header::DscpType dscp);
+
+  /// Request queue
+  RequestQueue q;
+  /// Number of dropped packets
+  uint32_t drops;
+  /// Memory held by the queue with a flow active
+  uint64_t flowBytes;
+};
+
+void
+aodvKmeansRqueueFairTest::Add (Ipv4Address src, Ipv4Address dst, Ipv4Header::DscpType dscp)
+{
+  Ipv4Header h;
+  h.SetSource (src);
+  h.SetDestination (dst);
+  h.SetDscp (dscp);
+  Ipv4RoutingProtocol::UnicastForwardCallback ucb = MakeCallback (&aodvKmeansRqueueFairTest::Unicast, this);
+  Ipv4RoutingProtocol::ErrorCallback ecb = MakeCallback (&aodvKmeansRqueueFairTest::Error, this);
+  QueueEntry e (Create<Packet> (100), h, ucb, ecb);
+  q.Enqueue (e);
+}
+
+void
+aodvKmeansRqueueFairTest::DoRun ()
+{
+  NS_TEST_EXPECT_MSG_EQ (RequestQueue::GetPriorityClass (Ipv4Header::DSCP_EF), CLASS_HIGH, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (RequestQueue::GetPriorityClass (Ipv4Header::DscpDefault), CLASS_NORMAL, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (RequestQueue::GetPriorityClass (Ipv4Header::DSCP_CS1), CLASS_BACKGROUND, "trivial");
+
+  q.SetScheduling (QUEUE_FAIR);
+  q.SetDropCallback (MakeCallback (&aodvKmeansRqueueFairTest::Drop, this));
+  Ipv4Address src ("4.3.2.1");
+  Ipv4Address chatty ("1.1.1.1");
+  Ipv4Address quiet ("2.2.2.2");
+
+  // A full queue evicts from the longest flow, not from the short one
+  Add (src, quiet, Ipv4Header::DscpDefault);
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      Add (src, chatty, Ipv4Header::DscpDefault);
+    }
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 8, "Queue is full");
+  NS_TEST_EXPECT_MSG_EQ (drops, 3, "Three packets of the chatty flow dropped");
+  NS_TEST_EXPECT_MSG_EQ (q.Find (quiet), true, "Short flow survives");
+
+  // Background traffic is dropped before normal traffic
+  Add (src, quiet, Ipv4Header::DSCP_CS1);
+  NS_TEST_EXPECT_MSG_EQ (drops, 4, "Arriving background packet dropped");
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 8, "Queue is full");
+
+  // High priority packets are dequeued first
+  q.DropPacketWithDst (quiet);
+  drops = 0;
+  Add (src, quiet, Ipv4Header::DscpDefault);
+  Add (src, quiet, Ipv4Header::DSCP_EF);
+  QueueEntry e;
+  NS_TEST_EXPECT_MSG_EQ (q.Dequeue (quiet, e), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (e.GetIpv4Header ().GetDscp (), Ipv4Header::DSCP_EF, "EF served first");
+  NS_TEST_EXPECT_MSG_EQ (q.Dequeue (quiet, e), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (e.GetIpv4Header ().GetDscp (), Ipv4Header::DscpDefault, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (q.Dequeue (quiet, e), false, "trivial");
+
+  // Flows of one destination share the service in round robin
+  q.DropPacketWithDst (chatty);
+  q.SetFlowKey (FLOW_BY_FIVE_TUPLE);
+  q.SetQuantum (100);
+  Ipv4Address src2 ("4.3.2.2");
+  Add (src, chatty, Ipv4Header::DscpDefault);
+  Add (src, chatty, Ipv4Header::DscpDefault);
+  Add (src2, chatty, Ipv4Header::DscpDefault);
+  NS_TEST_EXPECT_MSG_EQ (q.Dequeue (chatty, e), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (e.GetIpv4Header ().GetSource (), src, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (q.Dequeue (chatty, e), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (e.GetIpv4Header ().GetSource (), src2, "Second flow served before the first flow's backlog");
+  NS_TEST_EXPECT_MSG_EQ (q.Dequeue (chatty, e), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (e.GetIpv4Header ().GetSource (), src, "trivial");
+
+  // Per-flow quota
+  q.SetFlowQuota (2);
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      Add (src, chatty, Ipv4Header::DscpDefault);
+    }
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 2, "Flow limited to its quota");
+
+  // Flows are forgotten along with their last packet
+  flowBytes = q.GetMemoryBytes ();
+  q.DropPacketWithDst (chatty);
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 0, "trivial");
+  NS_TEST_EXPECT_MSG_LT (q.GetMemoryBytes (), flowBytes, "Dropped flow forgotten");
+  Add (src, quiet, Ipv4Header::DscpDefault);
+  flowBytes = q.GetMemoryBytes ();
+  Simulator::Schedule (q.GetQueueTimeout () + Seconds (1), &aodvKmeansRqueueFairTest::CheckPurge, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+aodvKmeansRqueueFairTest::CheckPurge ()
+{
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 0, "Expired");
+  NS_TEST_EXPECT_MSG_LT (q.GetMemoryBytes (), flowBytes, "Expired flow forgotten");
+}
 
 /**
  * \ingroup aodvKmeans-test
@@ -577,6 +1488,33 @@ struct aodvKmeansRtableEntryTest : public TestCase
     NS_TEST_EXPECT_MSG_EQ (rt.IsPrecursorListEmpty (), true, "trivial");
     rt.GetPrecursors (prec);
     NS_TEST_EXPECT_MSG_EQ (prec.size (), 2, "trivial");
+
+    NS_TEST_EXPECT_MSG_EQ (rt.HasSnr (), false, "trivial");
+    rt.UpdateSnr (20, 0.25);
+    NS_TEST_EXPECT_MSG_EQ (rt.GetSnr (), 20, "First sample taken as is");
+    rt.UpdateSnr (12, 0.25);
+    NS_TEST_EXPECT_MSG_EQ_TOL (rt.GetSnr (), 18, 1e-9, "Moving average");
+
+    // an entry rebuilt from a reply keeps what the reply does not carry
+    rt.SetChannelLoad (0.5, 0.25);
+    rt.SetPositionX (10);
+    RoutingTableEntry reply (dev, Ipv4Address ("1.2.3.4"), true, 11, iface, 1, Ipv4Address ("1.2.3.4"), Seconds (10),
+                             0, 30, 40, 5);
+    reply.KeepMeasurements (rt, true, false);
+    NS_TEST_EXPECT_MSG_EQ (reply.HasSnr (), true, "SNR of the link kept");
+    NS_TEST_EXPECT_MSG_EQ_TOL (reply.GetSnr (), 18, 1e-9, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (reply.HasChannelLoad (), true, "Channel load kept");
+    NS_TEST_EXPECT_MSG_EQ (reply.GetChannelBusy (), 0.25, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (reply.GetPositionX (), 30, "Position of the reply taken");
+    RoutingTableEntry loaded (dev, Ipv4Address ("1.2.3.4"), true, 11, iface, 1, Ipv4Address ("1.2.3.4"), Seconds (10));
+    loaded.SetChannelLoad (0, 0.75);
+    loaded.SetPositionUnknown ();
+    loaded.KeepMeasurements (rt, false, true);
+    NS_TEST_EXPECT_MSG_EQ (loaded.GetChannelBusy (), 0.75, "Channel load of the reply taken");
+    NS_TEST_EXPECT_MSG_EQ (loaded.HasPosition (), true, "Position kept");
+    NS_TEST_EXPECT_MSG_EQ (loaded.GetPositionX (), 10, "trivial");
+    RoutingTableEntry fresh;
+    NS_TEST_EXPECT_MSG_EQ (fresh.HasChannelLoad (), false, "trivial");
     Simulator::Destroy ();
   }
 };
@@ -641,6 +1579,786 @@ struct aodvKmeansRtableTest : public TestCase
   }
 };
 
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for the choice of the number of clusters of forwarder selection
+ */
+struct aodvKmeansRtableKmeansTest : public TestCase
+{
+  aodvKmeansRtableKmeansTest () : TestCase ("RtableKmeans")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RoutingTable rtable (Seconds (2));
+    KmeansParameters parameters;
+    NS_TEST_EXPECT_MSG_EQ (rtable.Kmeans (Ipv4Address ("10.0.1.1"), 0, 0, parameters).size (), 0, "No candidate");
+
+    // 40 neighbors in 4 groups, 1 km apart
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface;
+    for (uint32_t i = 0; i < 40; i++)
+      {
+        Ipv4Address neighbor (0x0a000001 + i);
+        RoutingTableEntry rt (dev, neighbor, true, 1, iface, 1, neighbor, Seconds (10));
+        rt.SetPositionX ((i % 4) * 1000.0 + i);
+        rt.SetPositionY (0);
+        rt.SetFreeSpace (10);
+        rtable.AddRoute (rt);
+      }
+    parameters.m_clusters = 1;
+    NS_TEST_EXPECT_MSG_EQ (rtable.Kmeans (Ipv4Address ("10.0.1.1"), 0, 0, parameters).size (), 40, "A single cluster");
+    parameters.m_clusterCount = KMEANS_K_TARGET;
+    parameters.m_targetForwarders = 40;
+    NS_TEST_EXPECT_MSG_EQ (rtable.Kmeans (Ipv4Address ("10.0.1.1"), 0, 0, parameters).size (), 40,
+                           "Clusters sized for the target forwarders");
+    parameters.m_maxForwarders = 3;
+    KmeansQuality quality;
+    std::vector<Ipv4Address> selected = rtable.Kmeans (Ipv4Address ("10.0.1.1"), 0, 0, parameters,
+                                                       Callback<double, Ipv4Address> (), &quality);
+    NS_TEST_EXPECT_MSG_EQ (quality.m_candidates, 40, "Candidates counted");
+    NS_TEST_EXPECT_MSG_EQ (quality.m_clusters, 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (quality.m_iterations, 1, "A single cluster is stable after one iteration");
+    NS_TEST_EXPECT_MSG_GT (quality.m_inertia, 0, "Candidates spread around the center");
+    NS_TEST_EXPECT_MSG_EQ (selected.size (), 3, "Forwarders within the airtime budget");
+    NS_TEST_EXPECT_MSG_EQ (selected[0], Ipv4Address ("10.0.0.1"), "Closest forwarders kept");
+    NS_TEST_EXPECT_MSG_EQ (selected[2], Ipv4Address ("10.0.0.9"), "Closest forwarders kept");
+
+    std::vector<Ipv4Address> previous;
+    previous.push_back (Ipv4Address ("10.0.0.9"));
+    previous.push_back (Ipv4Address ("10.0.0.2"));
+    previous.push_back (Ipv4Address ("10.0.0.1"));
+    NS_TEST_EXPECT_MSG_EQ_TOL (RoutingProtocol::Jaccard (previous, selected), 0.5, 1e-9, "2 common of 4");
+    NS_TEST_EXPECT_MSG_EQ_TOL (RoutingProtocol::Jaccard (selected, selected), 1, 1e-9, "Same selection");
+
+    // a candidate at an unknown position counts as an average one, not as one at the origin
+    RoutingTableEntry unknown (dev, Ipv4Address ("10.0.0.41"), true, 1, iface, 1, Ipv4Address ("10.0.0.41"), Seconds (10));
+    unknown.SetFreeSpace (10);
+    unknown.SetPositionUnknown ();
+    NS_TEST_EXPECT_MSG_EQ (unknown.HasPosition (), false, "trivial");
+    rtable.AddRoute (unknown);
+    parameters.m_targetForwarders = 41;
+    selected = rtable.Kmeans (Ipv4Address ("10.0.1.1"), 0, 0, parameters);
+    NS_TEST_EXPECT_MSG_EQ (selected.size (), 3, "trivial");
+    NS_TEST_EXPECT_MSG_EQ ((std::find (selected.begin (), selected.end (), Ipv4Address ("10.0.0.41")) == selected.end ()), true,
+                           "Not taken for a candidate at the origin");
+
+    // 20 neighbors in 2 groups, 1 km apart, clustered from a fixed stream
+    RoutingTable grouped (Seconds (2));
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+    random->SetStream (1);
+    grouped.SetRandomVariable (random);
+    for (uint32_t i = 0; i < 20; i++)
+      {
+        Ipv4Address neighbor (0x0a000101 + i);
+        RoutingTableEntry rt (dev, neighbor, true, 1, iface, 1, neighbor, Seconds (10));
+        rt.SetPositionX ((i % 2) * 1000.0 + i);
+        rt.SetPositionY (0);
+        rt.SetFreeSpace (10);
+        grouped.AddRoute (rt);
+      }
+    KmeansParameters split;
+    split.m_clusterCount = KMEANS_K_TARGET;
+    split.m_targetForwarders = 10;
+    split.m_maxClusters = 2;
+    selected = grouped.Kmeans (Ipv4Address ("10.0.1.1"), 0, 0, split, Callback<double, Ipv4Address> (), &quality);
+    NS_TEST_EXPECT_MSG_EQ (quality.m_clusters, 2, "One cluster per target forwarders");
+    NS_TEST_EXPECT_MSG_EQ (selected.size (), 10, "The whole closest group");
+    for (std::vector<Ipv4Address>::const_iterator i = selected.begin (); i != selected.end (); ++i)
+      {
+        NS_TEST_EXPECT_MSG_EQ ((i->Get () - 0x0a000101) % 2, 0, "Only the group closest to the destination");
+      }
+    split.m_clusterCount = KMEANS_K_ELBOW;
+    selected = grouped.Kmeans (Ipv4Address ("10.0.1.1"), 0, 0, split, Callback<double, Ipv4Address> (), &quality);
+    NS_TEST_EXPECT_MSG_EQ (quality.m_clusters, 2, "Separate groups are worth one cluster each");
+    NS_TEST_EXPECT_MSG_EQ (selected.size (), 10, "The whole closest group");
+    for (std::vector<Ipv4Address>::const_iterator i = selected.begin (); i != selected.end (); ++i)
+      {
+        NS_TEST_EXPECT_MSG_EQ ((i->Get () - 0x0a000101) % 2, 0, "Only the group closest to the destination");
+      }
+
+    // a candidate that never advertised its channel load counts as an average one, not as an idle one
+    RoutingTable loaded (Seconds (2));
+    KmeansParameters busy;
+    busy.m_clusters = 1;
+    busy.m_maxForwarders = 1;
+    FeatureDescriptor disabled;
+    disabled.m_enabled = false;
+    for (uint32_t f = 0; f < FeatureSpace::FEATURE_COUNT; f++)
+      {
+        busy.m_featureSpace.SetDescriptor (FeatureSpace::Feature (f), disabled);
+      }
+    FeatureDescriptor channelBusy;
+    NS_TEST_EXPECT_MSG_EQ (channelBusy.Parse ("Normalization=FixedRange|Min=0|Max=1|Ideal=0"), true, "trivial");
+    busy.m_featureSpace.SetDescriptor (FeatureSpace::FEATURE_CHANNEL_BUSY, channelBusy);
+    for (uint32_t i = 0; i < 3; i++)
+      {
+        Ipv4Address neighbor (0x0a000201 + i);
+        RoutingTableEntry rt (dev, neighbor, true, 1, iface, 1, neighbor, Seconds (10));
+        if (i < 2)
+          {
+            rt.SetChannelLoad (0, 0.2 + 0.4 * i);
+          }
+        loaded.AddRoute (rt);
+      }
+    NS_TEST_EXPECT_MSG_EQ (loaded.Kmeans (Ipv4Address ("10.0.1.1"), 0, 0, busy)[0], Ipv4Address ("10.0.2.1"),
+                           "Least busy advertised channel");
+    Simulator::Destroy ();
+  }
+};
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for the adaptive hello interval and the lifetime advertised by hellos
+ */
+struct HelloIntervalTest : public TestCase
+{
+  HelloIntervalTest () : TestCase ("HelloInterval")
+  {
+  }
+  virtual void DoRun ()
+  {
+    Time minInterval = MilliSeconds (500);
+    Time maxInterval = Seconds (5);
+    NS_TEST_EXPECT_MSG_EQ (RoutingProtocol::AdaptHelloInterval (Seconds (2), true, minInterval, maxInterval), Seconds (1),
+                           "Halved on a topology change");
+    NS_TEST_EXPECT_MSG_EQ (RoutingProtocol::AdaptHelloInterval (Seconds (0.6), true, minInterval, maxInterval), minInterval,
+                           "Not below the shortest interval");
+    NS_TEST_EXPECT_MSG_EQ (RoutingProtocol::AdaptHelloInterval (Seconds (2), false, minInterval, maxInterval), Seconds (2.5),
+                           "Lengthened by a quarter otherwise");
+    NS_TEST_EXPECT_MSG_EQ (RoutingProtocol::AdaptHelloInterval (Seconds (4.5), false, minInterval, maxInterval), maxInterval,
+                           "Not above the longest interval");
+    NS_TEST_EXPECT_MSG_EQ (RoutingProtocol::GetHelloLifetime (Seconds (1), 2, Seconds (0)), Seconds (2),
+                           "AllowedHelloLoss intervals without adaptation");
+
+    // shrink to the shortest interval, grow to the cap, then shrink again
+    std::vector<bool> changes (2, true);
+    changes.resize (22, false);
+    changes.push_back (true);
+    changes.resize (30, false);
+    std::vector<Time> intervals (1, Seconds (1));
+    for (std::vector<bool>::const_iterator i = changes.begin (); i != changes.end (); ++i)
+      {
+        intervals.push_back (RoutingProtocol::AdaptHelloInterval (intervals.back (), *i, minInterval, maxInterval));
+      }
+    NS_TEST_EXPECT_MSG_EQ (intervals[2], minInterval, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (intervals[22], maxInterval, "trivial");
+    for (uint32_t k = 0; k + 2 < intervals.size (); k++)
+      {
+        // the neighbors receive hello k + 2 before hello k expires, if hello k + 1 is lost
+        NS_TEST_EXPECT_MSG_LT_OR_EQ (intervals[k] + intervals[k + 1],
+                                     RoutingProtocol::GetHelloLifetime (intervals[k], 2, maxInterval),
+                                     "A single lost hello does not break the link");
+        NS_TEST_EXPECT_MSG_LT_OR_EQ (intervals[k] + intervals[k + 1] + intervals[k + 2],
+                                     RoutingProtocol::GetHelloLifetime (intervals[k], 3, maxInterval),
+                                     "Nor two with AllowedHelloLoss 3");
+      }
+    NS_TEST_EXPECT_MSG_EQ (RoutingProtocol::GetHelloLifetime (maxInterval, 2, maxInterval), maxInterval + maxInterval,
+                           "No growth beyond the cap");
+
+    // the interval in use is traced under its own name, HelloInterval is the attribute
+    TypeId tid = RoutingProtocol::GetTypeId ();
+    NS_TEST_EXPECT_MSG_EQ ((PeekPointer (tid.LookupTraceSourceByName ("CurrentHelloInterval")) != 0), true, "Traced");
+    NS_TEST_EXPECT_MSG_EQ ((PeekPointer (tid.LookupTraceSourceByName ("HelloInterval")) == 0), true,
+                           "No trace source named after the attribute");
+  }
+};
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for the feature space of forwarder selection
+ */
+struct FeatureSpaceTest : public TestCase
+{
+  FeatureSpaceTest () : TestCase ("FeatureSpace")
+  {
+  }
+  virtual void DoRun ()
+  {
+    FeatureDescriptor d;
+    NS_TEST_EXPECT_MSG_EQ (d.Parse ("Weight=4|Normalization=FixedRange|Min=0|Max=10|Ideal=5"), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (d.m_normalization, NORMALIZE_FIXED_RANGE, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (d.Parse ("Weight=fast"), false, "Malformed value");
+    NS_TEST_EXPECT_MSG_EQ (d.Parse ("Speed=1"), false, "Unknown key");
+    NS_TEST_EXPECT_MSG_EQ (d.m_weight, 4, "Unchanged by a malformed string");
+    FeatureDescriptor d2;
+    NS_TEST_EXPECT_MSG_EQ (d2.Parse (d.ToString ()), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (d2.ToString (), d.ToString (), "Round trip");
+
+    FeatureSpace space;
+    space.SetDescriptor (FeatureSpace::FEATURE_DISTANCE, d);
+    FeatureDescriptor disabled;
+    disabled.m_enabled = false;
+    space.SetDescriptor (FeatureSpace::FEATURE_TX_ERROR, disabled);
+    FeatureDescriptor zscore;
+    NS_TEST_EXPECT_MSG_EQ (zscore.Parse ("Normalization=ZScore|Ideal=3"), true, "trivial");
+    space.SetDescriptor (FeatureSpace::FEATURE_FREE_SPACE, zscore);
+    NS_TEST_EXPECT_MSG_EQ (space.GetDimension (), 2, "One feature disabled");
+
+    std::vector<std::vector<double> > raw (2, std::vector<double> (FeatureSpace::FEATURE_COUNT, 0));
+    raw[0][FeatureSpace::FEATURE_DISTANCE] = 10;
+    raw[0][FeatureSpace::FEATURE_FREE_SPACE] = 1;
+    raw[1][FeatureSpace::FEATURE_FREE_SPACE] = 3;
+    std::vector<std::vector<double> > points;
+    std::vector<double> ideal;
+    space.Project (raw, points, ideal);
+    NS_TEST_EXPECT_MSG_EQ_TOL (points[0][0], 2, 1e-9, "Fixed range, scaled by the square root of the weight");
+    NS_TEST_EXPECT_MSG_EQ_TOL (ideal[0], 1, 1e-9, "Ideal projected the same way");
+    NS_TEST_EXPECT_MSG_EQ_TOL (points[0][1], -1, 1e-9, "Z-score");
+    NS_TEST_EXPECT_MSG_EQ_TOL (ideal[1], 1, 1e-9, "Z-score of the ideal");
+
+    // candidates with 0 and 4 free slots, the ideal buffer is empty
+    FeatureSpace defaults;
+    raw[0][FeatureSpace::FEATURE_FREE_SPACE] = 0;
+    raw[1][FeatureSpace::FEATURE_FREE_SPACE] = 4;
+    defaults.Project (raw, points, ideal);
+    NS_TEST_EXPECT_MSG_EQ (defaults.GetDimension (), 3, "Distance, tx errors and free space");
+    NS_TEST_EXPECT_MSG_EQ_TOL (points[1][2], 4.0 / 64, 1e-9, "Free space over the default buffer size");
+    NS_TEST_EXPECT_MSG_EQ_TOL (ideal[2], 1, 1e-9, "Ideal free space is the buffer size");
+    FeatureDescriptor minMax = defaults.GetDescriptor (FeatureSpace::FEATURE_FREE_SPACE);
+    NS_TEST_EXPECT_MSG_EQ (minMax.Parse ("Normalization=MinMax"), true, "trivial");
+    defaults.SetDescriptor (FeatureSpace::FEATURE_FREE_SPACE, minMax);
+    defaults.Project (raw, points, ideal);
+    NS_TEST_EXPECT_MSG_EQ_TOL (ideal[2], 1, 1e-9, "Ideal clamped to the observed range");
+    FeatureDescriptor snr = defaults.GetDescriptor (FeatureSpace::FEATURE_SNR);
+    snr.m_enabled = true;
+    defaults.SetDescriptor (FeatureSpace::FEATURE_SNR, snr);
+    raw[0][FeatureSpace::FEATURE_SNR] = 10;
+    raw[1][FeatureSpace::FEATURE_SNR] = 20;
+    defaults.Project (raw, points, ideal);
+    NS_TEST_EXPECT_MSG_EQ_TOL (ideal[3], 1, 1e-9, "Ideal SNR clamped to the strongest link");
+
+    // the free space follows the buffer size unless its range or ideal is configured
+    Ptr<RoutingProtocol> following = CreateObject<RoutingProtocol> ();
+    following->SetAttribute ("MaxQueueLen", UintegerValue (32));
+    FeatureDescriptor freeSpace;
+    NS_TEST_EXPECT_MSG_EQ (freeSpace.Parse (following->GetFreeSpaceFeature ()), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (freeSpace.m_max, 32, "Range follows the buffer size");
+    NS_TEST_EXPECT_MSG_EQ (freeSpace.m_ideal, 32, "Ideal follows the buffer size");
+    Ptr<RoutingProtocol> configured = CreateObject<RoutingProtocol> ();
+    configured->SetAttribute ("FreeSpaceFeature", StringValue ("Max=64|Ideal=64"));
+    configured->SetAttribute ("MaxQueueLen", UintegerValue (32));
+    NS_TEST_EXPECT_MSG_EQ (freeSpace.Parse (configured->GetFreeSpaceFeature ()), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (freeSpace.m_max, 64, "Configured range kept, even if equal to the old buffer size");
+    NS_TEST_EXPECT_MSG_EQ (freeSpace.m_ideal, 64, "Configured ideal kept");
+    Ptr<RoutingProtocol> idealOnly = CreateObject<RoutingProtocol> ();
+    idealOnly->SetAttribute ("FreeSpaceFeature", StringValue ("Ideal=16"));
+    idealOnly->SetAttribute ("MaxQueueLen", UintegerValue (32));
+    NS_TEST_EXPECT_MSG_EQ (freeSpace.Parse (idealOnly->GetFreeSpaceFeature ()), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (freeSpace.m_max, 32, "Range follows the buffer size");
+    NS_TEST_EXPECT_MSG_EQ (freeSpace.m_ideal, 16, "Configured ideal kept");
+  }
+};
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for the protocol statistics of a node
+ */
+struct StatsTest : public TestCase
+{
+  StatsTest () : TestCase ("Stats")
+  {
+  }
+  /**
+   * Wrap an aodvKmeans message in UDP and IP headers
+   * \param message the message, with its type header
+   * \returns the IP packet
+   */
+  Ptr<Packet> Wrap (Ptr<Packet> message)
+  {
+    UdpHeader udpHeader;
+    udpHeader.SetDestinationPort (RoutingProtocol::aodvKmeans_PORT);
+    message->AddHeader (udpHeader);
+    Ipv4Header ipHeader;
+    ipHeader.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+    ipHeader.SetPayloadSize (message->GetSize ());
+    message->AddHeader (ipHeader);
+    return message;
+  }
+  virtual void DoRun ()
+  {
+    Ptr<Packet> hello = Create<Packet> ();
+    hello->AddHeader (RrepHeader (0, 0, Ipv4Address ("10.0.0.1"), 1, Ipv4Address ("10.0.0.1"), Seconds (3)));
+    hello->AddHeader (TypeHeader (aodvKmeansTYPE_RREP));
+    Stats::ControlType type = Stats::CONTROL_RREQ;
+    NS_TEST_EXPECT_MSG_EQ (Stats::Classify (Wrap (hello), type), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (type, Stats::CONTROL_HELLO, "A reply to oneself is a hello");
+
+    Ptr<Packet> rrep = Create<Packet> ();
+    rrep->AddHeader (RrepHeader (0, 0, Ipv4Address ("10.0.0.1"), 1, Ipv4Address ("10.0.0.2"), Seconds (3)));
+    rrep->AddHeader (TypeHeader (aodvKmeansTYPE_RREP));
+    NS_TEST_EXPECT_MSG_EQ (Stats::Classify (Wrap (rrep), type), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (type, Stats::CONTROL_RREP, "trivial");
+
+    Ptr<Packet> data = Create<Packet> (100);
+    Ipv4Header ipHeader;
+    ipHeader.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+    data->AddHeader (UdpHeader ());
+    data->AddHeader (ipHeader);
+    NS_TEST_EXPECT_MSG_EQ (Stats::Classify (data, type), false, "Not a control packet");
+
+    Ptr<Stats> stats = CreateObject<Stats> ();
+    stats->RecordControl (Stats::CONTROL_HELLO, 60, true);
+    stats->RecordControl (Stats::CONTROL_HELLO, 60, true);
+    stats->RecordControl (Stats::CONTROL_RERR, 40, false);
+    NS_TEST_EXPECT_MSG_EQ (stats->GetTxPackets (Stats::CONTROL_HELLO), 2, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (stats->GetTxBytes (Stats::CONTROL_HELLO), 120, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (stats->GetRxBytes (Stats::CONTROL_RERR), 40, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (stats->GetRxPackets (Stats::CONTROL_HELLO), 0, "trivial");
+
+    std::ostringstream header;
+    std::ostringstream line;
+    Stats::PrintCsvHeader (header);
+    stats->PrintCsv (line, 7);
+    std::string columns = header.str ();
+    std::string values = line.str ();
+    NS_TEST_EXPECT_MSG_EQ (std::count (columns.begin (), columns.end (), ','),
+                           std::count (values.begin (), values.end (), ','), "One value per column");
+    NS_TEST_EXPECT_MSG_NE (columns.find (",clusteredDiscoveries,floodedDiscoveries,"), std::string::npos,
+                           "Route discoveries, not RREQ transmissions");
+    stats->Reset ();
+    NS_TEST_EXPECT_MSG_EQ (stats->GetTxPackets (Stats::CONTROL_HELLO), 0, "trivial");
+  }
+};
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for LatencyHistogram
+ */
+struct LatencyHistogramTest : public TestCase
+{
+  LatencyHistogramTest () : TestCase ("LatencyHistogram")
+  {
+  }
+  virtual void DoRun ()
+  {
+    LatencyHistogram h;
+    NS_TEST_EXPECT_MSG_EQ (h.GetPercentile (0.5), Seconds (0), "No samples");
+    for (uint32_t i = 1; i <= 100; i++)
+      {
+        h.Add (MilliSeconds (i));
+      }
+    NS_TEST_EXPECT_MSG_EQ (h.GetCount (), 100, "trivial");
+    NS_TEST_EXPECT_MSG_EQ_TOL (h.GetPercentile (0.5).GetSeconds (), 0.050, 0.005, "Within a bucket");
+    NS_TEST_EXPECT_MSG_EQ_TOL (h.GetPercentile (0.99).GetSeconds (), 0.099, 0.01, "Within a bucket");
+    NS_TEST_EXPECT_MSG_EQ (h.GetPercentile (0.95) <= h.GetPercentile (0.99), true, "Monotonic");
+
+    LatencyHistogram other;
+    other.Add (Seconds (10));
+    h.Merge (other);
+    NS_TEST_EXPECT_MSG_EQ (h.GetCount (), 101, "trivial");
+    NS_TEST_EXPECT_MSG_EQ_TOL (h.GetPercentile (1).GetSeconds (), 10, 1, "Largest sample");
+    h.Clear ();
+    NS_TEST_EXPECT_MSG_EQ (h.GetCount (), 0, "trivial");
+  }
+};
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for EventAccounting
+ */
+struct EventAccountingTest : public TestCase
+{
+  EventAccountingTest () : TestCase ("EventAccounting")
+  {
+  }
+  virtual void DoRun ()
+  {
+    EventAccounting events;
+    events.Scheduled (EventAccounting::EVENT_SEND_MEMBER);
+    events.Scheduled (EventAccounting::EVENT_SEND_MEMBER);
+    events.Scheduled (EventAccounting::EVENT_HELLO_TIMER);
+    events.Executed (EventAccounting::EVENT_SEND_MEMBER);
+    events.Cancelled (EventAccounting::EVENT_HELLO_TIMER);
+    events.Scheduled (EventAccounting::EVENT_HELLO_TIMER);
+    NS_TEST_EXPECT_MSG_EQ (events.GetScheduled (EventAccounting::EVENT_SEND_MEMBER), 2, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (events.GetExecuted (EventAccounting::EVENT_SEND_MEMBER), 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (events.GetCancelled (EventAccounting::EVENT_HELLO_TIMER), 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (events.GetPending (EventAccounting::EVENT_SEND_MEMBER), 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (events.GetPeakPending (EventAccounting::EVENT_SEND_MEMBER), 2, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (events.GetPeakPending (EventAccounting::EVENT_HELLO_TIMER), 1, "Rescheduled after cancel");
+    NS_TEST_EXPECT_MSG_EQ (events.GetPeakPending (), 3, "Peak over all kinds");
+
+    events.Reset ();
+    NS_TEST_EXPECT_MSG_EQ (events.GetScheduled (EventAccounting::EVENT_SEND_MEMBER), 0, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (events.GetPeakPending (), 2, "Peak restarts from the pending events");
+    events.Executed (EventAccounting::EVENT_SEND_MEMBER);
+    events.Executed (EventAccounting::EVENT_SEND_MEMBER);
+    NS_TEST_EXPECT_MSG_EQ (events.GetPending (EventAccounting::EVENT_SEND_MEMBER), 0, "Never negative");
+  }
+};
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for RingBuffer
+ */
+struct RingBufferTest : public TestCase
+{
+  RingBufferTest () : TestCase ("RingBuffer")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RingBuffer<uint32_t> ring (3);
+    NS_TEST_EXPECT_MSG_EQ (ring.GetCapacity (), 3, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (ring.GetSize (), 0, "trivial");
+    for (uint32_t i = 1; i <= 5; i++)
+      {
+        ring.Push (i);
+      }
+    NS_TEST_EXPECT_MSG_EQ (ring.GetSize (), 3, "Bounded by the capacity");
+    NS_TEST_EXPECT_MSG_EQ (ring.Get (0), 3, "Oldest items overwritten");
+    NS_TEST_EXPECT_MSG_EQ (ring.Get (2), 5, "trivial");
+
+    ring.SetCapacity (0);
+    ring.Push (6);
+    NS_TEST_EXPECT_MSG_EQ (ring.GetSize (), 0, "Nothing kept without capacity");
+  }
+};
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for the RequestQueue occupancy samples
+ */
+struct QueueSampleTest : public TestCase
+{
+  QueueSampleTest () : TestCase ("QueueSample"),
+                       q (8, Seconds (30)),
+                       departures (0)
+  {
+  }
+  virtual void DoRun ();
+  /**
+   * Unicast test function
+   * \param route the IPv4 route
+   * \param packet the packet
+   * \param header the IPv4 header
+   */
+  void Unicast (Ptr<Ipv4Route> route, Ptr<const Packet> packet, const Ipv4Header & header)
+  {
+  }
+  /**
+   * Error test function
+   * \param p The packet
+   * \param h The header
+   * \param e the socket error
+   */
+  void Error (Ptr<const Packet> p, const Ipv4Header & h, Socket::SocketErrno e)
+  {
+  }
+  /**
+   * Sojourn test function
+   * \param p The packet
+   * \param h The header
+   * \param sojourn the time spent in the queue
+   * \param dropped whether the packet was dropped
+   */
+  void Sojourn (Ptr<const Packet> p, const Ipv4Header & h, Time sojourn, bool dropped)
+  {
+    departures++;
+    lastSojourn = sojourn;
+  }
+  /// Dequeue one packet and sample the occupancy
+  void CheckSample ();
+
+  /// Request queue
+  RequestQueue q;
+  /// Number of sojourn notifications
+  uint32_t departures;
+  /// Last notified sojourn time
+  Time lastSojourn;
+};
+
+void
+QueueSampleTest::DoRun ()
+{
+  q.SetSojournCallback (MakeCallback (&QueueSampleTest::Sojourn, this));
+  q.SetSampleCapacity (4);
+  Ptr<const Packet> packet = Create<Packet> ();
+  Ipv4Header h;
+  Ipv4RoutingProtocol::UnicastForwardCallback ucb = MakeCallback (&QueueSampleTest::Unicast, this);
+  Ipv4RoutingProtocol::ErrorCallback ecb = MakeCallback (&QueueSampleTest::Error, this);
+  h.SetDestination (Ipv4Address ("1.1.1.1"));
+  QueueEntry e1 (packet, h, ucb, ecb);
+  q.Enqueue (e1);
+  h.SetDestination (Ipv4Address ("2.2.2.2"));
+  QueueEntry e2 (packet, h, ucb, ecb);
+  q.Enqueue (e2);
+
+  Simulator::Schedule (Seconds (2), &QueueSampleTest::CheckSample, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+QueueSampleTest::CheckSample ()
+{
+  Ptr<const Packet> packet = Create<Packet> ();
+  Ipv4Header h;
+  QueueEntry entry (packet, h);
+  NS_TEST_EXPECT_MSG_EQ (q.Dequeue (Ipv4Address ("1.1.1.1"), entry), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (departures, 1, "Dequeue notified");
+  NS_TEST_EXPECT_MSG_EQ (lastSojourn, Seconds (2), "Time since enqueue");
+
+  QueueSample sample = q.SampleOccupancy ();
+  NS_TEST_EXPECT_MSG_EQ (sample.m_length, 1, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (sample.m_dequeued, 1, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (sample.m_dropped, 0, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (sample.m_meanSojourn, Seconds (2), "trivial");
+  NS_TEST_EXPECT_MSG_EQ (q.GetSamples ().GetSize (), 1, "Sample kept");
+
+  q.DropPacketWithDst (Ipv4Address ("2.2.2.2"));
+  sample = q.SampleOccupancy ();
+  NS_TEST_EXPECT_MSG_EQ (sample.m_length, 0, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (sample.m_dequeued, 0, "Counters restart at each sample");
+  NS_TEST_EXPECT_MSG_EQ (sample.m_dropped, 1, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (departures, 2, "Drop notified");
+}
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for EventLog, EventLogReader and the route change notifications
+ */
+struct EventLogTest : public TestCase
+{
+  EventLogTest () : TestCase ("EventLog"),
+                    changes (0),
+                    lastValid (false)
+  {
+  }
+  /**
+   * Route change test function
+   * \param route the routing table entry
+   * \param valid whether it became valid
+   */
+  void RouteChange (RoutingTableEntry const & route, bool valid)
+  {
+    changes++;
+    lastValid = valid;
+  }
+  virtual void DoRun ();
+
+  /// Number of route changes notified
+  uint32_t changes;
+  /// Last route change notified
+  bool lastValid;
+};
+
+void
+EventLogTest::DoRun ()
+{
+  Ptr<NetDevice> dev;
+  Ipv4InterfaceAddress iface;
+  RoutingTable rtable (Seconds (2));
+  rtable.SetChangeCallback (MakeCallback (&EventLogTest::RouteChange, this));
+  RoutingTableEntry rt (/*output device*/ dev, /*dst*/ Ipv4Address ("10.0.0.9"), /*validSeqNo*/ true, /*seqNo*/ 7,
+                                          /*interface*/ iface, /*hop*/ 2, /*next hop*/ Ipv4Address ("10.0.0.2"), /*lifetime*/ Seconds (10));
+  rtable.AddRoute (rt);
+  NS_TEST_EXPECT_MSG_EQ (changes, 1, "New valid route");
+  NS_TEST_EXPECT_MSG_EQ (lastValid, true, "trivial");
+  rtable.Update (rt);
+  NS_TEST_EXPECT_MSG_EQ (changes, 1, "Unchanged next hop");
+  std::map<Ipv4Address, uint32_t> unreachable;
+  unreachable.insert (std::make_pair (Ipv4Address ("10.0.0.9"), 8));
+  rtable.InvalidateRoutesWithDst (unreachable);
+  NS_TEST_EXPECT_MSG_EQ (changes, 2, "Route invalidated");
+  NS_TEST_EXPECT_MSG_EQ (lastValid, false, "trivial");
+
+  std::string filename = CreateTempDirFilename ("aodvKmeans-events.bin");
+  Ptr<EventLog> log = CreateObject<EventLog> ();
+  NS_TEST_ASSERT_MSG_EQ (log->Open (filename), true, "trivial");
+
+  Ptr<Packet> hello = Create<Packet> ();
+  hello->AddHeader (RrepHeader (0, 0, Ipv4Address ("10.0.0.1"), 1, Ipv4Address ("10.0.0.1"), Seconds (3)));
+  hello->AddHeader (TypeHeader (aodvKmeansTYPE_RREP));
+  uint32_t helloSize = hello->GetSize ();
+  UdpHeader udpHeader;
+  udpHeader.SetDestinationPort (RoutingProtocol::aodvKmeans_PORT);
+  hello->AddHeader (udpHeader);
+  Ipv4Header ipHeader;
+  ipHeader.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+  ipHeader.SetSource (Ipv4Address ("10.0.0.1"));
+  ipHeader.SetDestination (Ipv4Address ("10.0.0.255"));
+  ipHeader.SetTtl (1);
+  ipHeader.SetPayloadSize (hello->GetSize ());
+  hello->AddHeader (ipHeader);
+  NS_TEST_EXPECT_MSG_EQ (log->WriteControl (3, true, hello), true, "trivial");
+
+  Ptr<Packet> data = Create<Packet> (100);
+  data->AddHeader (UdpHeader ());
+  data->AddHeader (ipHeader);
+  NS_TEST_EXPECT_MSG_EQ (log->WriteControl (3, false, data), false, "Not a control packet");
+
+  log->WriteRoute (3, rt, true);
+  std::vector<Ipv4Address> forwarders;
+  forwarders.push_back (Ipv4Address ("10.0.0.2"));
+  forwarders.push_back (Ipv4Address ("10.0.0.4"));
+  log->WriteCluster (3, Ipv4Address ("10.0.0.9"), 5, forwarders);
+  NS_TEST_EXPECT_MSG_EQ (log->GetRecords (), 3, "trivial");
+  log->Close ();
+
+  EventLogReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (filename), true, "trivial");
+  EventLogRecord record;
+  NS_TEST_ASSERT_MSG_EQ (reader.Read (record), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_type, EventLog::RECORD_CONTROL_TX, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_node, 3, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_source, Ipv4Address ("10.0.0.1"), "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_destination, Ipv4Address ("10.0.0.255"), "trivial");
+  NS_TEST_EXPECT_MSG_EQ (uint32_t (record.m_ttl), 1, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_message->GetSize (), helloSize, "Message in its wire format");
+  TypeHeader tHeader;
+  record.m_message->RemoveHeader (tHeader);
+  NS_TEST_EXPECT_MSG_EQ (tHeader.Get (), aodvKmeansTYPE_RREP, "trivial");
+  RrepHeader rrepHeader;
+  record.m_message->RemoveHeader (rrepHeader);
+  NS_TEST_EXPECT_MSG_EQ (rrepHeader.GetOrigin (), Ipv4Address ("10.0.0.1"), "trivial");
+
+  NS_TEST_ASSERT_MSG_EQ (reader.Read (record), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_type, EventLog::RECORD_ROUTE_VALID, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_dst, Ipv4Address ("10.0.0.9"), "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_nextHop, Ipv4Address ("10.0.0.2"), "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_seqNo, 7, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_hops, 2, "trivial");
+
+  NS_TEST_ASSERT_MSG_EQ (reader.Read (record), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_type, EventLog::RECORD_CLUSTER, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_candidates, 5, "trivial");
+  NS_TEST_ASSERT_MSG_EQ (record.m_forwarders.size (), 2, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (record.m_forwarders[1], Ipv4Address ("10.0.0.4"), "trivial");
+  NS_TEST_EXPECT_MSG_EQ (reader.Read (record), false, "End of the log");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for MemoryUsage and the memory estimates of the data structures
+ */
+struct MemoryUsageTest : public TestCase
+{
+  MemoryUsageTest () : TestCase ("MemoryUsage")
+  {
+  }
+  virtual void DoRun ()
+  {
+    std::vector<uint32_t> v;
+    v.reserve (10);
+    NS_TEST_EXPECT_MSG_EQ (MemoryBytes (v), 10 * sizeof (uint32_t), "Capacity counted");
+    std::map<Ipv4Address, uint32_t> m;
+    m[Ipv4Address ("10.0.0.1")] = 1;
+    m[Ipv4Address ("10.0.0.2")] = 2;
+    NS_TEST_EXPECT_MSG_EQ (MemoryBytes (m), 2 * (sizeof (std::pair<const Ipv4Address, uint32_t>) + MEMORY_TREE_LINKS),
+                           "trivial");
+
+    Ptr<NetDevice> dev;
+    Ipv4InterfaceAddress iface;
+    RoutingTable rtable (Seconds (2));
+    NS_TEST_EXPECT_MSG_EQ (rtable.GetMemoryBytes (), 0, "Empty table");
+    RoutingTableEntry rt (/*output device*/ dev, /*dst*/ Ipv4Address ("10.0.0.9"), /*validSeqNo*/ true, /*seqNo*/ 7,
+                                            /*interface*/ iface, /*hop*/ 2, /*next hop*/ Ipv4Address ("10.0.0.2"), /*lifetime*/ Seconds (10));
+    rt.InsertPrecursor (Ipv4Address ("10.0.0.3"));
+    rtable.AddRoute (rt);
+    NS_TEST_EXPECT_MSG_GT (rtable.GetMemoryBytes (), 0, "trivial");
+    NS_TEST_EXPECT_MSG_GT_OR_EQ (rtable.GetPrecursorMemoryBytes (), sizeof (Ipv4Address), "trivial");
+
+    MemoryUsage usage;
+    usage.Add (MemoryUsage::MEMORY_ROUTING_TABLE, rtable.GetMemoryBytes ());
+    usage.Add (MemoryUsage::MEMORY_PRECURSORS, rtable.GetPrecursorMemoryBytes ());
+    usage.Add (MemoryUsage::MEMORY_NEIGHBORS, 100);
+    usage.Add (MemoryUsage::MEMORY_NEIGHBORS, 20);
+    NS_TEST_EXPECT_MSG_EQ (usage.GetBytes (MemoryUsage::MEMORY_NEIGHBORS), 120, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (usage.GetTotalBytes (), rtable.GetMemoryBytes () + rtable.GetPrecursorMemoryBytes () + 120,
+                           "trivial");
+
+    std::ostringstream os;
+    usage.Print (os, 4);
+    std::string lines = os.str ();
+    NS_TEST_EXPECT_MSG_EQ (std::count (lines.begin (), lines.end (), '\n'), MemoryUsage::MEMORY_COMPONENT_COUNT + 1,
+                           "A line per data structure and the total");
+    Simulator::Destroy ();
+  }
+};
+
+/**
+ * \ingroup aodvKmeans-test
+ * \ingroup tests
+ *
+ * \brief Unit test for LruCache
+ */
+struct LruCacheTest : public TestCase
+{
+  LruCacheTest () : TestCase ("LruCache")
+  {
+  }
+  /**
+   * \param timer a timer
+   * \returns true if the timer is not running
+   */
+  static bool IsIdle (Timer const & timer)
+  {
+    return !timer.IsRunning ();
+  }
+  /// Does nothing, function of the test timers
+  static void Nothing ()
+  {
+  }
+  virtual void DoRun ()
+  {
+    LruCache<Ipv4Address, uint32_t, Ipv4AddressHash> cache (2);
+    cache.Put (Ipv4Address ("10.0.0.1"), 1);
+    cache.Put (Ipv4Address ("10.0.0.2"), 2);
+    NS_TEST_EXPECT_MSG_EQ (*cache.Find (Ipv4Address ("10.0.0.1")), 1, "trivial");
+    cache.Put (Ipv4Address ("10.0.0.3"), 3);
+    NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 2, "Bounded");
+    NS_TEST_EXPECT_MSG_EQ ((cache.Find (Ipv4Address ("10.0.0.2")) == 0), true, "Least recently used evicted");
+    NS_TEST_EXPECT_MSG_EQ (cache.GetEvictions (), 1, "Eviction counted");
+    NS_TEST_EXPECT_MSG_EQ (cache.Begin ()->first, Ipv4Address ("10.0.0.3"), "Most recently used first");
+    NS_TEST_EXPECT_MSG_EQ (cache.Get (Ipv4Address ("10.0.0.4")), 0, "Default value");
+    NS_TEST_EXPECT_MSG_EQ ((cache.Find (Ipv4Address ("10.0.0.1")) == 0), true, "Least recently used evicted");
+    NS_TEST_EXPECT_MSG_EQ (cache.Erase (Ipv4Address ("10.0.0.4")), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (cache.Erase (Ipv4Address ("10.0.0.4")), false, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (cache.GetEvictions (), 2, "Erasures not counted");
+    cache.SetCapacity (0);
+    NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 0, "Evicted down to the capacity");
+
+    LruCache<Ipv4Address, Timer, Ipv4AddressHash> timers (1);
+    timers.SetEvictable (&LruCacheTest::IsIdle);
+    Timer & running = timers.Get (Ipv4Address ("10.0.0.1"));
+    running = Timer (Timer::CANCEL_ON_DESTROY);
+    running.SetFunction (&LruCacheTest::Nothing);
+    running.Schedule (Seconds (1));
+    timers.Get (Ipv4Address ("10.0.0.2")) = Timer (Timer::CANCEL_ON_DESTROY);
+    NS_TEST_EXPECT_MSG_EQ (timers.GetSize (), 2, "Running timer kept beyond the capacity");
+    NS_TEST_EXPECT_MSG_EQ (timers.GetEvictions (), 0, "trivial");
+    timers.Get (Ipv4Address ("10.0.0.3")) = Timer (Timer::CANCEL_ON_DESTROY);
+    NS_TEST_EXPECT_MSG_EQ ((timers.Find (Ipv4Address ("10.0.0.2")) == 0), true, "Idle timer evicted");
+    NS_TEST_EXPECT_MSG_EQ (timers.Find (Ipv4Address ("10.0.0.1"))->IsRunning (), true, "trivial");
+    timers.Clear ();
+    Simulator::Destroy ();
+  }
+};
+
 /**
  * \ingroup aodvKmeans-test
  * \ingroup tests
@@ -653,15 +2371,35 @@ public:
   aodvKmeansTestSuite () : TestSuite ("routing-aodvKmeans", UNIT)
   {
     AddTestCase (new NeighborTest, TestCase::QUICK);
+    AddTestCase (new NeighborIndexTest, TestCase::QUICK);
     AddTestCase (new TypeHeaderTest, TestCase::QUICK);
     AddTestCase (new RreqHeaderTest, TestCase::QUICK);
     AddTestCase (new RrepHeaderTest, TestCase::QUICK);
+    AddTestCase (new RrepCompactHeaderTest, TestCase::QUICK);
     AddTestCase (new RrepAckHeaderTest, TestCase::QUICK);
     AddTestCase (new RerrHeaderTest, TestCase::QUICK);
     AddTestCase (new QueueEntryTest, TestCase::QUICK);
     AddTestCase (new aodvKmeansRqueueTest, TestCase::QUICK);
+    AddTestCase (new aodvKmeansRqueueFairTest, TestCase::QUICK);
+    AddTestCase (new DpdBloomTest, TestCase::QUICK);
+    AddTestCase (new LinkQualityTest, TestCase::QUICK);
+    AddTestCase (new LocationCacheTest, TestCase::QUICK);
     AddTestCase (new aodvKmeansRtableEntryTest, TestCase::QUICK);
     AddTestCase (new aodvKmeansRtableTest, TestCase::QUICK);
+    AddTestCase (new aodvKmeansRtableKmeansTest, TestCase::QUICK);
+    AddTestCase (new FeatureSpaceTest, TestCase::QUICK);
+    AddTestCase (new StatsTest, TestCase::QUICK);
+    AddTestCase (new LatencyHistogramTest, TestCase::QUICK);
+    AddTestCase (new EventAccountingTest, TestCase::QUICK);
+    AddTestCase (new RingBufferTest, TestCase::QUICK);
+    AddTestCase (new QueueSampleTest, TestCase::QUICK);
+    AddTestCase (new EventLogTest, TestCase::QUICK);
+    AddTestCase (new MemoryUsageTest, TestCase::QUICK);
+    AddTestCase (new LruCacheTest, TestCase::QUICK);
+    AddTestCase (new HelloIntervalTest, TestCase::QUICK);
+    AddTestCase (new ChannelLoadTest, TestCase::QUICK);
+    AddTestCase (new LinkSnrTest, TestCase::QUICK);
+    AddTestCase (new DiscoveryTraceTest, TestCase::QUICK);
   }
 } g_aodvKmeansTestSuite; ///< the test suite
 
@@ -79,6 +79,10 @@ private:
     bool m_printRoutes;
     // move clients away after 1/2 of simulation
     bool m_moveClients;
+    // write ascii traces of the PHY and IPv4 layers if true
+    bool m_asciiTrace;
+    // write a binary log of the aodvKmeans control plane if true
+    bool m_eventLog;
     
     // total sent packets
     int m_packetsSent;
@@ -151,6 +155,8 @@ AODVExample::AODVExample():
     m_traceMobility(false),
     m_printRoutes(false),
     m_moveClients(false),
+    m_asciiTrace(true),
+    m_eventLog(false),
     m_packetsSent(0),
     m_packetsReceived(0),
     m_packetsDropped(0),
@@ -177,6 +183,8 @@ AODVExample::CommandSetUp(int argc, char *argv[])
     cmd.AddValue("prefix", "Prefix of all generated file names\n", m_prefix);
     cmd.AddValue("packetsPerSecond", "Packets Sent per second", m_packets_per_second);
     cmd.AddValue("protocol", "Protocol to use 1: AODV With KMeans 2: Only AODV", m_protocol);
+    cmd.AddValue("asciiTrace", "Enable ascii tracing of the PHY and IPv4 layers", m_asciiTrace);
+    cmd.AddValue("eventLog", "Enable the binary log of the aodvKmeans control plane", m_eventLog);
     
     cmd.Parse (argc, argv);
     return;
@@ -394,8 +402,11 @@ AODVExample::CreateDevices()
 
             
 
-    AsciiTraceHelper ascii;
-    wifiPhy.EnableAsciiAll(ascii.CreateFileStream(m_prefix + "-phy.tr"));
+    if(m_asciiTrace)
+    {
+        AsciiTraceHelper ascii;
+        wifiPhy.EnableAsciiAll(ascii.CreateFileStream(m_prefix + "-phy.tr"));
+    }
   
     std::cout << "devices created\n"; 
 
@@ -429,8 +440,15 @@ AODVExample::CreateInternetStacks()
     interfaces = addressHelper.Assign(devices);
 
 
-    AsciiTraceHelper ascii;
-    internet.EnableAsciiIpv4All(ascii.CreateFileStream(m_prefix + "-ipv4.tr"));
+    if(m_asciiTrace)
+    {
+        AsciiTraceHelper ascii;
+        internet.EnableAsciiIpv4All(ascii.CreateFileStream(m_prefix + "-ipv4.tr"));
+    }
+    if(m_eventLog && m_protocol == 1)
+    {
+        aodvKmeansHelper::EnableEventLogAll(m_prefix + "-events.bin");
+    }
     
 
 